@@ -0,0 +1,693 @@
+#ifndef AABBTREE_H
+#define AABBTREE_H
+
+#include "aamath.h"
+#include "vec3.h"
+#include "collision.h"
+
+namespace aam {
+
+// NOTE: Incremental AABB tree for moving objects (broadphase). Each object is a
+//       leaf (proxy) holding a fattened box, grown by the margin and stretched
+//       along the last displacement. Move() does nothing while the object stays
+//       inside its fat box; otherwise the leaf is removed and reinserted by the
+//       surface area heuristic, with tree rotations on the way back up that
+//       keep the tree compact as objects move. The rotations also keep the
+//       heights of every node's children within AABBTREE_MAX_IMBALANCE of
+//       each other (a looser AVL tree), so coincident or nested boxes cannot
+//       chain the tree. Nodes live in a pool with a free list, and proxy ids
+//       are node indices that stay valid until Remove(). Inserted and
+//       reinserted proxies go on a move buffer, and FindPairs() only queries
+//       those. All memory is owned by the caller, see AABBTreeMemorySize().
+
+#define AABBTREE_NULL           0xFFFFFFFF
+// NOTE: Largest height difference between two siblings. 1 is a strict AVL
+//       balance, but leaves the surface area rotations too little room:
+//       queries on 50k random boxes are about 3x slower than with 4.
+#define AABBTREE_MAX_IMBALANCE  4
+// NOTE: Query stack size. With siblings at most 4 apart the height stays
+//       under about 2.5 log2 of the proxy count, at most 77 for any u32
+//       count, and a query never holds more than height + 1 nodes.
+#define AABBTREE_MAX_DEPTH      128
+
+// NOTE: How far ahead of its motion a moved proxy's fat box reaches, in units
+//       of the displacement passed to Move()
+#ifndef AABBTREE_DISPLACEMENT_SCALE
+#define AABBTREE_DISPLACEMENT_SCALE 4.0f
+#endif
+
+typedef struct _aabbtreenode
+{
+    aabb bounds;        // NOTE: Fat box for leaves
+    u32 parent,         // NOTE: Next free node while on the free list
+        left,
+        right,          // NOTE: AABBTREE_NULL for leaves
+        userData;
+    s32 height;         // NOTE: 0 for leaves, -1 for free nodes
+    b32 moved;          // NOTE: On the move buffer
+} aabbtreenode;
+
+typedef struct _aabbtree
+{
+    aabbtreenode *nodes;
+    u32 *moveBuffer;
+    u32 capacity,
+        root,
+        freeList,
+        proxyCount,
+        moveCount,
+        maxProxies;
+    r32 margin;
+} aabbtree;
+
+typedef struct _aabbtreepair
+{
+    u32 a, b;       // NOTE: userData of the two proxies, a <= b
+} aabbtreepair;
+
+// NOTE: Nodes for maxProxies leaves and their interior nodes
+inline u32 AABBTreeNodeCapacity(u32 maxProxies)
+{
+    return (maxProxies > 0) ? 2 * maxProxies - 1 : 1;
+}
+
+// NOTE: Bytes of 16-byte aligned memory InitAABBTree needs
+inline u64 AABBTreeMemorySize(u32 maxProxies)
+{
+    return (u64)AABBTreeNodeCapacity(maxProxies) * sizeof(aabbtreenode) + (u64)maxProxies * sizeof(u32);
+}
+
+// NOTE: margin is added on every side of the boxes given to Insert/Move
+inline void InitAABBTree(aabbtree &tree, void *memory, u32 maxProxies, r32 margin)
+{
+    AAM_Assert(memory && ((u64)memory & 15) == 0);
+    AAM_Assert(margin >= 0.0f);
+
+    tree.capacity = AABBTreeNodeCapacity(maxProxies);
+    tree.nodes = (aabbtreenode *)memory;
+    tree.moveBuffer = (u32 *)(tree.nodes + tree.capacity);
+    tree.root = AABBTREE_NULL;
+    tree.freeList = 0;
+    tree.proxyCount = 0;
+    tree.moveCount = 0;
+    tree.maxProxies = maxProxies;
+    tree.margin = margin;
+
+    for(u32 i = 0; i < tree.capacity; ++i)
+    {
+        tree.nodes[i].parent = (i + 1 < tree.capacity) ? i + 1 : AABBTREE_NULL;
+        tree.nodes[i].height = -1;
+        tree.nodes[i].moved = false;
+    }
+}
+
+inline u32 AABBTreeAllocateNode(aabbtree &tree)
+{
+    AAM_Assert(tree.freeList != AABBTREE_NULL);
+
+    u32 index = tree.freeList;
+    aabbtreenode &node = tree.nodes[index];
+
+    tree.freeList = node.parent;
+    node.parent = AABBTREE_NULL;
+    node.left = AABBTREE_NULL;
+    node.right = AABBTREE_NULL;
+    node.userData = AABBTREE_NULL;
+    node.height = 0;
+    node.moved = false;
+
+    return index;
+}
+
+inline void AABBTreeFreeNode(aabbtree &tree, u32 index)
+{
+    aabbtreenode &node = tree.nodes[index];
+
+    node.parent = tree.freeList;
+    node.height = -1;
+    node.moved = false;
+    tree.freeList = index;
+}
+
+// NOTE: Recomputes the height and bounds of an interior node from its
+//       children, returns false when neither changed
+inline b32 AABBTreeFix(aabbtree &tree, u32 index)
+{
+    aabbtreenode &node = tree.nodes[index];
+    const aabbtreenode &left = tree.nodes[node.left],
+                       &right = tree.nodes[node.right];
+
+    s32 height = 1 + ((left.height > right.height) ? left.height : right.height);
+    aabb bounds = Union(left.bounds, right.bounds);
+
+    // NOTE: Exact compares, the vec3 != is within epsilon and would let
+    //       small growths stop the refit below ancestors that miss them
+    b32 result = (height != node.height);
+
+    for(u32 i = 0; i < 3; ++i)
+    {
+        result |= (bounds.min.E[i] != node.bounds.min.E[i]) | (bounds.max.E[i] != node.bounds.max.E[i]);
+    }
+
+    node.height = height;
+    node.bounds = bounds;
+
+    return result;
+}
+
+// NOTE: Exchanges two subtrees with different parents, then refits those
+//       parents unless one of them is a (the caller refits a)
+inline void AABBTreeSwap(aabbtree &tree, u32 a, u32 x, u32 y)
+{
+    aabbtreenode *nodes = tree.nodes;
+    u32 px = nodes[x].parent,
+        py = nodes[y].parent;
+
+    if(nodes[px].left == x)
+        nodes[px].left = y;
+    else
+        nodes[px].right = y;
+
+    if(nodes[py].left == y)
+        nodes[py].left = x;
+    else
+        nodes[py].right = x;
+
+    nodes[x].parent = py;
+    nodes[y].parent = px;
+
+    if(px != a)
+        AABBTreeFix(tree, px);
+    if(py != a)
+        AABBTreeFix(tree, py);
+}
+
+inline b32 AABBTreeBalanced(s32 heightA, s32 heightB)
+{
+    return (heightA - heightB <= AABBTREE_MAX_IMBALANCE) && (heightB - heightA <= AABBTREE_MAX_IMBALANCE);
+}
+
+inline s32 AABBTreeParentHeight(s32 heightA, s32 heightB)
+{
+    return 1 + ((heightA > heightB) ? heightA : heightB);
+}
+
+// NOTE: Tree rotation at a (Kopta et al.): swaps a child with a grandchild on
+//       the other side, or two grandchildren, when that lowers the surface
+//       area of a's children the most. The leaves under a stay the same, so
+//       only the heights and the bounds below a change. Unbalanced children
+//       take the height-balancing swap instead (the shorter child with the
+//       taller grandchild on the other side), and the area swaps are only
+//       taken when they leave a and the nodes below it balanced.
+inline void AABBTreeRotate(aabbtree &tree, u32 a)
+{
+    aabbtreenode *nodes = tree.nodes;
+
+    if(nodes[a].height < 2)
+        return;
+
+    u32 b = nodes[a].left,
+        c = nodes[a].right;
+    const aabbtreenode &B = nodes[b],
+                       &C = nodes[c];
+    s32 hB = B.height,
+        hC = C.height;
+
+    if(!AABBTreeBalanced(hB, hC))
+    {
+        u32 shorter = (hB < hC) ? b : c,
+            taller = (hB < hC) ? c : b;
+        const aabbtreenode &T = nodes[taller];
+
+        AABBTreeSwap(tree, a, shorter, (nodes[T.left].height > nodes[T.right].height) ? T.left : T.right);
+        AABBTreeFix(tree, a);
+        return;
+    }
+
+    r32 areaB = SurfaceArea(B.bounds),
+        areaC = SurfaceArea(C.bounds),
+        bestGain = 0.0f;
+    u32 x = AABBTREE_NULL,
+        y = AABBTREE_NULL;
+
+    if(C.left != AABBTREE_NULL)
+    {
+        u32 f = C.left,
+            g = C.right;
+        s32 hF = nodes[f].height,
+            hG = nodes[g].height;
+        r32 gainF = areaC - SurfaceArea(Union(B.bounds, nodes[g].bounds)),
+            gainG = areaC - SurfaceArea(Union(B.bounds, nodes[f].bounds));
+
+        if(gainF > bestGain && AABBTreeBalanced(hB, hG) && AABBTreeBalanced(hF, AABBTreeParentHeight(hB, hG)))
+        {
+            bestGain = gainF; x = b; y = f;
+        }
+        if(gainG > bestGain && AABBTreeBalanced(hB, hF) && AABBTreeBalanced(hG, AABBTreeParentHeight(hB, hF)))
+        {
+            bestGain = gainG; x = b; y = g;
+        }
+    }
+
+    if(B.left != AABBTREE_NULL)
+    {
+        u32 d = B.left,
+            e = B.right;
+        s32 hD = nodes[d].height,
+            hE = nodes[e].height;
+        r32 gainD = areaB - SurfaceArea(Union(C.bounds, nodes[e].bounds)),
+            gainE = areaB - SurfaceArea(Union(C.bounds, nodes[d].bounds));
+
+        if(gainD > bestGain && AABBTreeBalanced(hC, hE) && AABBTreeBalanced(hD, AABBTreeParentHeight(hC, hE)))
+        {
+            bestGain = gainD; x = c; y = d;
+        }
+        if(gainE > bestGain && AABBTreeBalanced(hC, hD) && AABBTreeBalanced(hE, AABBTreeParentHeight(hC, hD)))
+        {
+            bestGain = gainE; x = c; y = e;
+        }
+
+        if(C.left != AABBTREE_NULL)
+        {
+            u32 f = C.left,
+                g = C.right;
+            s32 hF = nodes[f].height,
+                hG = nodes[g].height;
+            const aabb &D = nodes[d].bounds,
+                       &E = nodes[e].bounds,
+                       &F = nodes[f].bounds,
+                       &G = nodes[g].bounds;
+            r32 gainDF = areaB + areaC - SurfaceArea(Union(F, E)) - SurfaceArea(Union(D, G)),
+                gainDG = areaB + areaC - SurfaceArea(Union(G, E)) - SurfaceArea(Union(F, D));
+
+            if(gainDF > bestGain && AABBTreeBalanced(hF, hE) && AABBTreeBalanced(hD, hG) &&
+               AABBTreeBalanced(AABBTreeParentHeight(hF, hE), AABBTreeParentHeight(hD, hG)))
+            {
+                bestGain = gainDF; x = d; y = f;
+            }
+            if(gainDG > bestGain && AABBTreeBalanced(hG, hE) && AABBTreeBalanced(hF, hD) &&
+               AABBTreeBalanced(AABBTreeParentHeight(hG, hE), AABBTreeParentHeight(hF, hD)))
+            {
+                bestGain = gainDG; x = d; y = g;
+            }
+        }
+    }
+
+    if(x != AABBTREE_NULL)
+    {
+        AABBTreeSwap(tree, a, x, y);
+        AABBTreeFix(tree, a);
+    }
+}
+
+// NOTE: Refits and rotates from index towards the root, stopping at the
+//       first node that did not change and is still balanced (nothing above
+//       it changes either). A removal can unbalance a node without changing
+//       its height or bounds.
+inline void AABBTreeRefitUp(aabbtree &tree, u32 index)
+{
+    aabbtreenode *nodes = tree.nodes;
+
+    while(index != AABBTREE_NULL)
+    {
+        if(!AABBTreeFix(tree, index) &&
+           AABBTreeBalanced(nodes[nodes[index].left].height, nodes[nodes[index].right].height))
+            break;
+
+        AABBTreeRotate(tree, index);
+        index = nodes[index].parent;
+    }
+}
+
+inline void AABBTreeInsertLeaf(aabbtree &tree, u32 leaf)
+{
+    aabbtreenode *nodes = tree.nodes;
+
+    if(tree.root == AABBTREE_NULL)
+    {
+        tree.root = leaf;
+        nodes[leaf].parent = AABBTREE_NULL;
+        return;
+    }
+
+    // NOTE: Walk down to the cheapest sibling by the surface area heuristic:
+    //       pairing with a node costs its grown area, descending costs the
+    //       growth of every ancestor on the way. The sibling is at most
+    //       AABBTREE_MAX_IMBALANCE high so the new parent is balanced, and ties
+    //       go to the shorter child.
+    aabb leafBounds = nodes[leaf].bounds;
+    u32 index = tree.root;
+
+    while(nodes[index].left != AABBTREE_NULL)
+    {
+        const aabbtreenode &node = nodes[index];
+        r32 area = SurfaceArea(node.bounds),
+            combinedArea = SurfaceArea(Union(node.bounds, leafBounds));
+
+        r32 cost = 2.0f * combinedArea,
+            inheritance = 2.0f * (combinedArea - area);
+
+        r32 childCost[2];
+        u32 children[2] = {node.left, node.right};
+
+        for(u32 i = 0; i < 2; ++i)
+        {
+            const aabbtreenode &child = nodes[children[i]];
+            r32 grown = SurfaceArea(Union(child.bounds, leafBounds));
+
+            if(child.left == AABBTREE_NULL)
+                childCost[i] = grown + inheritance;
+            else
+                childCost[i] = grown - SurfaceArea(child.bounds) + inheritance;
+        }
+
+        if(node.height <= AABBTREE_MAX_IMBALANCE && cost < childCost[0] && cost < childCost[1])
+            break;
+
+        b32 first = (childCost[0] < childCost[1]) ||
+                    (childCost[0] == childCost[1] && nodes[children[0]].height < nodes[children[1]].height);
+
+        index = first ? children[0] : children[1];
+    }
+
+    u32 sibling = index,
+        oldParent = nodes[sibling].parent,
+        newParent = AABBTreeAllocateNode(tree);
+
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].left = sibling;
+    nodes[newParent].right = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if(oldParent != AABBTREE_NULL)
+    {
+        if(nodes[oldParent].left == sibling)
+            nodes[oldParent].left = newParent;
+        else
+            nodes[oldParent].right = newParent;
+    }
+    else
+    {
+        tree.root = newParent;
+    }
+
+    AABBTreeRefitUp(tree, newParent);
+}
+
+inline void AABBTreeRemoveLeaf(aabbtree &tree, u32 leaf)
+{
+    aabbtreenode *nodes = tree.nodes;
+
+    if(leaf == tree.root)
+    {
+        tree.root = AABBTREE_NULL;
+        return;
+    }
+
+    u32 parent = nodes[leaf].parent,
+        grandParent = nodes[parent].parent,
+        sibling = (nodes[parent].left == leaf) ? nodes[parent].right : nodes[parent].left;
+
+    // NOTE: The sibling takes the parent's place
+    nodes[sibling].parent = grandParent;
+    AABBTreeFreeNode(tree, parent);
+
+    if(grandParent != AABBTREE_NULL)
+    {
+        if(nodes[grandParent].left == parent)
+            nodes[grandParent].left = sibling;
+        else
+            nodes[grandParent].right = sibling;
+
+        AABBTreeRefitUp(tree, grandParent);
+    }
+    else
+    {
+        tree.root = sibling;
+    }
+}
+
+inline void AABBTreeBufferMove(aabbtree &tree, u32 proxy)
+{
+    aabbtreenode &node = tree.nodes[proxy];
+
+    if(!node.moved)
+    {
+        AAM_Assert(tree.moveCount < tree.maxProxies);
+
+        node.moved = true;
+        tree.moveBuffer[tree.moveCount++] = proxy;
+    }
+}
+
+inline aabb AABBTreeFatten(const aabbtree &tree, const aabb &bb)
+{
+    vec3 margin = Vec3(tree.margin, tree.margin, tree.margin);
+
+    return AABB(bb.min - margin, bb.max + margin);
+}
+
+// NOTE: Returns the proxy id, userData is what the queries report
+inline u32 Insert(aabbtree &tree, const aabb &bb, u32 userData)
+{
+    AAM_Assert(tree.proxyCount < tree.maxProxies);
+
+    u32 proxy = AABBTreeAllocateNode(tree);
+    aabbtreenode &node = tree.nodes[proxy];
+
+    node.bounds = AABBTreeFatten(tree, bb);
+    node.userData = userData;
+
+    AABBTreeInsertLeaf(tree, proxy);
+    AABBTreeBufferMove(tree, proxy);
+    ++tree.proxyCount;
+
+    return proxy;
+}
+
+inline void Remove(aabbtree &tree, u32 proxy)
+{
+    AAM_Assert(proxy < tree.capacity && tree.nodes[proxy].height == 0);
+
+    if(tree.nodes[proxy].moved)
+    {
+        for(u32 i = 0; i < tree.moveCount; ++i)
+        {
+            if(tree.moveBuffer[i] == proxy)
+            {
+                tree.moveBuffer[i] = tree.moveBuffer[--tree.moveCount];
+                break;
+            }
+        }
+    }
+
+    AABBTreeRemoveLeaf(tree, proxy);
+    AABBTreeFreeNode(tree, proxy);
+    --tree.proxyCount;
+}
+
+// NOTE: bb is the object's new tight box, displacement its motion this step.
+//       Returns false, and touches nothing, while bb is inside the fat box.
+inline b32 Move(aabbtree &tree, u32 proxy, const aabb &bb, const vec3 &displacement = VEC3_ZERO)
+{
+    AAM_Assert(proxy < tree.capacity && tree.nodes[proxy].height == 0);
+
+    aabbtreenode &node = tree.nodes[proxy];
+
+    if(Contains(node.bounds, bb))
+        return false;
+
+    AABBTreeRemoveLeaf(tree, proxy);
+
+    aabb fat = AABBTreeFatten(tree, bb);
+    vec3 ahead = AABBTREE_DISPLACEMENT_SCALE * displacement;
+
+    for(u32 i = 0; i < 3; ++i)
+    {
+        if(ahead.E[i] < 0.0f)
+            fat.min.E[i] += ahead.E[i];
+        else
+            fat.max.E[i] += ahead.E[i];
+    }
+
+    node.bounds = fat;
+
+    AABBTreeInsertLeaf(tree, proxy);
+    AABBTreeBufferMove(tree, proxy);
+
+    return true;
+}
+
+inline u32 GetUserData(const aabbtree &tree, u32 proxy)
+{
+    AAM_Assert(proxy < tree.capacity && tree.nodes[proxy].height == 0);
+
+    return tree.nodes[proxy].userData;
+}
+
+inline const aabb &GetFatBounds(const aabbtree &tree, u32 proxy)
+{
+    AAM_Assert(proxy < tree.capacity && tree.nodes[proxy].height == 0);
+
+    return tree.nodes[proxy].bounds;
+}
+
+inline s32 Height(const aabbtree &tree)
+{
+    return (tree.root == AABBTREE_NULL) ? 0 : tree.nodes[tree.root].height;
+}
+
+// NOTE: Writes the userData of the proxies whose fat boxes overlap the query to
+//       results (up to maxResults) and returns the total count, which can be larger
+inline u32 Overlaps(const aabbtree &tree, const aabb &query, u32 *results, u32 maxResults)
+{
+    if(tree.root == AABBTREE_NULL)
+        return 0;
+
+    u32 stack[AABBTREE_MAX_DEPTH + 1];
+    u32 top = 0,
+        found = 0;
+
+    stack[top++] = tree.root;
+
+    while(top > 0)
+    {
+        const aabbtreenode &node = tree.nodes[stack[--top]];
+
+        if(!Intersects(node.bounds, query))
+            continue;
+
+        if(node.left == AABBTREE_NULL)
+        {
+            if(found < maxResults)
+                results[found] = node.userData;
+            ++found;
+        }
+        else
+        {
+            AAM_Assert(top + 2 <= AABBTREE_MAX_DEPTH + 1);
+            stack[top++] = node.right;
+            stack[top++] = node.left;
+        }
+    }
+
+    return found;
+}
+
+// NOTE: Pairs of proxies with overlapping fat boxes where at least one of the
+//       two moved (or was inserted) since the last call, each pair once.
+//       Writes up to maxPairs and returns the total count, which can be
+//       larger; the move buffer is cleared either way.
+inline u32 FindPairs(aabbtree &tree, aabbtreepair *pairs, u32 maxPairs)
+{
+    u32 found = 0;
+
+    for(u32 m = 0; m < tree.moveCount; ++m)
+    {
+        u32 proxy = tree.moveBuffer[m];
+        const aabbtreenode &query = tree.nodes[proxy];
+
+        u32 stack[AABBTREE_MAX_DEPTH + 1];
+        u32 top = 0;
+
+        stack[top++] = tree.root;
+
+        while(top > 0)
+        {
+            u32 index = stack[--top];
+            const aabbtreenode &node = tree.nodes[index];
+
+            if(!Intersects(node.bounds, query.bounds))
+                continue;
+
+            if(node.left == AABBTREE_NULL)
+            {
+                // NOTE: When both moved, the pair is reported from the lower id
+                if(index == proxy || (node.moved && index < proxy))
+                    continue;
+
+                if(found < maxPairs)
+                {
+                    u32 a = query.userData,
+                        b = node.userData;
+
+                    pairs[found].a = (a < b) ? a : b;
+                    pairs[found].b = (a < b) ? b : a;
+                }
+                ++found;
+            }
+            else
+            {
+                AAM_Assert(top + 2 <= AABBTREE_MAX_DEPTH + 1);
+                stack[top++] = node.right;
+                stack[top++] = node.left;
+            }
+        }
+    }
+
+    for(u32 m = 0; m < tree.moveCount; ++m)
+    {
+        tree.nodes[tree.moveBuffer[m]].moved = false;
+    }
+
+    tree.moveCount = 0;
+
+    return found;
+}
+
+// NOTE: Closest hit against the objects, the fat boxes only prune. The callback
+//       does the exact test: it returns true on a hit closer than maxT and
+//       writes the distance to t. userData is the hit proxy's.
+typedef b32 aabbtree_raycast_callback(void *user, u32 userData, const ray3 &r, r32 maxT, r32 &t);
+
+inline b32 RayCastClosest(const aabbtree &tree, const ray3 &r, aabbtree_raycast_callback *callback,
+                          void *user, u32 &userData, r32 &t, r32 maxT = FLT_MAX)
+{
+    if(tree.root == AABBTREE_NULL)
+        return false;
+
+    vec3 invDirection = Vec3(1.0f / r.direction.x, 1.0f / r.direction.y, 1.0f / r.direction.z);
+    u32 stack[AABBTREE_MAX_DEPTH + 1];
+    u32 top = 0;
+    r32 closest = maxT,
+        tNode;
+    b32 hit = false;
+
+    stack[top++] = tree.root;
+
+    while(top > 0)
+    {
+        const aabbtreenode &node = tree.nodes[stack[--top]];
+
+        if(!IntersectsSlab(node.bounds, r.origin, invDirection, closest, tNode))
+            continue;
+
+        if(node.left == AABBTREE_NULL)
+        {
+            r32 tObject;
+
+            if(callback(user, node.userData, r, closest, tObject) && (!hit || tObject < closest))
+            {
+                closest = tObject;
+                userData = node.userData;
+                hit = true;
+            }
+        }
+        else
+        {
+            AAM_Assert(top + 2 <= AABBTREE_MAX_DEPTH + 1);
+            stack[top++] = node.right;
+            stack[top++] = node.left;
+        }
+    }
+
+    if(hit)
+        t = closest;
+
+    return hit;
+}
+
+} // NOTE: Namespace
+
+#endif
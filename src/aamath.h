@@ -6,6 +6,31 @@
 #include <math.h>
 #include "aatypes.h"
 
+// NOTE: SIMD backend, off by default (plain scalar code).
+//       AAMATH_SSE4  - SSE4.1 kernels
+//       AAMATH_AVX2  - AVX2 + FMA kernels (implies AAMATH_SSE4)
+//       AAMATH_STRICT - no FMA contraction in the SIMD kernels, so their results
+//                       are bit-comparable with the scalar fallback
+//       To pick the array-level kernels at run time instead, see dispatch.h.
+#if defined(AAMATH_AVX2)
+#ifndef AAMATH_SSE4
+#define AAMATH_SSE4
+#endif
+#include <immintrin.h>
+#elif defined(AAMATH_SSE4)
+#include <smmintrin.h>
+#endif
+
+// NOTE: SinCos, Sin, Cos, Acos and Atan2 (and their r32x4/r32x8 forms) are
+//       minimax polynomials by default, AAMATH_LIBM_TRIG routes the scalar ones
+//       back to sinf/cosf/acosf/atan2f.
+
+// NOTE: Batch transforms switch to non-temporal (streaming) stores at this many
+//       elements, when the output is 16-byte aligned
+#ifndef AAMATH_STREAM_THRESHOLD
+#define AAMATH_STREAM_THRESHOLD 65536
+#endif
+
 namespace aam
 {
 
@@ -18,6 +43,7 @@ namespace aam
 #define ONEOVERPI       0.318309886183790671537767526745028724f;
 #define ONEOVERTWOPI    0.159154943091895335768883763372514362f;
 #define ONEOVERTAU      0.159154943091895335768883763372514362f;
+#define TWOOVERPI       0.636619772367581343075535053490057448f
 
 #undef AAMATH_APPROXIMATE
 
@@ -71,12 +97,6 @@ inline b32 IsZero(r32 x, r32 epsilon = EPSILON)
     return fabs(x) <= epsilon;
 }
 
-inline void SinCos(r32 angle, r32 &a, r32 &b)
-{
-    a = sinf(angle);
-    b = cosf(angle);
-}
-
 inline r32 Clamp(r32 x, r32 min, r32 max)
 {
     r32 result = x;
@@ -116,15 +136,212 @@ inline r32 Max(r32 a, r32 b)
     return (a > b) ? a : b;
 }
 
+// NOTE: floor without the libm call or a rounding mode change, for |x| < 2^31
+inline s32 FloorToS32(r32 x)
+{
+    s32 result = (s32)x;
+
+    return result - (x < (r32)result);
+}
+
+// NOTE: Polynomial trig, Cephes style: Cody-Waite reduction by pi/2 (the three
+//       parts of pi/2 sum exactly in float) and minimax polynomials on
+//       [-pi/4, pi/4]. Max error against a double reference, sampled over the
+//       whole float range of each input:
+//         SinCos, Sin, Cos  2 ulp for |angle| <= 8192 (absolute error < 1e-7
+//                           near the zeros). The float reduction is off by
+//                           1e-6 at 1e5 and by 1e-2 past 2e5, so larger
+//                           angles, infinities and NaNs go to sinf/cosf.
+//         Acos              2 ulp, input clamped to [-1, 1]
+//         Atan2             3 ulp
+#define AAM_PIO2_A      1.5703125f
+#define AAM_PIO2_B      4.837512969970703125e-4f
+#define AAM_PIO2_C      7.54978995489188216e-8f
+#define AAM_TANPIOVER8  0.414213562373095048801688724209698079f
+#define AAM_TRIG_MAX_REDUCE 8192.0f
+
+#define AAM_SIN_C0      -1.6666654611e-1f
+#define AAM_SIN_C1      8.3321608736e-3f
+#define AAM_SIN_C2      -1.9515295891e-4f
+#define AAM_COS_C0      4.166664568298827e-2f
+#define AAM_COS_C1      -1.388731625493765e-3f
+#define AAM_COS_C2      2.443315711809948e-5f
+#define AAM_ASIN_C0     1.6666752422e-1f
+#define AAM_ASIN_C1     7.4953002686e-2f
+#define AAM_ASIN_C2     4.5470025998e-2f
+#define AAM_ASIN_C3     2.4181311049e-2f
+#define AAM_ASIN_C4     4.2163199048e-2f
+#define AAM_ATAN_C0     -3.33329491539e-1f
+#define AAM_ATAN_C1     1.99777106478e-1f
+#define AAM_ATAN_C2     -1.38776856032e-1f
+#define AAM_ATAN_C3     8.05374449538e-2f
+
+inline void SinCos(r32 angle, r32 &s, r32 &c)
+{
+#if defined(AAMATH_LIBM_TRIG)
+    s = sinf(angle);
+    c = cosf(angle);
+#else
+    if(!(fabsf(angle) <= AAM_TRIG_MAX_REDUCE))
+    {
+        s = sinf(angle);
+        c = cosf(angle);
+        return;
+    }
+
+    // NOTE: angle = j * pi/2 + x, |x| <= pi/4
+    s32 j = (s32)(angle * TWOOVERPI + ((angle >= 0.0f) ? 0.5f : -0.5f));
+    r32 fj = (r32)j;
+    r32 x = ((angle - fj * AAM_PIO2_A) - fj * AAM_PIO2_B) - fj * AAM_PIO2_C;
+    r32 z = x * x;
+
+    r32 sx = x + x * z * (AAM_SIN_C0 + z * (AAM_SIN_C1 + z * AAM_SIN_C2));
+    r32 cx = 1.0f - 0.5f * z + z * z * (AAM_COS_C0 + z * (AAM_COS_C1 + z * AAM_COS_C2));
+
+    // NOTE: Rotate by the quadrant
+    switch(j & 3)
+    {
+        case 0: s = sx;  c = cx;  break;
+        case 1: s = cx;  c = -sx; break;
+        case 2: s = -sx; c = -cx; break;
+        default: s = -cx; c = sx; break;
+    }
+#endif
+}
+
+inline r32 Sin(r32 angle)
+{
+    r32 s, c;
+    SinCos(angle, s, c);
+    return s;
+}
+
+inline r32 Cos(r32 angle)
+{
+    r32 s, c;
+    SinCos(angle, s, c);
+    return c;
+}
+
+inline r32 Acos(r32 x)
+{
+    x = Clamp(x, -1.0f, 1.0f);
+
+#if defined(AAMATH_LIBM_TRIG)
+    return acosf(x);
+#else
+    r32 result,
+        a = fabsf(x);
+
+    if(a > 0.5f)
+    {
+        // NOTE: acos(a) = 2 * asin(sqrt((1 - a) / 2))
+        r32 z = 0.5f * (1.0f - a);
+        r32 s = sqrtf(z);
+        result = 2.0f * (s + s * z * (AAM_ASIN_C0 + z * (AAM_ASIN_C1 + z * (AAM_ASIN_C2
+                                      + z * (AAM_ASIN_C3 + z * AAM_ASIN_C4)))));
+        if(x < 0.0f)
+            result = PI - result;
+    }
+    else
+    {
+        r32 z = x * x;
+        result = PIOVERTWO - (x + x * z * (AAM_ASIN_C0 + z * (AAM_ASIN_C1 + z * (AAM_ASIN_C2
+                                           + z * (AAM_ASIN_C3 + z * AAM_ASIN_C4)))));
+    }
+
+    return result;
+#endif
+}
+
+inline r32 Atan2(r32 y, r32 x)
+{
+#if defined(AAMATH_LIBM_TRIG)
+    return atan2f(y, x);
+#else
+    // NOTE: Fold into the first octant, atan(r) for r in [0, 1], then unfold
+    r32 ax = fabsf(x),
+        ay = fabsf(y),
+        hi = Max(ax, ay),
+        lo = Min(ax, ay),
+        r = 0.0f,
+        offset = 0.0f;
+
+    // NOTE: atan(lo / hi) = pi/4 + atan((lo - hi) / (lo + hi)), taken above tan(pi/8)
+    if(lo > AAM_TANPIOVER8 * hi)
+    {
+        r = (lo - hi) / (lo + hi);
+        offset = PIOVERFOUR;
+    }
+    else if(hi > 0.0f)
+    {
+        r = lo / hi;
+    }
+
+    r32 z = r * r;
+    r32 result = offset + r + r * z * (AAM_ATAN_C0 + z * (AAM_ATAN_C1 + z * (AAM_ATAN_C2 + z * AAM_ATAN_C3)));
+
+    if(ay > ax)
+        result = PIOVERTWO - result;
+
+    intfloat fx = {x},
+             fy = {y};
+
+    if(fx.u >> 31)
+        result = PI - result;
+
+    intfloat out = {result};
+    out.u |= fy.u & 0x80000000;
+
+    return out.f;
+#endif
+}
+
+#if defined(AAMATH_SSE4)
+// NOTE: a * b + c, fused when the backend has FMA
+inline __m128 MulAdd(__m128 a, __m128 b, __m128 c)
+{
+#if defined(AAMATH_AVX2) && !defined(AAMATH_STRICT)
+    return _mm_fmadd_ps(a, b, c);
+#else
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+#endif
+
+#if defined(AAMATH_AVX2)
+inline __m256 MulAdd(__m256 a, __m256 b, __m256 c)
+{
+#if !defined(AAMATH_STRICT)
+    return _mm256_fmadd_ps(a, b, c);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+#endif
+
 } // NOTE: Namespace
 
+#include "simd.h"
 #include "vec2.h"
 #include "vec3.h"
 #include "vec4.h"
 #include "mat3.h"
 #include "mat4.h"
 #include "quat.h"
+#include "wide.h"
+#include "mat4x3.h"
+#include "transform.h"
+#include "hierarchy.h"
+#include "dualquat.h"
+#include "skinning.h"
 #include "collision.h"
+#include "raypacket.h"
+#include "bvh.h"
+#include "aabbtree.h"
+#include "sweepprune.h"
+#include "spatialhash.h"
+#include "gjk.h"
 
 #endif
 
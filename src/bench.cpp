@@ -0,0 +1,1524 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <chrono>
+#include "aamath.h"
+#include "dispatch.h"
+
+/*
+    Micro-benchmarks for the hot functions of every header.
+
+    Each case runs a kernel over arrays of random inputs in three modes:
+        warm  - a small working set (BENCH_SMALL_COUNT elements) looped until
+                it stays in cache, best of several trials
+        cold  - the same small set, with the caches flushed before every pass
+                (median of several passes)
+        large - one pass over a large array (--large elements, 1M by default),
+                reported as ns/op and GB/s of input + output traffic
+
+    warm and cold reuse the same small inputs, so branchy kernels run with a
+    trained branch predictor there; large shows the untrained cost.
+
+    --accuracy first prints the error of the quaternion interpolations (scalar
+    and batched) against a double precision slerp, of the near-parallel
+    segment distances against double precision and the scalar version, and of
+    capsule to sphere distances with the centre on the axis. It also checks
+    that BuildHierarchy rejects hierarchies past HIERARCHY_MAX_DEPTH and that
+    the aabbtree keeps containing moved boxes at large coordinates, and times
+    spatial hash queries over huge or infinite bounds against brute force.
+
+    The dispatch group goes through the runtime dispatch tables, --simd-level
+    forces a level (up to the detected one).
+
+    Usage: aamath_bench [--filter text] [--large count] [--json file|-] [--quick] [--accuracy]
+                        [--simd-level scalar|sse4.1|avx2|avx512]
+*/
+
+using namespace aam;
+
+#define BENCH_SMALL_COUNT   1024
+#define BENCH_WARM_TRIALS   5
+#define BENCH_COLD_PASSES   7
+#define BENCH_EVICT_BYTES   (32 * 1024 * 1024)
+
+typedef void bench_kernel(const void *a, const void *b, void *out, u32 count);
+typedef void bench_fill(void *data, u32 count);
+
+typedef struct _bench_case
+{
+    const char *group,
+               *name;
+    bench_kernel *kernel;
+    bench_fill *fillA,
+               *fillB;
+    u32 sizeA,
+        sizeB,
+        sizeOut;
+    _bench_case *next;
+} bench_case;
+
+typedef struct _bench_result
+{
+    double warmNs,
+           coldNs,
+           largeNs,
+           largeGBs;
+    u32 largeCount;
+} bench_result;
+
+static bench_case *GlobalFirstCase;
+static bench_case *GlobalLastCase;
+
+struct bench_registrar
+{
+    bench_registrar(bench_case *c)
+    {
+        if(GlobalLastCase)
+            GlobalLastCase->next = c;
+        else
+            GlobalFirstCase = c;
+        GlobalLastCase = c;
+    }
+};
+
+//
+// NOTE: Random inputs
+//
+
+static u32 GlobalRandomState = 0x9E3779B9;
+
+static u32 RandomU32()
+{
+    // NOTE: xorshift32
+    u32 x = GlobalRandomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    GlobalRandomState = x;
+    return x;
+}
+
+// NOTE: Uniform in [-1, 1)
+static r32 RandomBilateral()
+{
+    return (r32)(RandomU32() >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+static r32 RandomUnilateral()
+{
+    return (r32)(RandomU32() >> 8) * (1.0f / 16777216.0f);
+}
+
+static void Random(u8 &v) { v = (u8)RandomU32(); }
+static void Random(r32 &v) { v = RandomBilateral(); }
+static void Random(vec2 &v) { v = Vec2(RandomBilateral(), RandomBilateral()); }
+static void Random(vec3 &v) { v = Vec3(RandomBilateral(), RandomBilateral(), RandomBilateral()); }
+static void Random(vec4 &v) { v = Vec4(RandomBilateral(), RandomBilateral(), RandomBilateral(), RandomBilateral()); }
+
+static void Random(quat &q)
+{
+    q = Quat(RandomBilateral(), RandomBilateral(), RandomBilateral(), RandomBilateral());
+    Normalize(q);
+}
+
+static void Random(mat3 &m)
+{
+    quat q;
+    Random(q);
+    m = Mat3Rotation(q) * Mat3Scaling(0.5f + RandomUnilateral(), 0.5f + RandomUnilateral(), 0.5f + RandomUnilateral());
+}
+
+// NOTE: Affine, rotation * scale plus a translation, so every inverse applies
+static void Random(mat4 &m)
+{
+    quat q;
+    vec3 t;
+    Random(q);
+    Random(t);
+    m = Mat4Translation(10.0f * t) * Mat4Rotation(q)
+        * Mat4Scaling(0.5f + RandomUnilateral(), 0.5f + RandomUnilateral(), 0.5f + RandomUnilateral());
+}
+
+static void Random(mat4x3 &m)
+{
+    mat4 affine;
+    Random(affine);
+    m = Mat4x3(affine);
+}
+
+static void Random(transform &tf)
+{
+    quat q;
+    vec3 t;
+    Random(q);
+    Random(t);
+    tf = Transform(10.0f * t, q, Vec3(0.5f + RandomUnilateral(), 0.5f + RandomUnilateral(), 0.5f + RandomUnilateral()));
+}
+
+static void Random(aabb &bb)
+{
+    vec3 c, e;
+    Random(c);
+    e = Vec3(RandomUnilateral(), RandomUnilateral(), RandomUnilateral()) * 0.1f;
+    bb = AABB(10.0f * c - e, 10.0f * c + e);
+}
+
+static void Random(sphere &s)
+{
+    vec3 c;
+    Random(c);
+    s = Sphere(10.0f * c, 0.1f * RandomUnilateral());
+}
+
+static void Random(ray3 &r)
+{
+    vec3 o, d;
+    Random(o);
+    Random(d);
+    r = Ray3(10.0f * o, Normalized(d));
+}
+
+static void Random(fastray3 &r)
+{
+    ray3 ray;
+    Random(ray);
+    r = FastRay3(ray);
+}
+
+static void Random(plane &p)
+{
+    vec3 n;
+    Random(n);
+    p = Plane(Normalized(n), RandomBilateral());
+}
+
+static void Random(triangle &tri)
+{
+    vec3 c, a, b;
+    Random(c);
+    Random(a);
+    Random(b);
+    tri = Triangle(10.0f * c, 10.0f * c + a, 10.0f * c + b);
+}
+
+static void Random(lineseg3 &l)
+{
+    vec3 o, d;
+    Random(o);
+    Random(d);
+    l = LineSeg3(o, d);
+}
+
+static void Random(obb &box)
+{
+    vec3 c;
+    quat q;
+    Random(c);
+    Random(q);
+    box = OBB(2.0f * c, q, Vec3(0.1f + 0.5f * RandomUnilateral(), 0.1f + 0.5f * RandomUnilateral(), 0.1f + 0.5f * RandomUnilateral()));
+}
+
+static void Random(capsule &c)
+{
+    vec3 a, b;
+    Random(a);
+    Random(b);
+    c = Capsule(a, a + 0.5f * b, 0.1f + 0.2f * RandomUnilateral());
+}
+
+// NOTE: Segments all within about 0.01 radians of the x axis, so any two are
+//       near-parallel
+typedef struct _parallelseg
+{
+    lineseg3 line;
+} parallelseg;
+
+static void Random(parallelseg &p)
+{
+    vec3 o, d;
+    Random(o);
+    Random(d);
+    p.line = LineSeg3(o, Vec3(1.0f, 0.0f, 0.0f) + 0.01f * d);
+}
+
+static void Random(dualquat &dq)
+{
+    quat q;
+    vec3 t;
+    Random(q);
+    Random(t);
+    dq = DualQuat(q, 10.0f * t);
+}
+
+#define BENCH_PALETTE_SIZE 64
+
+// NOTE: 1 to 4 influences, normalised weights
+static void Random(skinweights &sw)
+{
+    u32 used = 1 + RandomU32() % SKIN_MAX_WEIGHTS;
+    r32 sum = 0.0f;
+
+    for(u32 i = 0; i < SKIN_MAX_WEIGHTS; ++i)
+    {
+        sw.bones[i] = (u16)(RandomU32() % BENCH_PALETTE_SIZE);
+        sw.weights[i] = (i < used) ? 0.1f + RandomUnilateral() : 0.0f;
+        sum += sw.weights[i];
+    }
+
+    for(u32 i = 0; i < SKIN_MAX_WEIGHTS; ++i)
+        sw.weights[i] /= sum;
+}
+
+template<typename T> static void Fill(void *data, u32 count)
+{
+    T *t = (T *)data;
+    for(u32 i = 0; i < count; ++i)
+        Random(t[i]);
+}
+
+//
+// NOTE: Case definitions. BENCH loops expr over i, BENCH_ARRAY runs stmt once
+//       over the whole arrays (batch functions). Both see a, b, out and count.
+//
+
+#define BENCH_REGISTER(id, group, name, TA, TB, TR) \
+    static bench_case BenchCase_##id = { group, name, BenchKernel_##id, Fill<TA>, Fill<TB>, \
+                                         sizeof(TA), sizeof(TB), sizeof(TR), 0 }; \
+    static bench_registrar BenchRegistrar_##id(&BenchCase_##id);
+
+#define BENCH(id, group, name, TA, TB, TR, expr) \
+    static void BenchKernel_##id(const void *pa, const void *pb, void *pout, u32 count) \
+    { \
+        const TA *a = (const TA *)pa; \
+        const TB *b = (const TB *)pb; \
+        TR *out = (TR *)pout; \
+        (void)a; (void)b; \
+        for(u32 i = 0; i < count; ++i) \
+        { \
+            expr; \
+        } \
+    } \
+    BENCH_REGISTER(id, group, name, TA, TB, TR)
+
+#define BENCH_ARRAY(id, group, name, TA, TB, TR, stmt) \
+    static void BenchKernel_##id(const void *pa, const void *pb, void *pout, u32 count) \
+    { \
+        const TA *a = (const TA *)pa; \
+        const TB *b = (const TB *)pb; \
+        TR *out = (TR *)pout; \
+        (void)a; (void)b; (void)out; \
+        stmt; \
+    } \
+    BENCH_REGISTER(id, group, name, TA, TB, TR)
+
+//
+// NOTE: vec2/vec3/vec4
+//
+
+BENCH(Vec2Add,          "vec2", "operator+",        vec2, vec2, vec2, out[i] = a[i] + b[i])
+BENCH(Vec2Dot,          "vec2", "Dot",              vec2, vec2, r32,  out[i] = Dot(a[i], b[i]))
+BENCH(Vec2Length,       "vec2", "Length",           vec2, vec2, r32,  out[i] = Length(a[i]))
+BENCH(Vec2Normalized,   "vec2", "Normalized",       vec2, vec2, vec2, out[i] = Normalized(a[i]))
+BENCH(Vec2Reflect,      "vec2", "Reflect",          vec2, vec2, vec2, out[i] = Reflect(a[i], b[i]))
+
+BENCH(Vec3Add,          "vec3", "operator+",        vec3, vec3, vec3, out[i] = a[i] + b[i])
+BENCH(Vec3Scale,        "vec3", "operator*(r32)",   vec3, r32,  vec3, out[i] = a[i] * b[i])
+BENCH(Vec3Dot,          "vec3", "Dot",              vec3, vec3, r32,  out[i] = Dot(a[i], b[i]))
+BENCH(Vec3Cross,        "vec3", "Cross",            vec3, vec3, vec3, out[i] = Cross(a[i], b[i]))
+BENCH(Vec3Length,       "vec3", "Length",           vec3, vec3, r32,  out[i] = Length(a[i]))
+BENCH(Vec3DistanceSq,   "vec3", "DistanceSq",       vec3, vec3, r32,  out[i] = DistanceSq(a[i], b[i]))
+BENCH(Vec3Normalized,   "vec3", "Normalized",       vec3, vec3, vec3, out[i] = Normalized(a[i]))
+BENCH(Vec3Reflect,      "vec3", "Reflect",          vec3, vec3, vec3, out[i] = Reflect(a[i], b[i]))
+BENCH(Vec3Refract,      "vec3", "Refract",          vec3, vec3, vec3, out[i] = Refract(a[i], Normalized(b[i]), 0.75f))
+BENCH(Vec3TripleScal,   "vec3", "TripleScal",       vec3, vec3, r32,  out[i] = TripleScal(a[i], b[i], a[count - 1 - i]))
+
+BENCH(Vec4Add,          "vec4", "operator+",        vec4, vec4, vec4, out[i] = a[i] + b[i])
+BENCH(Vec4Dot,          "vec4", "Dot",              vec4, vec4, r32,  out[i] = Dot(a[i], b[i]))
+BENCH(Vec4Cross,        "vec4", "Cross",            vec4, vec4, vec4, out[i] = Cross(a[i], b[i]))
+BENCH(Vec4Normalized,   "vec4", "Normalized",       vec4, vec4, vec4, out[i] = Normalized(a[i]))
+BENCH(Vec4Hadamard,     "vec4", "Hadamard",         vec4, vec4, vec4, out[i] = Hadamard(a[i], b[i]))
+
+//
+// NOTE: mat3/mat4
+//
+
+BENCH(Mat3Mul,          "mat3", "operator*(mat3)",  mat3, mat3, mat3, out[i] = a[i] * b[i])
+BENCH(Mat3MulVec,       "mat3", "operator*(vec3)",  mat3, vec3, vec3, out[i] = a[i] * b[i])
+BENCH(Mat3Transposed,   "mat3", "Transposed",       mat3, mat3, mat3, out[i] = Transposed(a[i]))
+BENCH(Mat3Determinant,  "mat3", "Determinant",      mat3, mat3, r32,  out[i] = Determinant(a[i]))
+BENCH(Mat3Inverse,      "mat3", "Inverse",          mat3, mat3, mat3, out[i] = Inverse(a[i]))
+BENCH(Mat3RotationQuat, "mat3", "Mat3Rotation(quat)", quat, quat, mat3, out[i] = Mat3Rotation(a[i]))
+BENCH(Mat3RotationAxis, "mat3", "Mat3Rotation(axis, angle)", vec3, r32, mat3, out[i] = Mat3Rotation(a[i], b[i]))
+BENCH(Mat3GetQuat,      "mat3", "GetQuaternion",    mat3, mat3, quat, out[i] = GetQuaternion(a[i]))
+
+BENCH(Mat4Mul,          "mat4", "operator*(mat4)",  mat4, mat4, mat4, out[i] = a[i] * b[i])
+BENCH(Mat4MulVec,       "mat4", "operator*(vec4)",  mat4, vec4, vec4, out[i] = a[i] * b[i])
+BENCH(Mat4Transposed,   "mat4", "Transposed",       mat4, mat4, mat4, out[i] = Transposed(a[i]))
+BENCH(Mat4Determinant,  "mat4", "Determinant",      mat4, mat4, r32,  out[i] = Determinant(a[i]))
+BENCH(Mat4Inverse,      "mat4", "Inverse",          mat4, mat4, mat4, out[i] = Inverse(a[i]))
+BENCH(Mat4InverseGen,   "mat4", "InverseGeneral",   mat4, mat4, mat4, out[i] = InverseGeneral(a[i]))
+BENCH(Mat4InverseAff,   "mat4", "InverseAffine",    mat4, mat4, mat4, out[i] = InverseAffine(a[i]))
+BENCH(Mat4InverseRigid, "mat4", "InverseRigid",     mat4, mat4, mat4, out[i] = InverseRigid(a[i]))
+BENCH(Mat4RotationQuat, "mat4", "Mat4Rotation(quat)", quat, quat, mat4, out[i] = Mat4Rotation(a[i]))
+BENCH(Mat4RotationXYZ,  "mat4", "Mat4Rotation(x, y, z)", vec3, vec3, mat4, out[i] = Mat4Rotation(a[i].x, a[i].y, a[i].z))
+BENCH(Mat4GetEuler,     "mat4", "GetEulerAngles",   mat4, mat4, vec4, out[i] = GetEulerAngles(a[i]))
+BENCH(Mat4TransformPoint, "mat4", "TransformPoint", vec3, mat4, vec3, out[i] = TransformPoint(b[0], a[i]))
+BENCH_ARRAY(Mat4TransformPoints, "mat4", "TransformPoints", vec3, mat4, vec3,
+            TransformPoints(b[0], a, out, count))
+BENCH_ARRAY(Mat4TransformDirections, "mat4", "TransformDirections", vec3, mat4, vec3,
+            TransformDirections(b[0], a, out, count))
+BENCH_ARRAY(Mat4TransformProjective, "mat4", "TransformPointsProjective", vec3, mat4, vec3,
+            TransformPointsProjective(b[0], a, out, count))
+BENCH_ARRAY(Mat4Transform,  "mat4", "Transform(vec4[])", vec4, mat4, vec4,
+            Transform(b[0], a, out, count))
+
+BENCH(Mat4x3Mul,        "mat4x3", "operator*(mat4x3)", mat4x3, mat4x3, mat4x3, out[i] = a[i] * b[i])
+BENCH(Mat4x3Inverse,    "mat4x3", "Inverse",          mat4x3, mat4x3, mat4x3, out[i] = Inverse(a[i]))
+BENCH(Mat4x3InverseRigid, "mat4x3", "InverseRigid",   mat4x3, mat4x3, mat4x3, out[i] = InverseRigid(a[i]))
+BENCH(Mat4x3TransformPoint, "mat4x3", "TransformPoint", vec3, mat4x3, vec3, out[i] = TransformPoint(b[0], a[i]))
+BENCH_ARRAY(Mat4x3Multiply, "mat4x3", "Multiply(mat4x3[])", mat4x3, mat4x3, mat4x3,
+            Multiply(a, b, out, count))
+
+//
+// NOTE: transform
+//
+
+// NOTE: The TRS matrix built from a transform directly vs through two mat4 products
+BENCH(TransformToMat4,  "transform", "ToMat4",          transform, transform, mat4, out[i] = ToMat4(a[i]))
+BENCH(TransformTRSMat4, "transform", "T * R * S (mat4 products)", transform, transform, mat4,
+      out[i] = Mat4Translation(a[i].translation) * Mat4Rotation(a[i].rotation)
+               * Mat4Scaling(a[i].scale.x, a[i].scale.y, a[i].scale.z))
+BENCH(TransformToMat4x3, "transform", "ToMat4x3",       transform, transform, mat4x3, out[i] = ToMat4x3(a[i]))
+BENCH(TransformMul,     "transform", "operator*(transform)", transform, transform, transform, out[i] = a[i] * b[i])
+BENCH(TransformInverse, "transform", "Inverse",         transform, transform, transform, out[i] = Inverse(a[i]))
+BENCH(TransformPointB,  "transform", "TransformPoint",  transform, vec3, vec3, out[i] = TransformPoint(a[i], b[i]))
+BENCH(TransformLerp,    "transform", "Lerp",            transform, transform, transform, out[i] = Lerp(a[i], 0.3f, b[i]))
+
+// NOTE: Each call moves count nodes (wrapping over the hierarchy) and updates,
+//       so the time per element includes the moved subtrees
+#define BENCH_HIERARCHY_SIZE (1 << 16)
+
+static hierarchy GlobalHierarchy;
+
+BENCH_ARRAY(HierarchyUpdate, "hierarchy", "SetLocal + UpdateHierarchy", transform, transform, u32,
+            for(u32 i = 0; i < count; ++i)
+                SetLocal(GlobalHierarchy, (i * 2654435761u) % BENCH_HIERARCHY_SIZE, a[i]);
+            UpdateHierarchy(GlobalHierarchy))
+
+//
+// NOTE: quat
+//
+
+BENCH(QuatMul,          "quat", "operator*(quat)",  quat, quat, quat, out[i] = a[i] * b[i])
+BENCH(QuatNormalize,    "quat", "Normalize",        quat, quat, quat, out[i] = a[i]; Normalize(out[i]))
+BENCH(QuatRotate,       "quat", "Rotate(vec3)",     quat, vec3, vec3, out[i] = Rotate(a[i], b[i]))
+BENCH(QuatAxisAngleB,   "quat", "QuatAxisAngle",    vec3, r32,  quat, out[i] = QuatAxisAngle(a[i], b[i]))
+BENCH(QuatLerp,         "quat", "Lerp",             quat, quat, quat, Lerp(out[i], a[i], 0.3f, b[i]))
+BENCH(QuatSlerp,        "quat", "Slerp",            quat, quat, quat, Slerp(out[i], a[i], 0.3f, b[i]))
+BENCH(QuatApproxSlerp,  "quat", "ApproxSlerp",      quat, quat, quat, ApproxSlerp(out[i], a[i], 0.3f, b[i]))
+BENCH_ARRAY(QuatNlerpBatch, "quat", "NlerpBatch",     quat, quat, quat, NlerpBatch(a, b, 0.3f, out, count))
+BENCH_ARRAY(QuatNlerpBatchApprox, "quat", "NlerpBatch (approx normalize)", quat, quat, quat,
+            NlerpBatch(a, b, 0.3f, out, count, true))
+BENCH_ARRAY(QuatSlerpBatch, "quat", "SlerpBatch",     quat, quat, quat, SlerpBatch(a, b, 0.3f, out, count))
+BENCH_ARRAY(QuatApproxSlerpBatch, "quat", "ApproxSlerpBatch", quat, quat, quat,
+            ApproxSlerpBatch(a, b, 0.3f, out, count))
+BENCH_ARRAY(QuatSlerpBatchShared, "quat", "SlerpBatch (shared start)", quat, quat, quat,
+            SlerpBatch(a[0], b, 0.3f, out, count))
+
+//
+// NOTE: dualquat/skinning
+//
+
+static mat4 GlobalMatrixPalette[BENCH_PALETTE_SIZE];
+static dualquat GlobalDualQuatPalette[BENCH_PALETTE_SIZE];
+
+BENCH(DualQuatMul,      "dualquat", "operator*(dualquat)", dualquat, dualquat, dualquat, out[i] = a[i] * b[i])
+BENCH(DualQuatNormalize, "dualquat", "Normalize",          dualquat, dualquat, dualquat, out[i] = Normalized(a[i]))
+BENCH(DualQuatTransform, "dualquat", "TransformPoint",     dualquat, vec3, vec3, out[i] = TransformPoint(a[i], b[i]))
+BENCH(DualQuatToMat4,   "dualquat", "ToMat4",              dualquat, dualquat, mat4, out[i] = ToMat4(a[i]))
+BENCH_ARRAY(SkinLinearB, "skinning", "SkinLinear",         vec3, skinweights, vec3,
+            SkinLinear(GlobalMatrixPalette, b, a, out, count))
+BENCH_ARRAY(SkinDualQuatB, "skinning", "SkinDualQuat",     vec3, skinweights, vec3,
+            SkinDualQuat(GlobalDualQuatPalette, b, a, out, count))
+
+//
+// NOTE: Trig, libm for reference
+//
+
+BENCH(TrigSinCos,       "trig", "SinCos",           r32, r32, vec2, SinCos(8.0f * a[i], out[i].x, out[i].y))
+BENCH(TrigLibmSinCos,   "trig", "sinf+cosf (libm)", r32, r32, vec2, out[i].x = sinf(8.0f * a[i]); out[i].y = cosf(8.0f * a[i]))
+BENCH(TrigAcos,         "trig", "Acos",             r32, r32, r32,  out[i] = Acos(a[i]))
+BENCH(TrigLibmAcos,     "trig", "acosf (libm)",     r32, r32, r32,  out[i] = acosf(a[i]))
+BENCH(TrigAtan2,        "trig", "Atan2",            r32, r32, r32,  out[i] = Atan2(a[i], b[i]))
+BENCH(TrigLibmAtan2,    "trig", "atan2f (libm)",    r32, r32, r32,  out[i] = atan2f(a[i], b[i]))
+BENCH_ARRAY(TrigSinCosX8, "trig", "SinCos(r32x8)",  r32, r32, vec2,
+            for(u32 i = 0; i + 8 <= count; i += 8)
+            {
+                r32x8 s;
+                r32x8 c;
+                SinCos(8.0f * LoadR32x8(a + i), s, c);
+                Store(&out[i].x, Low(s));
+                Store(&out[i + 4].x, High(c));
+            })
+
+//
+// NOTE: collision
+//
+
+static frustum GlobalFrustum;
+static bvh GlobalBVH;
+
+BENCH(AABBAABB,         "collision", "Intersects(aabb, aabb)",   aabb, aabb, u32, out[i] = Intersects(a[i], b[i]))
+BENCH(AABBRay,          "collision", "Intersects(aabb, ray3)",   aabb, ray3, u32, out[i] = Intersects(a[i], b[i]))
+BENCH(SphereSphere,     "collision", "Intersects(sphere, sphere)", sphere, sphere, u32, out[i] = Intersects(a[i], b[i]))
+BENCH(SphereRay,        "collision", "Intersects(sphere, ray3)", sphere, ray3, u32, out[i] = Intersects(a[i], b[i]))
+BENCH(AABBFastRay,      "collision", "Intersects(aabb, fastray3)", aabb, fastray3, u32, out[i] = Intersects(a[i], b[i]))
+
+// NOTE: One packet against every box, so each op is 4/8/16 ray tests
+BENCH_ARRAY(AABBRayx4,  "raypacket", "Intersects(aabb, ray3x4)", aabb, ray3, u32,
+            ray3x4 p = LoadRay3x4(b); r32x4 t;
+            for(u32 i = 0; i < count; ++i) out[i] = Intersects(a[i], p, t))
+BENCH_ARRAY(AABBRayx8,  "raypacket", "Intersects(aabb, ray3x8)", aabb, ray3, u32,
+            ray3x8 p = LoadRay3x8(b); r32x8 t;
+            for(u32 i = 0; i < count; ++i) out[i] = Intersects(a[i], p, t))
+BENCH_ARRAY(AABBRayx16, "raypacket", "Intersects(aabb, ray3x16)", aabb, ray3, u32,
+            ray3x16 p = LoadRay3x16(b); r32x8 t[2];
+            for(u32 i = 0; i < count; ++i) out[i] = Intersects(a[i], p, t))
+BENCH_ARRAY(SphereRayx8, "raypacket", "Intersects(sphere, ray3x8)", sphere, ray3, u32,
+            ray3x8 p = LoadRay3x8(b); r32x8 t;
+            for(u32 i = 0; i < count; ++i) out[i] = Intersects(a[i], p, t))
+BENCH(AABBRayHit,       "collision", "Intersects(aabb, ray3, rayhit)", aabb, ray3, rayhit, Intersects(a[i], b[i], out[i]))
+BENCH(SphereRayHit,     "collision", "Intersects(sphere, ray3, rayhit)", sphere, ray3, rayhit, Intersects(a[i], b[i], out[i]))
+BENCH(TriangleRayHit,   "collision", "Intersects(triangle, ray3, rayhit)", triangle, ray3, rayhit, Intersects(a[i], b[i], out[i]))
+
+// NOTE: One element of a rayhitbuffer, the hit bits fit in the last column
+typedef struct _rayhitstorage
+{
+    r32 E[9];
+} rayhitstorage;
+
+static rayhitbuffer RayHitBuffer(void *memory, u32 count)
+{
+    r32 *at = (r32 *)memory;
+    rayhitbuffer result = {(u32 *)(at + 8 * count),
+                           at, at + count,
+                           at + 2 * count, at + 3 * count, at + 4 * count,
+                           at + 5 * count, at + 6 * count, at + 7 * count};
+
+    return result;
+}
+
+BENCH_ARRAY(AABBRayHitBatch, "collision", "IntersectBatch(aabb[], ray3[])", aabb, ray3, rayhitstorage,
+            IntersectBatch(a, b, count, RayHitBuffer(out, count)))
+BENCH_ARRAY(SphereRayHitBatch, "collision", "IntersectBatch(sphere[], ray3[])", sphere, ray3, rayhitstorage,
+            IntersectBatch(a, b, count, RayHitBuffer(out, count)))
+BENCH_ARRAY(PlaneRayHitBatch, "collision", "IntersectBatch(plane[], ray3[])", plane, ray3, rayhitstorage,
+            IntersectBatch(a, b, count, RayHitBuffer(out, count)))
+BENCH(PlaneAABB,        "collision", "Test(aabb, plane)",        aabb, plane, r32, out[i] = Test(a[i], b[i]))
+BENCH(OBBOBB,           "collision", "Intersects(obb, obb)",     obb, obb, u32, out[i] = Intersects(a[i], b[i]))
+BENCH(OBBSphere,        "collision", "Intersects(obb, sphere)",  obb, sphere, u32, out[i] = Intersects(a[i], b[i]))
+BENCH(OBBPlane,         "collision", "Test(obb, plane)",         obb, plane, r32, out[i] = Test(a[i], b[i]))
+BENCH(OBBRay,           "collision", "Intersects(obb, ray3, t)", obb, ray3, r32, out[i] = -1.0f; Intersects(a[i], b[i], out[i]))
+BENCH(OBBFromAABB,      "collision", "OBB(aabb, mat4)",          aabb, mat4, obb, out[i] = OBB(a[i], b[i]))
+BENCH_ARRAY(OBBFit,     "collision", "OBB(vec3[]) (covariance fit)", vec3, vec3, obb,
+            out[0] = OBB(a, count))
+BENCH(SegSegDistance,   "collision", "DistanceSq(lineseg3, lineseg3)", lineseg3, lineseg3, r32, out[i] = DistanceSq(a[i], b[i]))
+BENCH(SegSegClosest,    "collision", "ClosestPoints(lineseg3, lineseg3)", lineseg3, lineseg3, vec3,
+      vec3 p; ClosestPoints(a[i], b[i], out[i], p))
+BENCH_ARRAY(SegSegDistanceBatch, "collision", "DistanceSq(lineseg3[], lineseg3[])", lineseg3, lineseg3, r32,
+            DistanceSq(a, b, count, out))
+BENCH_ARRAY(SegSegDistanceOne, "collision", "DistanceSq(lineseg3, lineseg3[])", lineseg3, lineseg3, r32,
+            DistanceSq(a[0], b, count, out))
+BENCH(CapsuleCapsule,   "collision", "Distance(capsule, capsule)", capsule, capsule, r32, out[i] = Distance(a[i], b[i]))
+BENCH_ARRAY(CapsuleCapsuleBatch, "collision", "Distance(capsule, capsule[])", capsule, capsule, r32,
+            Distance(a[0], b, count, out))
+BENCH(CapsuleSphere,    "collision", "Distance(capsule, sphere)", capsule, sphere, r32, out[i] = Distance(a[i], b[i]))
+BENCH_ARRAY(CapsuleSphereBatch, "collision", "Distance(sphere, capsule[])", sphere, capsule, r32,
+            Distance(a[0], b, count, out))
+BENCH(CapsuleAABB,      "collision", "Distance(capsule, aabb)", capsule, aabb, r32, out[i] = Distance(a[i], b[i]))
+BENCH_ARRAY(CapsuleAABBBatch, "collision", "Distance(aabb, capsule[])", aabb, capsule, r32,
+            Distance(a[0], b, count, out))
+BENCH(CapsuleRay,       "collision", "Distance(capsule, ray3)", capsule, ray3, r32, out[i] = Distance(a[i], b[i]))
+BENCH_ARRAY(CapsuleRayBatch, "collision", "Distance(ray3, capsule[])", ray3, capsule, r32,
+            Distance(a[0], b, count, out))
+BENCH(SegSegParallel,   "collision", "DistanceSq(lineseg3, lineseg3) near-parallel", parallelseg, parallelseg, r32,
+      out[i] = DistanceSq(a[i].line, b[i].line))
+BENCH_ARRAY(SegSegParallelBatch, "collision", "DistanceSq(lineseg3[], lineseg3[]) near-parallel", parallelseg, parallelseg, r32,
+            DistanceSq((const lineseg3 *)a, (const lineseg3 *)b, count, out))
+BENCH(FrustumAABB,      "collision", "Intersects(frustum, aabb)", aabb, aabb, u32, out[i] = Intersects(GlobalFrustum, a[i]))
+BENCH_ARRAY(FrustumCull, "collision", "Cull(frustum, aabb[])",   aabb, aabb, u32,
+            Cull(GlobalFrustum, a, count, out))
+BENCH_ARRAY(FrustumCullSphere, "collision", "Cull(frustum, sphere[])", sphere, sphere, u32,
+            Cull(GlobalFrustum, a, count, out))
+
+// NOTE: Random planes through the unit cube the inputs fill, so every side
+//       comes up
+#define BENCH_CLASSIFY_PLANES 16
+
+static plane GlobalClassifyPlanes[BENCH_CLASSIFY_PLANES];
+
+BENCH_ARRAY(ClassifyPointsDist, "collision", "ClassifyPoints(plane, vec3[]) (dist)", vec3, u8, r32,
+            ClassifyPoints(GlobalClassifyPlanes[0], a, count, out, 0))
+BENCH_ARRAY(ClassifyPointsSide, "collision", "ClassifyPoints(plane, vec3[]) (side)", vec3, u8, u8,
+            ClassifyPoints(GlobalClassifyPlanes[0], a, count, 0, out, 0.01f))
+BENCH_ARRAY(ClassifySpheresSide, "collision", "ClassifySpheres(plane, sphere[]) (side)", sphere, u8, u8,
+            ClassifySpheres(GlobalClassifyPlanes[0], a, count, 0, out))
+// NOTE: 16 rows of count / 32 words fit the count words of out
+BENCH_ARRAY(ClassifyPointsMasks, "collision", "ClassifyPoints(plane[16], vec3[]) (masks)", vec3, u8, u32,
+            ClassifyPoints(GlobalClassifyPlanes, BENCH_CLASSIFY_PLANES, a, count, out))
+// NOTE: Every ray against a small mesh, nearest hit
+#define BENCH_MESH_SIZE 256
+
+static triangle GlobalMesh[BENCH_MESH_SIZE];
+static trianglex4 GlobalMeshx4[BENCH_MESH_SIZE / 4];
+static trianglex8 GlobalMeshx8[BENCH_MESH_SIZE / 8];
+
+static r32 RayCastMesh(const ray3 &r)
+{
+    r32 closest = FLT_MAX;
+
+    for(u32 i = 0; i < BENCH_MESH_SIZE; ++i)
+    {
+        r32 t, u, v;
+        if(Intersects(GlobalMesh[i], r, t, u, v, closest))
+            closest = t;
+    }
+
+    return closest;
+}
+
+BENCH(TriangleRay,      "collision", "Intersects(triangle, ray3) x256", ray3, ray3, r32, out[i] = RayCastMesh(a[i]))
+BENCH(TriangleRayx4,    "collision", "RayCastClosest(trianglex4[]) x256", ray3, ray3, r32,
+      u32 index; r32 u; r32 v; out[i] = -1.0f; RayCastClosest(GlobalMeshx4, BENCH_MESH_SIZE / 4, a[i], index, out[i], u, v))
+BENCH(TriangleRayx8,    "collision", "RayCastClosest(trianglex8[]) x256", ray3, ray3, r32,
+      u32 index; r32 u; r32 v; out[i] = -1.0f; RayCastClosest(GlobalMeshx8, BENCH_MESH_SIZE / 8, a[i], index, out[i], u, v))
+BENCH(BVHRayClosest,    "bvh", "RayCastClosest",  ray3, ray3, r32,
+      u32 index; out[i] = -1.0f; RayCastClosest(GlobalBVH, a[i], index, out[i]))
+BENCH(BVHRayAny,        "bvh", "RayCastAny",      ray3, ray3, u32, out[i] = RayCastAny(GlobalBVH, a[i]))
+BENCH(BVHOverlaps,      "bvh", "Overlaps",        aabb, aabb, u32, out[i] = Overlaps(GlobalBVH, a[i], out + i, 0))
+
+//
+// NOTE: aabbtree
+//
+
+#define BENCH_TREE_SIZE (1 << 16)
+
+static aabbtree GlobalAABBTree;
+static aabb GlobalTreeBoxes[BENCH_TREE_SIZE];
+static u32 GlobalTreeProxies[BENCH_TREE_SIZE];
+static aabbtreepair GlobalTreePairs[1 << 16];
+
+BENCH(TreeMoveStill,    "aabbtree", "Move (inside fat box)", aabb, aabb, u32,
+      u32 k = i % BENCH_TREE_SIZE; out[i] = Move(GlobalAABBTree, GlobalTreeProxies[k], GlobalTreeBoxes[k]))
+BENCH(TreeOverlaps,     "aabbtree", "Overlaps",        aabb, aabb, u32, out[i] = Overlaps(GlobalAABBTree, a[i], out + i, 0))
+// NOTE: Alternate runs shift every box past its fat bounds, so each Move reinserts
+static u32 GlobalTreeRun;
+
+BENCH_ARRAY(TreeMoveFindPairs, "aabbtree", "Move (reinsert) + FindPairs", aabb, vec3, u32,
+            vec3 shift = (++GlobalTreeRun & 1) ? Vec3(1.0f, 1.0f, 1.0f) : VEC3_ZERO;
+            for(u32 i = 0; i < count; ++i)
+            {
+                u32 k = i % BENCH_TREE_SIZE;
+                GlobalTreeBoxes[k] = AABB(a[i].min + shift, a[i].max + shift);
+                out[i] = Move(GlobalAABBTree, GlobalTreeProxies[k], GlobalTreeBoxes[k], 0.01f * b[i]);
+            }
+            out[0] = FindPairs(GlobalAABBTree, GlobalTreePairs, sizeof(GlobalTreePairs) / sizeof(GlobalTreePairs[0])))
+
+//
+// NOTE: sweepprune
+//
+
+static void *AllocAligned(size_t size);
+
+static sweepprune GlobalSweepPrune;
+static u32 GlobalSweepRun;
+
+// NOTE: A row of 20 unit cells of 4096 boxes each, so the density stays the
+//       same at every count. Every box jitters a little each run, so the list
+//       needs a few swaps and some pairs change. (Re)initialised when a larger
+//       count comes in.
+BENCH_ARRAY(SweepPruneUpdate, "sweepprune", "UpdateSweepPrune (jittered)", aabb, aabb, aabb,
+            if(count > GlobalSweepPrune.maxObjects)
+                InitSweepPrune(GlobalSweepPrune, AllocAligned(SweepPruneMemorySize(count, 4 * count)), count, 4 * count);
+            ++GlobalSweepRun;
+            for(u32 i = 0; i < count; ++i)
+            {
+                r32 jitter = 0.02f * (r32)(((i + GlobalSweepRun) * 2654435761u) >> 24) / 255.0f;
+                vec3 offset = Vec3(20.0f * (r32)(i >> 12) + jitter, 0.0f, 0.0f);
+                out[i] = AABB(a[i].min + offset, a[i].max + offset);
+            }
+            UpdateSweepPrune(GlobalSweepPrune, out, count, 0, 0))
+
+//
+// NOTE: spatialhash
+//
+
+#define BENCH_GRID_SIZE (1 << 16)
+
+static spatialhash GlobalSpatialHash;
+static vec3 GlobalGridPoints[BENCH_GRID_SIZE];
+static u32 GlobalGridResults[256];
+
+// NOTE: 8 points per unit cube, queries of about 4 neighbours
+BENCH(GridRadius,       "spatialhash", "Overlaps (radius 0.5)", vec3, vec3, u32,
+      out[i] = Overlaps(GlobalSpatialHash, 10.0f * a[i], 0.5f, GlobalGridResults, 256))
+BENCH(GridSphere,       "spatialhash", "Overlaps (sphere)", sphere, sphere, u32,
+      out[i] = Overlaps(GlobalSpatialHash, a[i], GlobalGridResults, 256))
+BENCH(GridAABB,         "spatialhash", "Overlaps (aabb)", aabb, aabb, u32,
+      out[i] = Overlaps(GlobalSpatialHash, a[i], GlobalGridResults, 256))
+
+// NOTE: The input points over 64000 cells, 16 per cell at 1M points.
+//       (Re)initialised when a larger count comes in.
+static spatialhash GlobalGridBuild;
+
+BENCH_ARRAY(GridBuild,  "spatialhash", "BuildSpatialHash", vec3, vec3, u32,
+            if(count > GlobalGridBuild.maxEntries)
+                InitSpatialHash(GlobalGridBuild, AllocAligned(SpatialHashMemorySize(count)), count, 0.05f);
+            BuildSpatialHash(GlobalGridBuild, a, count);
+            out[0] = GlobalGridBuild.cellCount)
+
+//
+// NOTE: gjk
+//
+
+#define BENCH_HULL_SIZE 32
+
+static vec3 GlobalHullPoints[BENCH_HULL_SIZE];
+static convex GlobalHullA,
+              GlobalHullB;
+static gjkcache GlobalGJKCache;
+static vec3 GlobalGJKNormal,
+            GlobalGJKPointA,
+            GlobalGJKPointB;
+
+// NOTE: Against the closed forms in "collision"
+BENCH(GJKCapsule,       "gjk", "Distance(convex, convex) (capsules)", capsule, capsule, r32,
+      out[i] = Distance(Convex(a[i]), Convex(b[i])))
+BENCH(GJKOBB,           "gjk", "Distance(convex, convex) (obbs)", obb, obb, r32,
+      out[i] = Distance(Convex(a[i]), Convex(b[i])))
+BENCH(GJKOBBIntersects, "gjk", "Intersects(convex, convex) (obbs)", obb, obb, u32,
+      out[i] = Intersects(Convex(a[i]), Convex(b[i])))
+
+// NOTE: Two 32 point hulls turning a little every element, the same motion
+//       with and without the cache
+BENCH(GJKHullCold,      "gjk", "Distance(convex, convex) (hulls, cold)", vec3, vec3, r32,
+      SetTransform(GlobalHullA, QuatAxisAngle(Vec3(0.0f, 1.0f, 0.0f), 0.01f * (r32)i), VEC3_ZERO);
+      SetTransform(GlobalHullB, QuatAxisAngle(Vec3(1.0f, 0.0f, 0.0f), 0.007f * (r32)i), Vec3(2.2f, 0.3f, 0.0f));
+      out[i] = Distance(GlobalHullA, GlobalHullB))
+BENCH(GJKHullWarm,      "gjk", "Distance(convex, convex) (hulls, warm)", vec3, vec3, r32,
+      SetTransform(GlobalHullA, QuatAxisAngle(Vec3(0.0f, 1.0f, 0.0f), 0.01f * (r32)i), VEC3_ZERO);
+      SetTransform(GlobalHullB, QuatAxisAngle(Vec3(1.0f, 0.0f, 0.0f), 0.007f * (r32)i), Vec3(2.2f, 0.3f, 0.0f));
+      out[i] = Distance(GlobalHullA, GlobalHullB, &GlobalGJKCache))
+
+BENCH(GJKPenetration,   "gjk", "Penetration(convex, convex) (capsules)", capsule, capsule, r32,
+      out[i] = 0.0f;
+      Penetration(Convex(a[i]), Convex(b[i]), GlobalGJKNormal, out[i], GlobalGJKPointA, GlobalGJKPointB))
+
+//
+// NOTE: Runtime dispatch, the same kernels through the table bound for this CPU
+//       (or --simd-level)
+//
+
+BENCH_ARRAY(DispatchTransformPoints, "dispatch", "TransformPoints", vec3, mat4, vec3,
+            dispatch::TransformPoints(b[0], a, out, count))
+BENCH_ARRAY(DispatchSlerpBatch, "dispatch", "SlerpBatch",  quat, quat, quat,
+            dispatch::SlerpBatch(a, b, 0.3f, out, count))
+BENCH_ARRAY(DispatchCull, "dispatch", "Cull(frustum, aabb[])", aabb, aabb, u32,
+            dispatch::Cull(GlobalFrustum, a, count, out))
+BENCH_ARRAY(DispatchSkinLinear, "dispatch", "SkinLinear", vec3, skinweights, vec3,
+            dispatch::SkinLinear(GlobalMatrixPalette, b, a, 0, out, 0, count))
+
+//
+// NOTE: Harness
+//
+
+// NOTE: Max component error against a double precision slerp (same hemisphere
+//       convention as the library) and max deviation from unit length
+struct accuracy
+{
+    double maxError,
+           maxNormError;
+};
+
+static void Accumulate(accuracy &acc, const quat &q, const double *ref)
+{
+    double e = Max(Max(fabs(q.w - ref[0]), fabs(q.x - ref[1])), Max(fabs(q.y - ref[2]), fabs(q.z - ref[3])));
+    double n = fabs(sqrt((double)q.w * q.w + (double)q.x * q.x + (double)q.y * q.y + (double)q.z * q.z) - 1.0);
+
+    acc.maxError = (e > acc.maxError) ? e : acc.maxError;
+    acc.maxNormError = (n > acc.maxNormError) ? n : acc.maxNormError;
+}
+
+static void ReferenceSlerp(const quat &start, const quat &end, double t, double *result)
+{
+    double s[4] = {start.w, start.x, start.y, start.z},
+           e[4] = {end.w, end.x, end.y, end.z},
+           cos = s[0] * e[0] + s[1] * e[1] + s[2] * e[2] + s[3] * e[3];
+
+    if(cos < EPSILON)
+    {
+        for(u32 i = 0; i < 4; ++i)
+            s[i] = -s[i];
+        cos = -cos;
+    }
+
+    double angle = acos(cos < 1.0 ? cos : 1.0),
+           sin = ::sin(angle),
+           st = (sin > 1e-12) ? ::sin((1.0 - t) * angle) / sin : 1.0 - t,
+           et = (sin > 1e-12) ? ::sin(t * angle) / sin : t;
+
+    for(u32 i = 0; i < 4; ++i)
+        result[i] = st * s[i] + et * e[i];
+}
+
+static void ReportQuatAccuracy(FILE *out)
+{
+    const u32 count = 1 << 16;
+    quat *start = (quat *)malloc(count * sizeof(quat)),
+         *end = (quat *)malloc(count * sizeof(quat)),
+         *batch = (quat *)malloc(count * sizeof(quat));
+    r32 *t = (r32 *)malloc(count * sizeof(r32));
+    double *ref = (double *)malloc(4 * count * sizeof(double));
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        Random(start[i]);
+        Random(end[i]);
+        t[i] = RandomUnilateral();
+        ReferenceSlerp(start[i], end[i], t[i], ref + 4 * i);
+    }
+
+    accuracy scalar[3] = {},
+             batched[5] = {};
+
+    SlerpBatch(start, end, t, batch, count);
+    for(u32 i = 0; i < count; ++i)
+    {
+        quat q;
+        Slerp(q, start[i], t[i], end[i]);
+        Accumulate(scalar[0], q, ref + 4 * i);
+        Accumulate(batched[0], batch[i], ref + 4 * i);
+    }
+
+    NlerpBatch(start, end, t, batch, count);
+    for(u32 i = 0; i < count; ++i)
+    {
+        quat q;
+        Lerp(q, start[i], t[i], end[i]);
+        Normalize(q);
+        Accumulate(scalar[1], q, ref + 4 * i);
+        Accumulate(batched[1], batch[i], ref + 4 * i);
+    }
+
+    NlerpBatch(start, end, t, batch, count, true);
+    for(u32 i = 0; i < count; ++i)
+        Accumulate(batched[2], batch[i], ref + 4 * i);
+
+    ApproxSlerpBatch(start, end, t, batch, count);
+    for(u32 i = 0; i < count; ++i)
+    {
+        quat q;
+        ApproxSlerp(q, start[i], t[i], end[i]);
+        Normalize(q);
+        Accumulate(scalar[2], q, ref + 4 * i);
+        Accumulate(batched[3], batch[i], ref + 4 * i);
+    }
+
+    // NOTE: Shared start, every lane against the same rotation
+    SlerpBatch(start[0], end, t, batch, count);
+    for(u32 i = 0; i < count; ++i)
+    {
+        double shared[4];
+        ReferenceSlerp(start[0], end[i], t[i], shared);
+        Accumulate(batched[4], batch[i], shared);
+    }
+
+    fprintf(out, "%-44s %12s %12s\n", "quat interpolation vs double slerp", "max error", "unit error");
+    fprintf(out, "%-44s %12.3g %12.3g\n", "Slerp", scalar[0].maxError, scalar[0].maxNormError);
+    fprintf(out, "%-44s %12.3g %12.3g\n", "SlerpBatch", batched[0].maxError, batched[0].maxNormError);
+    fprintf(out, "%-44s %12.3g %12.3g\n", "Lerp + Normalize", scalar[1].maxError, scalar[1].maxNormError);
+    fprintf(out, "%-44s %12.3g %12.3g\n", "NlerpBatch", batched[1].maxError, batched[1].maxNormError);
+    fprintf(out, "%-44s %12.3g %12.3g\n", "NlerpBatch (approx normalize)", batched[2].maxError, batched[2].maxNormError);
+    fprintf(out, "%-44s %12.3g %12.3g\n", "ApproxSlerp + Normalize", scalar[2].maxError, scalar[2].maxNormError);
+    fprintf(out, "%-44s %12.3g %12.3g\n", "ApproxSlerpBatch", batched[3].maxError, batched[3].maxNormError);
+    fprintf(out, "%-44s %12.3g %12.3g\n\n", "SlerpBatch (shared start)", batched[4].maxError, batched[4].maxNormError);
+
+    free(start);
+    free(end);
+    free(batch);
+    free(t);
+    free(ref);
+}
+
+// NOTE: Squared distance from p to the segment (o, d) in double
+static double ReferenceDistanceSq(const double *o, const double *d, const double *p)
+{
+    double w[3] = {p[0] - o[0], p[1] - o[1], p[2] - o[2]},
+           dd = d[0] * d[0] + d[1] * d[1] + d[2] * d[2],
+           t = (dd > 0.0) ? (w[0] * d[0] + w[1] * d[1] + w[2] * d[2]) / dd : 0.0;
+
+    t = (t < 0.0) ? 0.0 : ((t > 1.0) ? 1.0 : t);
+
+    double x = w[0] - t * d[0],
+           y = w[1] - t * d[1],
+           z = w[2] - t * d[2];
+
+    return x * x + y * y + z * z;
+}
+
+// NOTE: Distance between two segments in double, by a ternary search along
+//       lineA (the distance to lineB is convex in the parameter)
+static double ReferenceDistance(const lineseg3 &lineA, const lineseg3 &lineB)
+{
+    double oa[3] = {lineA.origin.x, lineA.origin.y, lineA.origin.z},
+           da[3] = {lineA.direction.x, lineA.direction.y, lineA.direction.z},
+           ob[3] = {lineB.origin.x, lineB.origin.y, lineB.origin.z},
+           db[3] = {lineB.direction.x, lineB.direction.y, lineB.direction.z},
+           lo = 0.0,
+           hi = 1.0;
+
+    for(u32 i = 0; i < 100; ++i)
+    {
+        double s1 = lo + (hi - lo) / 3.0,
+               s2 = hi - (hi - lo) / 3.0,
+               p1[3] = {oa[0] + s1 * da[0], oa[1] + s1 * da[1], oa[2] + s1 * da[2]},
+               p2[3] = {oa[0] + s2 * da[0], oa[1] + s2 * da[1], oa[2] + s2 * da[2]};
+
+        if(ReferenceDistanceSq(ob, db, p1) < ReferenceDistanceSq(ob, db, p2))
+            hi = s2;
+        else
+            lo = s1;
+    }
+
+    double p[3] = {oa[0] + lo * da[0], oa[1] + lo * da[1], oa[2] + lo * da[2]};
+
+    return sqrt(ReferenceDistanceSq(ob, db, p));
+}
+
+// NOTE: Max distance error of the near-parallel segment pairs of the
+//       SegSegParallel benches, scalar against double and batched against
+//       scalar. Then spheres centred on capsule axes, where the exact distance
+//       is minus the radii (a NaN counts as an infinite error).
+static void ReportSegmentAccuracy(FILE *out)
+{
+    const u32 count = 1 << 14;
+    parallelseg *a = (parallelseg *)malloc(count * sizeof(parallelseg)),
+                *b = (parallelseg *)malloc(count * sizeof(parallelseg));
+    capsule *capsules = (capsule *)malloc(count * sizeof(capsule));
+    r32 *batch = (r32 *)malloc(count * sizeof(r32));
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        Random(a[i]);
+        Random(b[i]);
+    }
+
+    DistanceSq((const lineseg3 *)a, (const lineseg3 *)b, count, batch);
+
+    double scalarError = 0.0,
+           batchError = 0.0;
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        double scalar = sqrt(DistanceSq(a[i].line, b[i].line)),
+               e = fabs(scalar - ReferenceDistance(a[i].line, b[i].line)),
+               eb = fabs(sqrt(batch[i]) - scalar);
+
+        scalarError = (e > scalarError) ? e : scalarError;
+        batchError = (eb > batchError) ? eb : batchError;
+    }
+
+    sphere s = Sphere(Vec3(0.3f, -0.2f, 0.7f), 0.1f);
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        vec3 d;
+        Random(d);
+        Random(capsules[i]);
+
+        capsules[i].segment = LineSeg3(s.origin - RandomUnilateral() * d, d);
+    }
+
+    Distance(s, capsules, count, batch);
+
+    double capsuleError = 0.0,
+           capsuleBatchError = 0.0;
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        double exact = -(double)(capsules[i].radius + s.radius),
+               e = fabs(Distance(capsules[i], s) - exact),
+               eb = fabs(batch[i] - exact);
+
+        e = (e == e) ? e : INFINITY;
+        eb = (eb == eb) ? eb : INFINITY;
+
+        capsuleError = (e > capsuleError) ? e : capsuleError;
+        capsuleBatchError = (eb > capsuleBatchError) ? eb : capsuleBatchError;
+    }
+
+    fprintf(out, "%-44s %12s\n", "segment distance", "max error");
+    fprintf(out, "%-44s %12.3g\n", "DistanceSq near-parallel vs double", scalarError);
+    fprintf(out, "%-44s %12.3g\n", "DistanceSq[] near-parallel vs scalar", batchError);
+    fprintf(out, "%-44s %12.3g\n", "Distance(capsule, sphere) centre on axis", capsuleError);
+    fprintf(out, "%-44s %12.3g\n\n", "Distance(sphere, capsule[]) centre on axis", capsuleBatchError);
+
+    free(a);
+    free(b);
+    free(capsules);
+    free(batch);
+}
+
+static void *AllocAligned(size_t size)
+{
+    // NOTE: 64 bytes alignment so the batch functions can take their aligned paths
+    size = (size + 63) & ~(size_t)63;
+#if defined(_MSC_VER)
+    return _aligned_malloc(size, 64);
+#else
+    return aligned_alloc(64, size);
+#endif
+}
+
+static void FreeAligned(void *p)
+{
+#if defined(_MSC_VER)
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+// NOTE: BuildHierarchy on parent chains around HIERARCHY_MAX_DEPTH and on a
+//       cycle, the bad ones must fail and leave an empty hierarchy
+static void ReportHierarchyLimits(FILE *out)
+{
+    const u32 count = 300;
+    u32 parents[count],
+        remap[count];
+    void *memory = AllocAligned(HierarchyMemorySize(count));
+    hierarchy h;
+
+    u32 depths[] = {HIERARCHY_MAX_DEPTH, HIERARCHY_MAX_DEPTH + 1, count};
+
+    fprintf(out, "%-44s %12s\n", "BuildHierarchy limits", "result");
+
+    for(u32 i = 0; i < sizeof(depths) / sizeof(depths[0]); ++i)
+    {
+        u32 depth = depths[i];
+
+        for(u32 j = 0; j < depth; ++j)
+            parents[j] = (j == 0) ? HIERARCHY_ROOT : j - 1;
+
+        b32 built = BuildHierarchy(h, memory, parents, depth, remap),
+            ok = (depth <= HIERARCHY_MAX_DEPTH) ? (built && h.levelCount == depth)
+                                                : (!built && h.count == 0 && h.levelCount == 0);
+        char name[64];
+        snprintf(name, sizeof(name), "chain of %u levels (%s)", depth, built ? "built" : "rejected");
+        fprintf(out, "%-44s %12s\n", name, ok ? "ok" : "FAILED");
+    }
+
+    parents[0] = HIERARCHY_ROOT;
+    parents[1] = 2;
+    parents[2] = 1;
+
+    b32 built = BuildHierarchy(h, memory, parents, 3, remap);
+    fprintf(out, "%-44s %12s\n\n", "cycle (rejected)", (!built && h.count == 0) ? "ok" : "FAILED");
+
+    FreeAligned(memory);
+}
+
+// NOTE: Moves fat boxes around 1e5, where a margin is below the relative
+//       epsilon of AreEqual, then checks every interior node still contains
+//       its children and that each proxy is found from the corners of its box
+static void ReportAABBTreeContainment(FILE *out)
+{
+    const u32 count = 20000,
+              steps = 8;
+    aabbtree tree;
+    void *memory = AllocAligned(AABBTreeMemorySize(count));
+    u32 *proxies = (u32 *)AllocAligned(count * sizeof(u32)),
+        *results = (u32 *)AllocAligned(count * sizeof(u32));
+    vec3 *centres = (vec3 *)AllocAligned(count * sizeof(vec3));
+
+    InitAABBTree(tree, memory, count, 0.05f);
+
+    vec3 half = Vec3(0.5f, 0.5f, 0.5f);
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        centres[i] = Vec3(1.0e5f + 100.0f * RandomUnilateral(),
+                          1.0e5f + 100.0f * RandomUnilateral(),
+                          1.0e5f + 100.0f * RandomUnilateral());
+        proxies[i] = Insert(tree, AABB(centres[i] - half, centres[i] + half), i);
+    }
+
+    for(u32 step = 0; step < steps; ++step)
+    {
+        for(u32 i = 0; i < count; ++i)
+        {
+            vec3 d = 0.04f * Vec3(RandomBilateral(), RandomBilateral(), RandomBilateral());
+            centres[i] += d;
+            Move(tree, proxies[i], AABB(centres[i] - half, centres[i] + half), d);
+        }
+    }
+
+    u32 badNodes = 0;
+
+    for(u32 i = 0; i < tree.capacity; ++i)
+    {
+        const aabbtreenode &node = tree.nodes[i];
+
+        if(node.height > 0 && (!Contains(node.bounds, tree.nodes[node.left].bounds) ||
+                               !Contains(node.bounds, tree.nodes[node.right].bounds)))
+            ++badNodes;
+    }
+
+    u32 missed = 0;
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        const aabb &fat = GetFatBounds(tree, proxies[i]);
+        vec3 corners[] = {fat.min, fat.max};
+
+        for(u32 c = 0; c < 2; ++c)
+        {
+            u32 found = Overlaps(tree, AABB(corners[c], corners[c]), results, count);
+            b32 hit = false;
+
+            for(u32 j = 0; j < found && j < count; ++j)
+                hit |= (results[j] == i);
+
+            missed += !hit;
+        }
+    }
+
+    char name[64];
+    fprintf(out, "%-44s %12s\n", "aabbtree containment at 1e5", "result");
+    snprintf(name, sizeof(name), "interior nodes not containing children: %u", badNodes);
+    fprintf(out, "%-44s %12s\n", name, (badNodes == 0) ? "ok" : "FAILED");
+    snprintf(name, sizeof(name), "corner queries missing the proxy: %u", missed);
+    fprintf(out, "%-44s %12s\n\n", name, (missed == 0) ? "ok" : "FAILED");
+
+    FreeAligned(centres);
+    FreeAligned(results);
+    FreeAligned(proxies);
+    FreeAligned(memory);
+}
+
+static double Now()
+{
+    using namespace std::chrono;
+    return duration<double, std::nano>(steady_clock::now().time_since_epoch()).count();
+}
+
+// NOTE: Spatial hash queries whose bounds cover far more cells than are
+//       occupied (huge, infinite or at the end of the s32 cell range), against
+//       a brute force count. Each must finish quickly and match.
+static void ReportSpatialHashRanges(FILE *out)
+{
+    const u32 count = 1000;
+    spatialhash hash;
+    void *memory = AllocAligned(SpatialHashMemorySize(count));
+    vec3 *points = (vec3 *)AllocAligned(count * sizeof(vec3));
+    u32 *results = (u32 *)AllocAligned(count * sizeof(u32));
+
+    InitSpatialHash(hash, memory, count, 0.05f);
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        Random(points[i]);
+        points[i] *= 10.0f;
+    }
+
+    // NOTE: A few points near the largest cell coordinates
+    points[0] = Vec3(1.0e8f, 1.0e8f, 1.0e8f);
+    points[1] = Vec3(-1.0e8f, -1.0e8f, -1.0e8f);
+    BuildSpatialHash(hash, points, count);
+
+    r32 inf = INFINITY;
+    aabb boxes[] =
+    {
+        AABB(Vec3(-1.0e30f, -1.0e30f, -1.0e30f), Vec3(1.0e30f, 1.0e30f, 1.0e30f)),
+        AABB(Vec3(-inf, -inf, -inf), Vec3(inf, inf, inf)),
+        AABB(Vec3(-5.0f, -5.0f, -5.0f), Vec3(inf, inf, inf)),
+        AABB(Vec3(9.0e7f, 9.0e7f, 9.0e7f), Vec3(1.0e9f, 1.0e9f, 1.0e9f)),
+    };
+    const char *names[] = {"aabb +-1e30", "aabb +-inf", "aabb -5 to inf", "aabb 9e7 to 1e9"};
+
+    fprintf(out, "%-44s %12s %12s\n", "spatialhash wide queries", "ms", "result");
+
+    for(u32 i = 0; i < sizeof(boxes) / sizeof(boxes[0]); ++i)
+    {
+        const aabb &bb = boxes[i];
+        u32 expected = 0;
+
+        for(u32 j = 0; j < count; ++j)
+        {
+            const vec3 &p = points[j];
+            expected += (bb.min.x <= p.x && p.x <= bb.max.x && bb.min.y <= p.y && p.y <= bb.max.y
+                         && bb.min.z <= p.z && p.z <= bb.max.z);
+        }
+
+        double start = Now();
+        u32 found = Overlaps(hash, bb, results, count);
+        double ms = 1.0e-6 * (Now() - start);
+
+        fprintf(out, "%-44s %12.3f %12s\n", names[i], ms, (found == expected) ? "ok" : "FAILED");
+    }
+
+    r32 radii[] = {1.0e30f, 2.0e8f};
+    const char *radiusNames[] = {"radius 1e30", "radius 2e8"};
+
+    for(u32 i = 0; i < sizeof(radii) / sizeof(radii[0]); ++i)
+    {
+        double start = Now();
+        u32 found = Overlaps(hash, VEC3_ZERO, radii[i], results, count);
+        double ms = 1.0e-6 * (Now() - start);
+
+        fprintf(out, "%-44s %12.3f %12s\n", radiusNames[i], ms, (found == count) ? "ok" : "FAILED");
+    }
+
+    fprintf(out, "\n");
+
+    FreeAligned(results);
+    FreeAligned(points);
+    FreeAligned(memory);
+}
+
+static volatile u32 GlobalEvictSink;
+
+static void EvictCaches(u8 *scratch, u32 size)
+{
+    u32 sum = 0;
+    for(u32 i = 0; i < size; i += 64)
+    {
+        scratch[i] = (u8)(scratch[i] + 1);
+        sum += scratch[i];
+    }
+    GlobalEvictSink = sum;
+}
+
+static int CompareDouble(const void *a, const void *b)
+{
+    double x = *(const double *)a,
+           y = *(const double *)b;
+    return (x < y) ? -1 : (x > y) ? 1 : 0;
+}
+
+static bench_result Run(const bench_case &c, u32 largeCount, double warmNs, u8 *evict)
+{
+    bench_result result = {};
+
+    u32 sizeA = c.sizeA * largeCount,
+        sizeB = c.sizeB * largeCount,
+        sizeOut = c.sizeOut * largeCount;
+
+    u8 *a = (u8 *)AllocAligned(sizeA);
+    u8 *b = (u8 *)AllocAligned(sizeB);
+    u8 *out = (u8 *)AllocAligned(sizeOut);
+
+    c.fillA(a, largeCount);
+    c.fillB(b, largeCount);
+    memset(out, 0, sizeOut);
+
+    // NOTE: Warm, repeat the small set until a trial is long enough to time
+    u32 passes = 1;
+    for(;;)
+    {
+        double start = Now();
+        for(u32 p = 0; p < passes; ++p)
+            c.kernel(a, b, out, BENCH_SMALL_COUNT);
+        double elapsed = Now() - start;
+
+        if(elapsed >= warmNs || passes >= (1u << 24))
+            break;
+        passes *= 2;
+    }
+
+    result.warmNs = 1.0e30;
+    for(u32 t = 0; t < BENCH_WARM_TRIALS; ++t)
+    {
+        double start = Now();
+        for(u32 p = 0; p < passes; ++p)
+            c.kernel(a, b, out, BENCH_SMALL_COUNT);
+        double ns = (Now() - start) / ((double)passes * BENCH_SMALL_COUNT);
+        if(ns < result.warmNs)
+            result.warmNs = ns;
+    }
+
+    // NOTE: Cold, flush before every single pass
+    double cold[BENCH_COLD_PASSES];
+    for(u32 t = 0; t < BENCH_COLD_PASSES; ++t)
+    {
+        EvictCaches(evict, BENCH_EVICT_BYTES);
+        double start = Now();
+        c.kernel(a, b, out, BENCH_SMALL_COUNT);
+        cold[t] = (Now() - start) / BENCH_SMALL_COUNT;
+    }
+    qsort(cold, BENCH_COLD_PASSES, sizeof(double), CompareDouble);
+    result.coldNs = cold[BENCH_COLD_PASSES / 2];
+
+    // NOTE: Large, best of two streaming passes
+    result.largeNs = 1.0e30;
+    for(u32 t = 0; t < 2; ++t)
+    {
+        double start = Now();
+        c.kernel(a, b, out, largeCount);
+        double ns = (Now() - start) / largeCount;
+        if(ns < result.largeNs)
+            result.largeNs = ns;
+    }
+    result.largeCount = largeCount;
+    result.largeGBs = (double)(c.sizeA + c.sizeB + c.sizeOut) / result.largeNs;
+
+    FreeAligned(a);
+    FreeAligned(b);
+    FreeAligned(out);
+
+    return result;
+}
+
+static const char *SIMDName()
+{
+#if defined(AAMATH_AVX2)
+    return "AVX2";
+#elif defined(AAMATH_SSE4)
+    return "SSE4";
+#else
+    return "NONE";
+#endif
+}
+
+#if defined(AAMATH_STRICT)
+static const b32 GlobalStrict = true;
+#else
+static const b32 GlobalStrict = false;
+#endif
+
+#if defined(AAMATH_LIBM_TRIG)
+static const b32 GlobalLibmTrig = true;
+#else
+static const b32 GlobalLibmTrig = false;
+#endif
+
+static void PrintJSONString(FILE *f, const char *s)
+{
+    fputc('"', f);
+    for(; *s; ++s)
+    {
+        if(*s == '"' || *s == '\\')
+            fputc('\\', f);
+        fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+static void SetupScenes()
+{
+    // NOTE: A view frustum looking down -z that keeps roughly half of the random boxes
+    mat4 view = LookAt(Vec3(0.0f, 0.0f, 12.0f), Vec3(0.0f, 0.0f, 0.0f), Vec3(0.0f, 1.0f, 0.0f));
+    GlobalFrustum = Frustum(Perspective(60.0f, 16.0f / 9.0f, 0.1f, 100.0f) * view);
+
+    static aabb boxes[1 << 16];
+    static bvhnode nodes[2 * (1 << 16)];
+    static u32 indices[1 << 16];
+    static vec3 centroids[1 << 16];
+    u32 count = sizeof(boxes) / sizeof(boxes[0]);
+
+    for(u32 i = 0; i < count; ++i)
+        Random(boxes[i]);
+
+    BuildBVH(GlobalBVH, boxes, count, nodes, indices, centroids);
+
+    for(u32 i = 0; i < BENCH_CLASSIFY_PLANES; ++i)
+        Random(GlobalClassifyPlanes[i]);
+
+    for(u32 i = 0; i < BENCH_MESH_SIZE; ++i)
+        Random(GlobalMesh[i]);
+
+    PackTriangles(GlobalMesh, BENCH_MESH_SIZE, GlobalMeshx4);
+    PackTriangles(GlobalMesh, BENCH_MESH_SIZE, GlobalMeshx8);
+
+    InitAABBTree(GlobalAABBTree, AllocAligned(AABBTreeMemorySize(BENCH_TREE_SIZE)), BENCH_TREE_SIZE, 0.05f);
+
+    for(u32 i = 0; i < BENCH_TREE_SIZE; ++i)
+    {
+        Random(GlobalTreeBoxes[i]);
+        GlobalTreeProxies[i] = Insert(GlobalAABBTree, GlobalTreeBoxes[i], i);
+    }
+
+    FindPairs(GlobalAABBTree, GlobalTreePairs, sizeof(GlobalTreePairs) / sizeof(GlobalTreePairs[0]));
+
+    InitSpatialHash(GlobalSpatialHash, AllocAligned(SpatialHashMemorySize(BENCH_GRID_SIZE)), BENCH_GRID_SIZE, 0.5f);
+
+    for(u32 i = 0; i < BENCH_GRID_SIZE; ++i)
+    {
+        Random(GlobalGridPoints[i]);
+        GlobalGridPoints[i] *= 10.0f;
+    }
+
+    BuildSpatialHash(GlobalSpatialHash, GlobalGridPoints, BENCH_GRID_SIZE);
+
+    for(u32 i = 0; i < BENCH_HULL_SIZE; ++i)
+    {
+        Random(GlobalHullPoints[i]);
+        GlobalHullPoints[i] = Normalized(GlobalHullPoints[i]);
+    }
+
+    GlobalHullA = Convex(GlobalHullPoints, BENCH_HULL_SIZE);
+    GlobalHullB = Convex(GlobalHullPoints, BENCH_HULL_SIZE);
+
+    // NOTE: Random recursive tree, about 25 levels deep
+    static u32 parents[BENCH_HIERARCHY_SIZE];
+    static u32 remap[BENCH_HIERARCHY_SIZE];
+
+    for(u32 i = 0; i < BENCH_HIERARCHY_SIZE; ++i)
+        parents[i] = (i < 16) ? HIERARCHY_ROOT : RandomU32() % i;
+
+    BuildHierarchy(GlobalHierarchy, AllocAligned(HierarchyMemorySize(BENCH_HIERARCHY_SIZE)),
+                   parents, BENCH_HIERARCHY_SIZE, remap);
+
+    for(u32 i = 0; i < BENCH_HIERARCHY_SIZE; ++i)
+    {
+        transform local;
+        Random(local);
+        SetLocal(GlobalHierarchy, i, local);
+    }
+
+    UpdateHierarchy(GlobalHierarchy);
+
+    for(u32 i = 0; i < BENCH_PALETTE_SIZE; ++i)
+    {
+        Random(GlobalDualQuatPalette[i]);
+        GlobalMatrixPalette[i] = ToMat4(GlobalDualQuatPalette[i]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *filter = 0,
+               *jsonPath = 0;
+    u32 largeCount = 1 << 20;
+    double warmNs = 2.0e6;
+    b32 accuracyReport = false;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        if(strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+            filter = argv[++i];
+        else if(strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+            jsonPath = argv[++i];
+        else if(strcmp(argv[i], "--large") == 0 && i + 1 < argc)
+            largeCount = (u32)strtoul(argv[++i], 0, 10);
+        else if(strcmp(argv[i], "--simd-level") == 0 && i + 1 < argc)
+        {
+            const char *name = argv[++i];
+            u32 level = 0;
+
+            while(level < SIMD_LEVEL_COUNT && strcmp(name, SIMDLevelName((simdlevel)level)) != 0)
+                ++level;
+
+            if(level == SIMD_LEVEL_COUNT)
+            {
+                fprintf(stderr, "unknown level %s (scalar, sse4.1, avx2, avx512)\n", name);
+                return 1;
+            }
+
+            SetSIMDLevel((simdlevel)level);
+        }
+        else if(strcmp(argv[i], "--accuracy") == 0)
+            accuracyReport = true;
+        else if(strcmp(argv[i], "--quick") == 0)
+        {
+            largeCount = 1 << 16;
+            warmNs = 2.0e5;
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--filter text] [--large count] [--json file|-] [--quick] [--accuracy] [--simd-level name]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if(largeCount < BENCH_SMALL_COUNT)
+        largeCount = BENCH_SMALL_COUNT;
+
+    FILE *json = 0;
+    if(jsonPath)
+    {
+        json = (strcmp(jsonPath, "-") == 0) ? stdout : fopen(jsonPath, "w");
+        if(!json)
+        {
+            fprintf(stderr, "cannot open %s\n", jsonPath);
+            return 1;
+        }
+    }
+
+    // NOTE: The table goes to stderr when the JSON is on stdout
+    FILE *table = (json == stdout) ? stderr : stdout;
+
+    SetupScenes();
+
+    u8 *evict = (u8 *)malloc(BENCH_EVICT_BYTES);
+    memset(evict, 1, BENCH_EVICT_BYTES);
+
+    fprintf(table, "simd: %s%s%s, dispatch: %s (detected %s), large: %u elements\n\n", SIMDName(),
+            GlobalStrict ? " strict" : "", GlobalLibmTrig ? " libm_trig" : "",
+            SIMDLevelName(GetSIMDLevel()), SIMDLevelName(DetectSIMDLevel()), largeCount);
+    if(accuracyReport)
+    {
+        ReportQuatAccuracy(table);
+        ReportSegmentAccuracy(table);
+        ReportHierarchyLimits(table);
+        ReportAABBTreeContainment(table);
+        ReportSpatialHashRanges(table);
+    }
+
+    fprintf(table, "%-10s %-36s %10s %10s %10s %10s\n", "group", "name", "warm ns", "cold ns", "large ns", "GB/s");
+
+    if(json)
+    {
+        fprintf(json, "{\n  \"config\": {\"simd\": \"%s\", \"strict\": %s, \"libm_trig\": %s, "
+                "\"dispatch\": \"%s\", \"small_count\": %u, \"large_count\": %u, \"evict_bytes\": %u},\n  \"results\": [",
+                SIMDName(), GlobalStrict ? "true" : "false", GlobalLibmTrig ? "true" : "false",
+                SIMDLevelName(GetSIMDLevel()), BENCH_SMALL_COUNT, largeCount, BENCH_EVICT_BYTES);
+    }
+
+    u32 run = 0;
+    for(bench_case *c = GlobalFirstCase; c; c = c->next)
+    {
+        if(filter && !strstr(c->group, filter) && !strstr(c->name, filter))
+            continue;
+
+        bench_result r = Run(*c, largeCount, warmNs, evict);
+
+        fprintf(table, "%-10s %-36s %10.2f %10.2f %10.2f %10.2f\n",
+                c->group, c->name, r.warmNs, r.coldNs, r.largeNs, r.largeGBs);
+        fflush(table);
+
+        if(json)
+        {
+            fprintf(json, "%s\n    {\"group\": ", run ? "," : "");
+            PrintJSONString(json, c->group);
+            fprintf(json, ", \"name\": ");
+            PrintJSONString(json, c->name);
+            fprintf(json, ", \"bytes_per_op\": %u, \"warm_ns\": %.4f, \"cold_ns\": %.4f, "
+                    "\"large_ns\": %.4f, \"large_gbs\": %.4f}",
+                    c->sizeA + c->sizeB + c->sizeOut, r.warmNs, r.coldNs, r.largeNs, r.largeGBs);
+        }
+        ++run;
+    }
+
+    if(json)
+    {
+        fprintf(json, "\n  ]\n}\n");
+        if(json != stdout)
+            fclose(json);
+    }
+
+    free(evict);
+
+    return 0;
+}
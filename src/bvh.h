@@ -0,0 +1,611 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include "aamath.h"
+#include "vec3.h"
+#include "collision.h"
+
+namespace aam {
+
+// NOTE: Bounding volume hierarchy over an array of aabb. The nodes are stored
+//       flattened in depth-first order: the left child of an interior node is the
+//       next node in the array and 'first' holds the index of the right child.
+//       For leaves 'first' indexes into the primitive index array and 'count' is
+//       the number of primitives (interior nodes have count == 0).
+//       All memory is owned by the caller, see BVHNodeCapacity().
+
+#define BVH_BIN_COUNT   12
+#define BVH_MAX_DEPTH   64
+
+typedef struct _bvhnode
+{
+    aabb bounds;
+    u32 first,
+        count;
+} bvhnode;
+
+typedef struct _bvh
+{
+    bvhnode *nodes;
+    u32 *indices;
+    const aabb *boxes;
+    u32 nodeCount,
+        count;
+} bvh;
+
+// NOTE: Upper bound of the node count for a tree over count primitives
+inline u32 BVHNodeCapacity(u32 count)
+{
+    return (count > 0) ? 2 * count - 1 : 1;
+}
+
+inline aabb BVHEmptyBounds()
+{
+    return AABB(Vec3(FLT_MAX, FLT_MAX, FLT_MAX), Vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX));
+}
+
+inline void BVHSwap(u32 *indices, vec3 *centroids, u32 a, u32 b)
+{
+    u32 index = indices[a];
+    vec3 centroid = centroids[a];
+
+    indices[a] = indices[b];
+    centroids[a] = centroids[b];
+    indices[b] = index;
+    centroids[b] = centroid;
+}
+
+// NOTE: Partitions [start, end) around the median centroid on the given axis
+//       (quickselect), returns the split point
+inline u32 BVHMedianSplit(u32 *indices, vec3 *centroids, u32 start, u32 end, u32 axis)
+{
+    u32 mid = start + (end - start) / 2,
+        lo = start,
+        hi = end - 1;
+
+    while(lo < hi)
+    {
+        r32 pivot = centroids[(lo + hi) / 2].E[axis];
+        u32 i = lo,
+            j = hi;
+
+        while(i <= j)
+        {
+            while(centroids[i].E[axis] < pivot) ++i;
+            while(centroids[j].E[axis] > pivot) --j;
+
+            if(i <= j)
+            {
+                BVHSwap(indices, centroids, i, j);
+                ++i;
+                if(j == 0)
+                    break;
+                --j;
+            }
+        }
+
+        if(mid <= j)
+            hi = j;
+        else if(mid >= i)
+            lo = i;
+        else
+            break;
+    }
+
+    return mid;
+}
+
+// NOTE: Binned SAH split of [start, end), returns the split point or 'end' when
+//       keeping the primitives in a leaf is cheaper than any split
+inline u32 BVHSAHSplit(const bvh &tree, vec3 *centroids, u32 start, u32 end,
+                       const aabb &bounds, const aabb &centroidBounds, u32 maxLeafSize)
+{
+    u32 count = end - start,
+        bestAxis = 0,
+        bestBin = 0;
+    r32 bestCost = FLT_MAX;
+
+    for(u32 axis = 0; axis < 3; ++axis)
+    {
+        r32 lo = centroidBounds.min.E[axis],
+            extent = centroidBounds.max.E[axis] - lo;
+
+        if(extent <= 0.0f)
+            continue;
+
+        aabb binBounds[BVH_BIN_COUNT];
+        u32 binCounts[BVH_BIN_COUNT] = {};
+        r32 scale = (r32)BVH_BIN_COUNT / extent;
+
+        for(u32 i = 0; i < BVH_BIN_COUNT; ++i)
+            binBounds[i] = BVHEmptyBounds();
+
+        for(u32 i = start; i < end; ++i)
+        {
+            u32 bin = (u32)((centroids[i].E[axis] - lo) * scale);
+            if(bin >= BVH_BIN_COUNT)
+                bin = BVH_BIN_COUNT - 1;
+
+            binCounts[bin]++;
+            binBounds[bin] = Union(binBounds[bin], tree.boxes[tree.indices[i]]);
+        }
+
+        // NOTE: Sweep from the right to get the area/count of every right side,
+        //       then from the left evaluating each of the BVH_BIN_COUNT - 1 planes
+        r32 rightArea[BVH_BIN_COUNT];
+        u32 rightCount[BVH_BIN_COUNT];
+        aabb acc = BVHEmptyBounds();
+        u32 n = 0;
+
+        for(u32 i = BVH_BIN_COUNT - 1; i > 0; --i)
+        {
+            acc = Union(acc, binBounds[i]);
+            n += binCounts[i];
+            rightArea[i] = (n > 0) ? SurfaceArea(acc) : 0.0f;
+            rightCount[i] = n;
+        }
+
+        acc = BVHEmptyBounds();
+        n = 0;
+
+        for(u32 i = 0; i < BVH_BIN_COUNT - 1; ++i)
+        {
+            acc = Union(acc, binBounds[i]);
+            n += binCounts[i];
+
+            if(n == 0 || rightCount[i + 1] == 0)
+                continue;
+
+            r32 cost = n * SurfaceArea(acc) + rightCount[i + 1] * rightArea[i + 1];
+            if(cost < bestCost)
+            {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = i;
+            }
+        }
+    }
+
+    // NOTE: All centroids coincide, split down the middle if the leaf is too big
+    if(bestCost == FLT_MAX)
+        return (count > maxLeafSize) ? start + count / 2 : end;
+
+    // NOTE: Traversal cost of 1 against an intersection cost of 1 per primitive
+    r32 leafCost = count * SurfaceArea(bounds);
+    if(count <= maxLeafSize && 1.0f * SurfaceArea(bounds) + bestCost >= leafCost)
+        return end;
+
+    r32 lo = centroidBounds.min.E[bestAxis],
+        scale = (r32)BVH_BIN_COUNT / (centroidBounds.max.E[bestAxis] - lo);
+    u32 i = start,
+        j = end;
+
+    while(i < j)
+    {
+        u32 bin = (u32)((centroids[i].E[bestAxis] - lo) * scale);
+        if(bin >= BVH_BIN_COUNT)
+            bin = BVH_BIN_COUNT - 1;
+
+        if(bin <= bestBin)
+            ++i;
+        else
+            BVHSwap(tree.indices, centroids, i, --j);
+    }
+
+    return i;
+}
+
+// NOTE: Builds the tree over boxes[0..count). nodes must hold BVHNodeCapacity(count)
+//       entries, indices and centroids (build scratch) count entries each.
+//       The boxes are referenced, not copied, and must outlive the tree.
+inline void BuildBVH(bvh &tree, const aabb *boxes, u32 count,
+                     bvhnode *nodes, u32 *indices, vec3 *centroids, u32 maxLeafSize = 4)
+{
+    AAM_Assert(nodes && (count == 0 || (boxes && indices && centroids)));
+    AAM_Assert(maxLeafSize > 0);
+
+    tree.nodes = nodes;
+    tree.indices = indices;
+    tree.boxes = boxes;
+    tree.count = count;
+    tree.nodeCount = 1;
+
+    nodes[0].bounds = BVHEmptyBounds();
+    nodes[0].first = 0;
+    nodes[0].count = 0;
+
+    if(count == 0)
+        return;
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        indices[i] = i;
+        centroids[i] = Centre(boxes[i]);
+    }
+
+    // NOTE: side is 0 for the root, 1 for a left and 2 for a right child
+    struct
+    {
+        u32 side,
+            parent,
+            start,
+            end,
+            depth;
+    } stack[BVH_MAX_DEPTH + 2];
+    u32 top = 0;
+
+    stack[top].side = 0;
+    stack[top].parent = 0;
+    stack[top].start = 0;
+    stack[top].end = count;
+    stack[top].depth = 0;
+    ++top;
+
+    while(top > 0)
+    {
+        --top;
+        u32 start = stack[top].start,
+            end = stack[top].end,
+            depth = stack[top].depth,
+            nodeIndex = tree.nodeCount - 1;
+
+        // NOTE: Right children are popped after the whole left subtree was emitted,
+        //       so this is where the parent learns the index of its right child
+        if(stack[top].side != 0)
+        {
+            nodeIndex = tree.nodeCount++;
+            if(stack[top].side == 2)
+                nodes[stack[top].parent].first = nodeIndex;
+        }
+
+        bvhnode *node = nodes + nodeIndex;
+
+        aabb bounds = boxes[indices[start]];
+        for(u32 i = start + 1; i < end; ++i)
+            bounds = Union(bounds, boxes[indices[i]]);
+
+        aabb centroidBounds = AABB(centroids + start, end - start);
+        u32 split = end;
+
+        if(end - start > 1)
+        {
+            if(depth + 1 >= BVH_MAX_DEPTH)
+            {
+                // NOTE: Out of stack depth, leave the rest in one leaf
+                split = end;
+            }
+            else if(depth >= BVH_MAX_DEPTH / 2)
+            {
+                // NOTE: Degenerate input, force balanced splits from here on
+                vec3 d = centroidBounds.max - centroidBounds.min;
+                u32 axis = (d.x > d.y) ? ((d.x > d.z) ? 0 : 2) : ((d.y > d.z) ? 1 : 2);
+                split = BVHMedianSplit(indices, centroids, start, end, axis);
+            }
+            else
+            {
+                split = BVHSAHSplit(tree, centroids, start, end, bounds, centroidBounds, maxLeafSize);
+            }
+        }
+
+        node->bounds = bounds;
+
+        if(split == end || split == start)
+        {
+            node->first = start;
+            node->count = end - start;
+            continue;
+        }
+
+        node->first = 0;
+        node->count = 0;
+
+        // NOTE: Push the right half first so the left one is emitted right after its parent
+        stack[top].side = 2;
+        stack[top].parent = nodeIndex;
+        stack[top].start = split;
+        stack[top].end = end;
+        stack[top].depth = depth + 1;
+        ++top;
+
+        stack[top].side = 1;
+        stack[top].parent = nodeIndex;
+        stack[top].start = start;
+        stack[top].end = split;
+        stack[top].depth = depth + 1;
+        ++top;
+    }
+}
+
+inline vec3 BVHInvDirection(const vec3 &direction)
+{
+    return Vec3(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+}
+
+// NOTE: Closest ray hit against the primitive boxes. On a hit, index is the
+//       primitive index and t the entry distance in direction lengths.
+inline b32 RayCastClosest(const bvh &tree, const ray3 &r, u32 &index, r32 &t, r32 maxT = FLT_MAX)
+{
+    if(tree.count == 0)
+        return false;
+
+    vec3 invDirection = BVHInvDirection(r.direction);
+    u32 stack[BVH_MAX_DEPTH + 1];
+    u32 top = 0,
+        nodeIndex = 0;
+    r32 closest = maxT,
+        tNode;
+    b32 hit = false;
+
+    if(!IntersectsSlab(tree.nodes[0].bounds, r.origin, invDirection, closest, tNode))
+        return false;
+
+    for(;;)
+    {
+        const bvhnode &node = tree.nodes[nodeIndex];
+
+        if(node.count > 0)
+        {
+            for(u32 i = node.first; i < node.first + node.count; ++i)
+            {
+                u32 primitive = tree.indices[i];
+                r32 tPrim;
+
+                if(IntersectsSlab(tree.boxes[primitive], r.origin, invDirection, closest, tPrim)
+                   && (!hit || tPrim < closest))
+                {
+                    closest = tPrim;
+                    index = primitive;
+                    hit = true;
+                }
+            }
+        }
+        else
+        {
+            // NOTE: Visit the nearer child first, keep the other one for later
+            u32 left = nodeIndex + 1,
+                right = node.first;
+            r32 tLeft, tRight;
+            b32 hitLeft = IntersectsSlab(tree.nodes[left].bounds, r.origin, invDirection, closest, tLeft),
+                hitRight = IntersectsSlab(tree.nodes[right].bounds, r.origin, invDirection, closest, tRight);
+
+            if(hitLeft && hitRight)
+            {
+                if(tRight < tLeft)
+                {
+                    u32 tmp = left;
+                    left = right;
+                    right = tmp;
+                }
+
+                AAM_Assert(top < BVH_MAX_DEPTH);
+                stack[top++] = right;
+                nodeIndex = left;
+                continue;
+            }
+            else if(hitLeft)
+            {
+                nodeIndex = left;
+                continue;
+            }
+            else if(hitRight)
+            {
+                nodeIndex = right;
+                continue;
+            }
+        }
+
+        // NOTE: Nodes on the stack may have been passed by a closer hit since,
+        //       IntersectsSlab against 'closest' discards those
+        do
+        {
+            if(top == 0)
+            {
+                if(hit)
+                    t = closest;
+                return hit;
+            }
+
+            nodeIndex = stack[--top];
+        } while(!IntersectsSlab(tree.nodes[nodeIndex].bounds, r.origin, invDirection, closest, tNode));
+    }
+}
+
+// NOTE: Any ray hit closer than maxT, stops at the first one found (shadow rays)
+inline b32 RayCastAny(const bvh &tree, const ray3 &r, r32 maxT = FLT_MAX)
+{
+    if(tree.count == 0)
+        return false;
+
+    vec3 invDirection = BVHInvDirection(r.direction);
+    u32 stack[BVH_MAX_DEPTH + 1];
+    u32 top = 0;
+    r32 t;
+
+    stack[top++] = 0;
+
+    while(top > 0)
+    {
+        u32 nodeIndex = stack[--top];
+        const bvhnode &node = tree.nodes[nodeIndex];
+
+        if(!IntersectsSlab(node.bounds, r.origin, invDirection, maxT, t))
+            continue;
+
+        if(node.count > 0)
+        {
+            for(u32 i = node.first; i < node.first + node.count; ++i)
+            {
+                if(IntersectsSlab(tree.boxes[tree.indices[i]], r.origin, invDirection, maxT, t))
+                    return true;
+            }
+        }
+        else
+        {
+            AAM_Assert(top + 2 <= BVH_MAX_DEPTH + 1);
+            stack[top++] = node.first;
+            stack[top++] = nodeIndex + 1;
+        }
+    }
+
+    return false;
+}
+
+// NOTE: Closest hit against custom primitives. The box test only prunes, the
+//       callback does the exact test: it returns true on a hit closer than maxT
+//       and writes the distance to t.
+typedef b32 bvh_raycast_callback(void *user, u32 index, const ray3 &r, r32 maxT, r32 &t);
+
+inline b32 RayCastClosest(const bvh &tree, const ray3 &r, bvh_raycast_callback *callback, void *user,
+                          u32 &index, r32 &t, r32 maxT = FLT_MAX)
+{
+    AAM_Assert(callback);
+
+    if(tree.count == 0)
+        return false;
+
+    vec3 invDirection = BVHInvDirection(r.direction);
+    u32 stack[BVH_MAX_DEPTH + 1];
+    r32 stackT[BVH_MAX_DEPTH + 1];
+    u32 top = 0;
+    r32 closest = maxT,
+        tNode;
+    b32 hit = false;
+
+    if(!IntersectsSlab(tree.nodes[0].bounds, r.origin, invDirection, closest, tNode))
+        return false;
+
+    stack[top] = 0;
+    stackT[top] = tNode;
+    ++top;
+
+    while(top > 0)
+    {
+        --top;
+        if(stackT[top] > closest)
+            continue;
+
+        u32 nodeIndex = stack[top];
+        const bvhnode &node = tree.nodes[nodeIndex];
+
+        if(node.count > 0)
+        {
+            for(u32 i = node.first; i < node.first + node.count; ++i)
+            {
+                u32 primitive = tree.indices[i];
+                r32 tPrim;
+
+                if(callback(user, primitive, r, closest, tPrim) && tPrim <= closest)
+                {
+                    closest = tPrim;
+                    index = primitive;
+                    hit = true;
+                }
+            }
+        }
+        else
+        {
+            u32 left = nodeIndex + 1,
+                right = node.first;
+            r32 tLeft, tRight;
+            b32 hitLeft = IntersectsSlab(tree.nodes[left].bounds, r.origin, invDirection, closest, tLeft),
+                hitRight = IntersectsSlab(tree.nodes[right].bounds, r.origin, invDirection, closest, tRight);
+
+            AAM_Assert(top + 2 <= BVH_MAX_DEPTH + 1);
+
+            // NOTE: Push the farther child first so the nearer one pops next
+            if(hitLeft && hitRight && tLeft < tRight)
+            {
+                stack[top] = right; stackT[top] = tRight; ++top;
+                stack[top] = left; stackT[top] = tLeft; ++top;
+            }
+            else
+            {
+                if(hitLeft)
+                {
+                    stack[top] = left; stackT[top] = tLeft; ++top;
+                }
+                if(hitRight)
+                {
+                    stack[top] = right; stackT[top] = tRight; ++top;
+                }
+            }
+        }
+    }
+
+    if(hit)
+        t = closest;
+
+    return hit;
+}
+
+// NOTE: Writes the indices of the boxes overlapping the query to results (up to
+//       maxResults) and returns the total number of overlaps, which can be larger
+inline u32 Overlaps(const bvh &tree, const aabb &query, u32 *results, u32 maxResults)
+{
+    if(tree.count == 0)
+        return 0;
+
+    u32 stack[BVH_MAX_DEPTH + 1];
+    u32 top = 0,
+        found = 0;
+
+    stack[top++] = 0;
+
+    while(top > 0)
+    {
+        u32 nodeIndex = stack[--top];
+        const bvhnode &node = tree.nodes[nodeIndex];
+
+        if(!Intersects(node.bounds, query))
+            continue;
+
+        if(node.count > 0)
+        {
+            for(u32 i = node.first; i < node.first + node.count; ++i)
+            {
+                u32 primitive = tree.indices[i];
+
+                if(Intersects(tree.boxes[primitive], query))
+                {
+                    if(found < maxResults)
+                        results[found] = primitive;
+                    ++found;
+                }
+            }
+        }
+        else
+        {
+            AAM_Assert(top + 2 <= BVH_MAX_DEPTH + 1);
+            stack[top++] = node.first;
+            stack[top++] = nodeIndex + 1;
+        }
+    }
+
+    return found;
+}
+
+// NOTE: Refits the node bounds after the boxes moved, keeping the topology.
+//       Children always follow their parent, so a reverse sweep is bottom-up.
+inline void Refit(bvh &tree)
+{
+    for(u32 n = tree.nodeCount; n-- > 0;)
+    {
+        bvhnode &node = tree.nodes[n];
+
+        if(node.count > 0)
+        {
+            aabb bounds = tree.boxes[tree.indices[node.first]];
+            for(u32 i = node.first + 1; i < node.first + node.count; ++i)
+                bounds = Union(bounds, tree.boxes[tree.indices[i]]);
+            node.bounds = bounds;
+        }
+        else if(tree.count > 0)
+        {
+            node.bounds = Union(tree.nodes[n + 1].bounds, tree.nodes[node.first].bounds);
+        }
+    }
+}
+
+} // NOTE: Namespace
+
+#endif
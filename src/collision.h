@@ -3,6 +3,9 @@
 
 #include "aamath.h"
 #include "vec3.h"
+#include "mat3.h"
+#include "mat4.h"
+#include "wide.h"
 
 namespace aam {
 
@@ -76,6 +79,8 @@ inline r32 DistanceSq(const line3 &line, const vec3 &point)
     r32 proj = Dot(w, line.direction);
 
     result = wSq - proj * proj / vSq;
+
+    return result;
 }
 
 // NOTE: Normalised direction
@@ -90,6 +95,8 @@ inline r32 DistanceSqN(const line3 &line, const vec3 &point)
     r32 proj = Dot(w, line.direction);
 
     result = wSq - proj * proj;
+
+    return result;
 }
 
 inline vec3 ClosestPoint(const lineseg3 &line, const vec3 &point)
@@ -207,77 +214,96 @@ inline void ClosestPoints(const lineseg3 &lineA, const lineseg3 &lineB, vec3 &po
         e = Dot(lineB.direction, w),
         div = a * c - b * b;
 
-    r32 sc, tc, sn, sd, tn, td;
+    r32 sc, tc;
 
-    if(IsZero(div))
+    // NOTE: Point segments, the other parameter clamps against them
+    if(a <= EPSILON)
     {
-        sd = td = c;
-        sn = 0.0f;
-        tn = e;
+        sc = 0.0f;
+        tc = (c <= EPSILON) ? 0.0f : Clamp01(e / c);
+    }
+    else if(c <= EPSILON)
+    {
+        sc = Clamp01(-d / a);
+        tc = 0.0f;
     }
     else
     {
-        sd = td = div;
-        sn = b * e - c * d;
-        tn = a * e - b * d;
+        r32 sn, sd, tn, td;
 
-        // NOTE: Clamp S point
-        if(sn < 0.0f)
+        // NOTE: div = a * c * sin^2 of the angle between the segments, and
+        //       its cancellation error grows with a * c, so the parallel test
+        //       is relative to it
+        if(div <= EPSILON * a * c)
         {
+            sd = td = c;
             sn = 0.0f;
             tn = e;
-            td = c;
-        }
-        // NOTE: Clamp S point
-        if(sn > sd)
-        {
-            sn = sd;
-            tn = e + b;
-            td = c;
-        }
-    }
-
-    // NOTE: Clamp T point
-    if(tn < 0.0f)
-    {
-        tc = 0.0f;
-
-        // NOTE: Clamp S point
-        if(-d < 0.0f)
-        {
-            sc = 0.0f;
-        }
-        else if (-d > a)
-        {
-            sc = 1.0f;
         }
         else
         {
-            sc = -d / a;
+            sd = td = div;
+            sn = b * e - c * d;
+            tn = a * e - b * d;
+
+            // NOTE: Clamp S point
+            if(sn < 0.0f)
+            {
+                sn = 0.0f;
+                tn = e;
+                td = c;
+            }
+            // NOTE: Clamp S point
+            if(sn > sd)
+            {
+                sn = sd;
+                tn = e + b;
+                td = c;
+            }
         }
-    }
-    else if (tn > td)
-    {
-        tc = 1.0f;
 
-        if((-d + b) > 0.0f)
+        // NOTE: Clamp T point
+        if(tn < 0.0f)
         {
-            sc = 0.0f;
+            tc = 0.0f;
+
+            // NOTE: Clamp S point
+            if(-d < 0.0f)
+            {
+                sc = 0.0f;
+            }
+            else if (-d > a)
+            {
+                sc = 1.0f;
+            }
+            else
+            {
+                sc = -d / a;
+            }
         }
-        else if((-d + b) > a)
+        else if (tn > td)
         {
-            sc = 1.0f;
+            tc = 1.0f;
+
+            if((-d + b) < 0.0f)
+            {
+                sc = 0.0f;
+            }
+            else if((-d + b) > a)
+            {
+                sc = 1.0f;
+            }
+            else
+            {
+                sc = (-d + b) / a;
+            }
         }
         else
         {
-            sc = (-d + b) / a;
+            tc = tn / td;
+            sc = sn / sd;
         }
     }
-    else
-    {
-        tc = tn / td;
-        sc = sn / sd;
-    }
 
     pointA = lineA.origin + sc * lineA.direction;
     pointB = lineB.origin + tc * lineB.direction;
@@ -718,26 +744,28 @@ inline b32 Intersects(const aabb &a, const aabb &b)
     return true;
 }
 
-inline b32 Intersects(const aabb &bb, const ray3 &r)
+// NOTE: Slab test with a precomputed 1 / direction, entry distance (0 when the
+//       origin is inside) written to tEntry. Only hits with entry <= maxT count.
+inline b32 IntersectsSlab(const aabb &bb, const vec3 &origin, const vec3 &invDirection, r32 maxT, r32 &tEntry)
 {
     r32 maxS = 0.0f,
-        minT = FLT_MAX;
+        minT = maxT;
 
     // NOTE: Test against x, y and z
     for(u32 i = 0; i < 3; ++i)
     {
         r32 s, t,
-            recip = 1.0f / r.direction.E[i];
+            recip = invDirection.E[i];
 
         if(recip >= 0.0f)
         {
-            s = (bb.min.E[i] - r.origin.E[i]) * recip;
-            t = (bb.max.E[i] - r.origin.E[i]) * recip;
+            s = (bb.min.E[i] - origin.E[i]) * recip;
+            t = (bb.max.E[i] - origin.E[i]) * recip;
         }
         else
         {
-            s = (bb.max.E[i] - r.origin.E[i]) * recip;
-            t = (bb.min.E[i] - r.origin.E[i]) * recip;
+            s = (bb.max.E[i] - origin.E[i]) * recip;
+            t = (bb.min.E[i] - origin.E[i]) * recip;
         }
 
         if(s > maxS)
@@ -750,9 +778,123 @@ inline b32 Intersects(const aabb &bb, const ray3 &r)
             return false;
     }
 
+    tEntry = maxS;
     return true;
 }
 
+inline b32 Intersects(const aabb &bb, const ray3 &r)
+{
+    r32 t;
+    vec3 invDirection = Vec3(1.0f / r.direction.x, 1.0f / r.direction.y, 1.0f / r.direction.z);
+
+    return IntersectsSlab(bb, r.origin, invDirection, FLT_MAX, t);
+}
+
+// NOTE: As above, with the entry distance along the ray (in direction lengths)
+inline b32 Intersects(const aabb &bb, const ray3 &r, r32 &t)
+{
+    vec3 invDirection = Vec3(1.0f / r.direction.x, 1.0f / r.direction.y, 1.0f / r.direction.z);
+
+    return IntersectsSlab(bb, r.origin, invDirection, FLT_MAX, t);
+}
+
+// NOTE: Ray with 1 / direction and the direction signs precomputed, for testing
+//       one ray against many boxes without the divides
+typedef struct _fastray3
+{
+    vec3 origin,
+         direction,
+         invDirection;
+    u32 sign[3];    // NOTE: 1 when the direction component is negative
+} fastray3;
+
+inline fastray3 FastRay3(const ray3 &r)
+{
+    fastray3 result;
+
+    result.origin = r.origin;
+    result.direction = r.direction;
+    result.invDirection = Vec3(1.0f / r.direction.x, 1.0f / r.direction.y, 1.0f / r.direction.z);
+
+    for(u32 i = 0; i < 3; ++i)
+    {
+        result.sign[i] = (result.invDirection.E[i] < 0.0f) ? 1 : 0;
+    }
+
+    return result;
+}
+
+// NOTE: Branch-free slab test, the sign bits pick the near and far bound per
+//       axis (Williams et al.). Same results as IntersectsSlab: entry distance
+//       in t (0 when the origin is inside), only hits entering by maxT count.
+//       An origin exactly on a slab of a zero direction component gives
+//       0 * inf = NaN, the Max/Min argument order drops that axis.
+inline b32 Intersects(const aabb &bb, const fastray3 &r, r32 &t, r32 maxT = FLT_MAX)
+{
+    const vec3 *bounds = &bb.min;
+    r32 tNear = 0.0f,
+        tFar = maxT;
+
+    for(u32 i = 0; i < 3; ++i)
+    {
+        r32 slabNear = (bounds[r.sign[i]].E[i] - r.origin.E[i]) * r.invDirection.E[i],
+            slabFar = (bounds[1 - r.sign[i]].E[i] - r.origin.E[i]) * r.invDirection.E[i];
+
+        tNear = Max(slabNear, tNear);
+        tFar = Min(slabFar, tFar);
+    }
+
+    t = tNear;
+
+    return tNear <= tFar;
+}
+
+inline b32 Intersects(const aabb &bb, const fastray3 &r)
+{
+    r32 t;
+
+    return Intersects(bb, r, t);
+}
+
+inline vec3 Centre(const aabb &bb)
+{
+    return 0.5f * (bb.min + bb.max);
+}
+
+inline r32 SurfaceArea(const aabb &bb)
+{
+    vec3 d = bb.max - bb.min;
+
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+}
+
+inline aabb Union(const aabb &a, const aabb &b)
+{
+    aabb result;
+
+    result.min = Vec3(Min(a.min.x, b.min.x), Min(a.min.y, b.min.y), Min(a.min.z, b.min.z));
+    result.max = Vec3(Max(a.max.x, b.max.x), Max(a.max.y, b.max.y), Max(a.max.z, b.max.z));
+
+    return result;
+}
+
+inline aabb Union(const aabb &bb, const vec3 &p)
+{
+    aabb result;
+
+    result.min = Vec3(Min(bb.min.x, p.x), Min(bb.min.y, p.y), Min(bb.min.z, p.z));
+    result.max = Vec3(Max(bb.max.x, p.x), Max(bb.max.y, p.y), Max(bb.max.z, p.z));
+
+    return result;
+}
+
+// NOTE: True when b is entirely inside a
+inline b32 Contains(const aabb &a, const aabb &b)
+{
+    return (a.min.x <= b.min.x && a.min.y <= b.min.y && a.min.z <= b.min.z
+            && b.max.x <= a.max.x && b.max.y <= a.max.y && b.max.z <= a.max.z);
+}
+
 // NOTE: Returns the signed distance, 0 if colliding
 inline r32 Test(const aabb &bb, const plane &p)
 {
@@ -805,6 +947,2147 @@ inline r32 Test(const aabb &bb, const plane &p)
     return test;
 }
 
+typedef struct _triangle
+{
+    vec3 a, b, c;
+} triangle;
+
+inline triangle Triangle(const vec3 &a, const vec3 &b, const vec3 &c)
+{
+    triangle result;
+
+    result.a = a;
+    result.b = b;
+    result.c = c;
+
+    return result;
+}
+
+// NOTE: Möller-Trumbore, two-sided. Hit at t along the ray, u and v are the
+//       barycentric weights of b and c (a gets 1 - u - v). The edges are
+//       inclusive, so rays through a shared edge hit both triangles.
+inline b32 Intersects(const triangle &tri, const ray3 &r, r32 &t, r32 &u, r32 &v, r32 maxT = FLT_MAX)
+{
+    vec3 e1 = tri.b - tri.a,
+         e2 = tri.c - tri.a,
+         p = Cross(r.direction, e2);
+
+    // NOTE: -d.(e1 x e2), zero when parallel to the triangle
+    r32 det = Dot(e1, p);
+    if(det == 0.0f)
+        return false;
+
+    r32 invDet = 1.0f / det;
+    vec3 s = r.origin - tri.a;
+
+    u = Dot(s, p) * invDet;
+    if(u < 0.0f || u > 1.0f)
+        return false;
+
+    vec3 q = Cross(s, e1);
+
+    v = Dot(r.direction, q) * invDet;
+    if(v < 0.0f || u + v > 1.0f)
+        return false;
+
+    t = Dot(e2, q) * invDet;
+
+    return (t >= 0.0f && t <= maxT);
+}
+
+inline b32 Intersects(const triangle &tri, const ray3 &r)
+{
+    r32 t, u, v;
+
+    return Intersects(tri, r, t, u, v);
+}
+
+inline vec3 ClosestPoint(const aabb &bb, const vec3 &point)
+{
+    // NOTE: Not Clamp, which asserts min < max and flat boxes are fine here
+    return Vec3(Min(Max(point.x, bb.min.x), bb.max.x),
+                Min(Max(point.y, bb.min.y), bb.max.y),
+                Min(Max(point.z, bb.min.z), bb.max.z));
+}
+
+// NOTE: 0 inside the box
+inline r32 DistanceSq(const aabb &bb, const vec3 &point)
+{
+    return LengthSq(point - ClosestPoint(bb, point));
+}
+
+// NOTE: Slope (over 2) of the squared distance to the box along the segment
+inline r32 AABBSegmentSlope(const aabb &bb, const lineseg3 &line, r32 t)
+{
+    vec3 p = line.origin + t * line.direction;
+
+    return Dot(p - ClosestPoint(bb, p), line.direction);
+}
+
+// NOTE: Parameter of the point on the segment closest to the box. The squared
+//       distance along the segment is convex and piecewise quadratic, with
+//       breaks where the segment crosses a slab plane, so its slope is
+//       piecewise linear and increasing. The minimum lies between the last
+//       break with a slope <= 0 and the first with a slope > 0.
+inline r32 ClosestParameter(const aabb &bb, const lineseg3 &line)
+{
+    r32 tLo = 0.0f,
+        tHi = 1.0f,
+        slopeLo = AABBSegmentSlope(bb, line, tLo),
+        slopeHi = AABBSegmentSlope(bb, line, tHi);
+
+    if(slopeLo >= 0.0f)
+        return 0.0f;
+    if(slopeHi <= 0.0f)
+        return 1.0f;
+
+    for(u32 axis = 0; axis < 3; ++axis)
+    {
+        r32 d = line.direction.E[axis];
+
+        if(d == 0.0f)
+            continue;
+
+        r32 breaks[2] = { (bb.min.E[axis] - line.origin.E[axis]) / d,
+                          (bb.max.E[axis] - line.origin.E[axis]) / d };
+
+        for(u32 i = 0; i < 2; ++i)
+        {
+            r32 t = breaks[i];
+
+            if(t <= tLo || t >= tHi)
+                continue;
+
+            r32 slope = AABBSegmentSlope(bb, line, t);
+
+            if(slope <= 0.0f)
+            {
+                tLo = t;
+                slopeLo = slope;
+            }
+            else
+            {
+                tHi = t;
+                slopeHi = slope;
+            }
+        }
+    }
+
+    return tLo - slopeLo * (tHi - tLo) / (slopeHi - slopeLo);
+}
+
+inline r32 DistanceSq(const aabb &bb, const lineseg3 &line)
+{
+    return DistanceSq(bb, line.origin + ClosestParameter(bb, line) * line.direction);
+}
+
+// NOTE: The segment clamping with the ray parameter bounded below only. A
+//       zero direction ray is its origin, a zero length segment its origin.
+inline void ClosestPoints(const ray3 &ray, const lineseg3 &line, vec3 &pointA, vec3 &pointB)
+{
+    vec3 w = ray.origin - line.origin;
+    r32 a = Dot(ray.direction, ray.direction),
+        b = Dot(ray.direction, line.direction),
+        c = Dot(line.direction, line.direction),
+        d = Dot(ray.direction, w),
+        e = Dot(line.direction, w),
+        div = a * c - b * b;
+
+    r32 sc, tc;
+
+    if(a <= EPSILON)
+    {
+        sc = 0.0f;
+        tc = (c <= EPSILON) ? 0.0f : Clamp01(e / c);
+    }
+    else if(c <= EPSILON)
+    {
+        sc = Max(-d, 0.0f) / a;
+        tc = 0.0f;
+    }
+    else
+    {
+        r32 sn, sd, tn, td;
+
+        // NOTE: Relative to a * c, as for two segments
+        if(div <= EPSILON * a * c)
+        {
+            sn = 0.0f;
+            sd = 1.0f;
+            tn = e;
+            td = c;
+        }
+        else
+        {
+            sn = b * e - c * d;
+            sd = td = div;
+            tn = a * e - b * d;
+
+            // NOTE: Clamp S point
+            if(sn < 0.0f)
+            {
+                sn = 0.0f;
+                tn = e;
+                td = c;
+            }
+        }
+
+        // NOTE: Clamp T point
+        if(tn < 0.0f)
+        {
+            tc = 0.0f;
+            sc = Max(-d, 0.0f) / a;
+        }
+        else if(tn > td)
+        {
+            tc = 1.0f;
+            sc = Max(b - d, 0.0f) / a;
+        }
+        else
+        {
+            tc = tn / td;
+            sc = sn / sd;
+        }
+    }
+
+    pointA = ray.origin + sc * ray.direction;
+    pointB = line.origin + tc * line.direction;
+}
+
+inline r32 DistanceSq(const ray3 &ray, const lineseg3 &line)
+{
+    vec3 a, b;
+    ClosestPoints(ray, line, a, b);
+
+    return LengthSq(a - b);
+}
+
+//
+// NOTE: Capsules
+//
+
+// NOTE: All points within radius of the segment
+typedef struct _capsule
+{
+    lineseg3 segment;
+    r32 radius;
+} capsule;
+
+inline capsule Capsule(const lineseg3 &segment, r32 radius)
+{
+    capsule result;
+
+    result.segment = segment;
+    result.radius = radius;
+
+    return result;
+}
+
+// NOTE: Between the centres of the two end caps
+inline capsule Capsule(const vec3 &a, const vec3 &b, r32 radius)
+{
+    return Capsule(LineSeg3(a, b - a), radius);
+}
+
+// NOTE: Distance between the surfaces, negative by the penetration depth when
+//       they overlap. The ray3 versions are to the ray itself.
+inline r32 Distance(const capsule &a, const capsule &b)
+{
+    return AASqrt(DistanceSq(a.segment, b.segment)) - (a.radius + b.radius);
+}
+
+// NOTE: From the closest point, DistanceSq(lineseg3, vec3) cancels to small
+//       negative values for centres on the axis
+inline r32 Distance(const capsule &c, const sphere &s)
+{
+    return AASqrt(LengthSq(s.origin - ClosestPoint(c.segment, s.origin))) - (c.radius + s.radius);
+}
+
+inline r32 Distance(const capsule &c, const aabb &bb)
+{
+    return AASqrt(DistanceSq(bb, c.segment)) - c.radius;
+}
+
+inline r32 Distance(const capsule &c, const ray3 &r)
+{
+    return AASqrt(DistanceSq(r, c.segment)) - c.radius;
+}
+
+inline b32 Intersects(const capsule &a, const capsule &b)
+{
+    r32 radius = a.radius + b.radius;
+
+    return DistanceSq(a.segment, b.segment) <= radius * radius;
+}
+
+inline b32 Intersects(const capsule &c, const sphere &s)
+{
+    r32 radius = c.radius + s.radius;
+
+    return DistanceSq(c.segment, s.origin) <= radius * radius;
+}
+
+inline b32 Intersects(const capsule &c, const aabb &bb)
+{
+    return DistanceSq(bb, c.segment) <= c.radius * c.radius;
+}
+
+inline b32 Intersects(const capsule &c, const ray3 &r)
+{
+    return DistanceSq(r, c.segment) <= c.radius * c.radius;
+}
+
+//
+// NOTE: Hit records
+//
+
+// NOTE: Where a ray enters and leaves a shape, distances in direction lengths.
+//       The point and normal are at tEntry. A ray starting inside a solid gets
+//       tEntry = 0, its origin as the point and a zero normal. Planes and
+//       triangles are surfaces, tEntry = tExit and the normal faces the ray.
+//       Only hits entering by maxT count, nothing is written on a miss.
+typedef struct _rayhit
+{
+    r32 tEntry,
+        tExit;
+    vec3 point,
+         normal;
+} rayhit;
+
+// NOTE: Slab test that also tracks which slab was entered last, same hits and
+//       entry distance as IntersectsSlab
+inline b32 Intersects(const aabb &bb, const ray3 &r, rayhit &hit, r32 maxT = FLT_MAX)
+{
+    r32 tNear = 0.0f,
+        tFar = FLT_MAX;
+    u32 axis = 3;
+
+    for(u32 i = 0; i < 3; ++i)
+    {
+        r32 s, t,
+            recip = 1.0f / r.direction.E[i];
+
+        if(recip >= 0.0f)
+        {
+            s = (bb.min.E[i] - r.origin.E[i]) * recip;
+            t = (bb.max.E[i] - r.origin.E[i]) * recip;
+        }
+        else
+        {
+            s = (bb.max.E[i] - r.origin.E[i]) * recip;
+            t = (bb.min.E[i] - r.origin.E[i]) * recip;
+        }
+
+        if(s > tNear)
+        {
+            tNear = s;
+            axis = i;
+        }
+        if(t < tFar)
+            tFar = t;
+    }
+
+    if(tNear > tFar || tNear > maxT)
+        return false;
+
+    hit.tEntry = tNear;
+    hit.tExit = tFar;
+    hit.point = r.origin + tNear * r.direction;
+    hit.normal = VEC3_ZERO;
+
+    if(axis < 3)
+        hit.normal.E[axis] = (r.direction.E[axis] < 0.0f) ? 1.0f : -1.0f;
+
+    return true;
+}
+
+// NOTE: Roots of |o + t d - c|^2 = r^2, t = (b -+ sqrt(b^2 - a c)) / a with
+//       a = d.d, b = d.(c - o), c = |c - o|^2 - r^2
+inline b32 Intersects(const sphere &s, const ray3 &r, rayhit &hit, r32 maxT = FLT_MAX)
+{
+    vec3 w = s.origin - r.origin;
+    r32 a = LengthSq(r.direction),
+        b = Dot(w, r.direction),
+        c = LengthSq(w) - s.radius * s.radius,
+        disc = b * b - a * c;
+
+    // NOTE: A zero direction never hits
+    if(disc < 0.0f || a == 0.0f)
+        return false;
+
+    r32 root = AASqrt(disc),
+        recipA = 1.0f / a,
+        t0 = (b - root) * recipA,
+        t1 = (b + root) * recipA;
+
+    if(t1 < 0.0f || t0 > maxT)
+        return false;
+
+    hit.tExit = t1;
+
+    if(t0 >= 0.0f)
+    {
+        hit.tEntry = t0;
+        hit.point = r.origin + t0 * r.direction;
+        hit.normal = (hit.point - s.origin) * (1.0f / s.radius);
+    }
+    else
+    {
+        hit.tEntry = 0.0f;
+        hit.point = r.origin;
+        hit.normal = VEC3_ZERO;
+    }
+
+    return true;
+}
+
+// NOTE: Misses when the ray runs parallel to the plane, even inside it
+inline b32 Intersects(const plane &p, const ray3 &r, rayhit &hit, r32 maxT = FLT_MAX)
+{
+    r32 denom = Dot(p.normal, r.direction),
+        t = -Test(p, r.origin) / denom;
+
+    // NOTE: Also false for the inf/NaN of denom == 0
+    if(!(t >= 0.0f && t <= maxT))
+        return false;
+
+    hit.tEntry = t;
+    hit.tExit = t;
+    hit.point = r.origin + t * r.direction;
+    hit.normal = (denom > 0.0f) ? -p.normal : p.normal;
+
+    return true;
+}
+
+inline b32 Intersects(const triangle &tri, const ray3 &r, rayhit &hit, r32 maxT = FLT_MAX)
+{
+    r32 t, u, v;
+
+    if(!Intersects(tri, r, t, u, v, maxT))
+        return false;
+
+    vec3 normal = Normalized(Cross(tri.b - tri.a, tri.c - tri.a));
+
+    hit.tEntry = t;
+    hit.tExit = t;
+    hit.point = r.origin + t * r.direction;
+    hit.normal = (Dot(normal, r.direction) > 0.0f) ? -normal : normal;
+
+    return true;
+}
+
+//
+// NOTE: Oriented bounding boxes
+//
+
+// NOTE: axes.v[i] is the unit local axis i in world space (rows of a
+//       rotation), extents the half sizes along them
+typedef struct _obb
+{
+    vec3 centre;
+    mat3 axes;
+    vec3 extents;
+} obb;
+
+inline obb OBB(const vec3 &centre, const mat3 &axes, const vec3 &extents)
+{
+    obb result;
+
+    result.centre = centre;
+    result.axes = axes;
+    result.extents = extents;
+
+    return result;
+}
+
+inline obb OBB(const vec3 &centre, const quat &orientation, const vec3 &extents)
+{
+    return OBB(centre, Mat3Rotation(orientation), extents);
+}
+
+// NOTE: The box under an affine m without shear (rotation, scale and
+//       translation), an axis m scales to zero keeps its unit direction
+inline obb OBB(const aabb &bb, const mat4 &m)
+{
+    obb result;
+
+    vec3 halfSize = 0.5f * (bb.max - bb.min);
+
+    result.centre = TransformPoint(m, 0.5f * (bb.min + bb.max));
+    result.axes = MAT3_IDENTITY;
+
+    for(u32 i = 0; i < 3; ++i)
+    {
+        vec3 axis = TransformDirection(m, MAT3_IDENTITY.v[i]);
+        r32 scale = Length(axis);
+
+        if(scale > 0.0f)
+            result.axes.v[i] = axis * (1.0f / scale);
+
+        result.extents.E[i] = halfSize.E[i] * scale;
+    }
+
+    return result;
+}
+
+// NOTE: Covariance of the points about their mean
+inline mat3 Covariance(const vec3 *points, u32 count)
+{
+    AAM_Assert(points && count > 0);
+
+    vec3 mean = VEC3_ZERO;
+
+    for(u32 i = 0; i < count; ++i)
+        mean += points[i];
+
+    mean = mean * (1.0f / (r32)count);
+
+    r32 xx = 0.0f, xy = 0.0f, xz = 0.0f,
+        yy = 0.0f, yz = 0.0f, zz = 0.0f;
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        vec3 d = points[i] - mean;
+
+        xx += d.x * d.x;
+        xy += d.x * d.y;
+        xz += d.x * d.z;
+        yy += d.y * d.y;
+        yz += d.y * d.z;
+        zz += d.z * d.z;
+    }
+
+    r32 invCount = 1.0f / (r32)count;
+    mat3 result = {xx, xy, xz,
+                   xy, yy, yz,
+                   xz, yz, zz};
+
+    return result * invCount;
+}
+
+// NOTE: Fits the box to the principal axes of the vertices (the eigenvectors
+//       of their covariance). Tight for elongated shapes, but not the minimum
+//       volume box, and uneven vertex density pulls the axes around.
+inline obb OBB(const vec3 *vertices, const u32 count)
+{
+    AAM_Assert(vertices && count > 0);
+
+    obb result;
+    vec3 values;
+
+    EigenSymmetric(Covariance(vertices, count), values, result.axes);
+
+    vec3 min, max;
+
+    for(u32 i = 0; i < 3; ++i)
+    {
+        min.E[i] = max.E[i] = Dot(vertices[0], result.axes.v[i]);
+    }
+
+    for(u32 n = 1; n < count; ++n)
+    {
+        for(u32 i = 0; i < 3; ++i)
+        {
+            r32 proj = Dot(vertices[n], result.axes.v[i]);
+
+            min.E[i] = Min(min.E[i], proj);
+            max.E[i] = Max(max.E[i], proj);
+        }
+    }
+
+    // NOTE: axes rows are orthonormal, so axes * local is the world point
+    result.centre = result.axes * (0.5f * (min + max));
+    result.extents = 0.5f * (max - min);
+
+    return result;
+}
+
+// NOTE: World space p in the box's frame, relative to its centre
+inline vec3 ToLocal(const obb &box, const vec3 &p)
+{
+    vec3 d = p - box.centre;
+
+    return Vec3(Dot(d, box.axes.x), Dot(d, box.axes.y), Dot(d, box.axes.z));
+}
+
+// NOTE: Bounds of the box
+inline aabb AABB(const obb &box)
+{
+    vec3 extents;
+
+    for(u32 i = 0; i < 3; ++i)
+    {
+        extents.E[i] = box.extents.x * fabsf(box.axes.x.E[i])
+                       + box.extents.y * fabsf(box.axes.y.E[i])
+                       + box.extents.z * fabsf(box.axes.z.E[i]);
+    }
+
+    return AABB(box.centre - extents, box.centre + extents);
+}
+
+inline vec3 ClosestPoint(const obb &box, const vec3 &point)
+{
+    vec3 local = ToLocal(box, point),
+         clamped = Vec3(Min(Max(local.x, -box.extents.x), box.extents.x),
+                        Min(Max(local.y, -box.extents.y), box.extents.y),
+                        Min(Max(local.z, -box.extents.z), box.extents.z));
+
+    return box.centre + box.axes * clamped;
+}
+
+// NOTE: 0 inside the box
+inline r32 DistanceSq(const obb &box, const vec3 &point)
+{
+    vec3 local = ToLocal(box, point);
+    r32 result = 0.0f;
+
+    for(u32 i = 0; i < 3; ++i)
+    {
+        r32 excess = fabsf(local.E[i]) - box.extents.E[i];
+
+        if(excess > 0.0f)
+            result += excess * excess;
+    }
+
+    return result;
+}
+
+// NOTE: Separating axis test over the 3 + 3 face normals and the 9 edge cross
+//       products (Gottschalk). b's axes are expressed in a's frame once, and
+//       the epsilon keeps near parallel edges (a zero cross product) from
+//       reporting a false separation.
+inline b32 Intersects(const obb &a, const obb &b)
+{
+    r32 R[3][3],
+        absR[3][3];
+
+    for(u32 i = 0; i < 3; ++i)
+    {
+        for(u32 j = 0; j < 3; ++j)
+        {
+            R[i][j] = Dot(a.axes.v[i], b.axes.v[j]);
+            absR[i][j] = fabsf(R[i][j]) + EPSILON;
+        }
+    }
+
+    vec3 d = b.centre - a.centre,
+         t = Vec3(Dot(d, a.axes.x), Dot(d, a.axes.y), Dot(d, a.axes.z));
+    const vec3 &ea = a.extents,
+               &eb = b.extents;
+    r32 ra, rb;
+
+    // NOTE: a's axes
+    for(u32 i = 0; i < 3; ++i)
+    {
+        ra = ea.E[i];
+        rb = eb.x * absR[i][0] + eb.y * absR[i][1] + eb.z * absR[i][2];
+
+        if(fabsf(t.E[i]) > ra + rb)
+            return false;
+    }
+
+    // NOTE: b's axes
+    for(u32 j = 0; j < 3; ++j)
+    {
+        ra = ea.x * absR[0][j] + ea.y * absR[1][j] + ea.z * absR[2][j];
+        rb = eb.E[j];
+
+        if(fabsf(t.x * R[0][j] + t.y * R[1][j] + t.z * R[2][j]) > ra + rb)
+            return false;
+    }
+
+    // NOTE: a.axes[i] x b.axes[j]
+    for(u32 i = 0; i < 3; ++i)
+    {
+        u32 i1 = (i + 1) % 3,
+            i2 = (i + 2) % 3;
+
+        for(u32 j = 0; j < 3; ++j)
+        {
+            u32 j1 = (j + 1) % 3,
+                j2 = (j + 2) % 3;
+
+            ra = ea.E[i1] * absR[i2][j] + ea.E[i2] * absR[i1][j];
+            rb = eb.E[j1] * absR[i][j2] + eb.E[j2] * absR[i][j1];
+
+            if(fabsf(t.E[i2] * R[i1][j] - t.E[i1] * R[i2][j]) > ra + rb)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+inline b32 Intersects(const obb &box, const sphere &s)
+{
+    return DistanceSq(box, s.origin) <= s.radius * s.radius;
+}
+
+// NOTE: Returns the signed distance, 0 if colliding
+inline r32 Test(const obb &box, const plane &p)
+{
+    r32 radius = box.extents.x * fabsf(Dot(p.normal, box.axes.x))
+                 + box.extents.y * fabsf(Dot(p.normal, box.axes.y))
+                 + box.extents.z * fabsf(Dot(p.normal, box.axes.z)),
+        dist = Test(p, box.centre);
+
+    if(dist > radius)
+        return dist - radius;
+    if(dist < -radius)
+        return dist + radius;
+
+    return 0.0f;
+}
+
+// NOTE: The ray in the box's frame, where the box is an aabb about the origin
+inline ray3 ToLocal(const obb &box, const ray3 &r)
+{
+    return Ray3(ToLocal(box, r.origin),
+                Vec3(Dot(r.direction, box.axes.x), Dot(r.direction, box.axes.y), Dot(r.direction, box.axes.z)));
+}
+
+inline b32 Intersects(const obb &box, const ray3 &r)
+{
+    return Intersects(AABB(-box.extents, box.extents), ToLocal(box, r));
+}
+
+// NOTE: As above, with the entry distance along the ray (in direction lengths)
+inline b32 Intersects(const obb &box, const ray3 &r, r32 &t)
+{
+    return Intersects(AABB(-box.extents, box.extents), ToLocal(box, r), t);
+}
+
+inline b32 Intersects(const obb &box, const ray3 &r, rayhit &hit, r32 maxT = FLT_MAX)
+{
+    if(!Intersects(AABB(-box.extents, box.extents), ToLocal(box, r), hit, maxT))
+        return false;
+
+    hit.point = r.origin + hit.tEntry * r.direction;
+    hit.normal = box.axes * hit.normal;
+
+    return true;
+}
+
+//
+// NOTE: SoA aabb, 4 boxes per lane set
+//
+
+typedef struct _aabbx4
+{
+    vec3x4 min,
+           max;
+} aabbx4;
+
+// NOTE: Loads 4 consecutive aabbs
+inline aabbx4 LoadAABBx4(const aabb *src)
+{
+    aabbx4 result;
+
+    // NOTE: Lanes alternate min, max, min, max
+    vec3x4 a = LoadVec3x4(&src[0].min),
+           b = LoadVec3x4(&src[2].min);
+
+    result.min = Vec3x4(EvenLanes(a.x, b.x), EvenLanes(a.y, b.y), EvenLanes(a.z, b.z));
+    result.max = Vec3x4(OddLanes(a.x, b.x), OddLanes(a.y, b.y), OddLanes(a.z, b.z));
+
+    return result;
+}
+
+typedef struct _spherex4
+{
+    vec3x4 origin;
+    r32x4 radius;
+} spherex4;
+
+// NOTE: Loads 4 consecutive spheres, laid out as vec4s (origin, radius)
+inline spherex4 LoadSpherex4(const sphere *src)
+{
+    spherex4 result;
+
+    vec4x4 s = LoadVec4x4((const vec4 *)src);
+    result.origin = Vec3x4(s.x, s.y, s.z);
+    result.radius = s.w;
+
+    return result;
+}
+
+typedef struct _planex4
+{
+    vec3x4 normal;
+    r32x4 offset;
+} planex4;
+
+// NOTE: Loads 4 consecutive planes, laid out as vec4s (normal, offset)
+inline planex4 LoadPlanex4(const plane *src)
+{
+    planex4 result;
+
+    vec4x4 p = LoadVec4x4((const vec4 *)src);
+    result.normal = Vec3x4(p.x, p.y, p.z);
+    result.offset = p.w;
+
+    return result;
+}
+
+//
+// NOTE: SoA triangles, one ray against 4 or 8 triangles at a time
+//
+
+// NOTE: First vertex and the edges to the other two, precomputed once
+typedef struct _trianglex4
+{
+    vec3x4 a,
+           e1,
+           e2;
+} trianglex4;
+
+typedef struct _trianglex8
+{
+    vec3x8 a,
+           e1,
+           e2;
+} trianglex8;
+
+// NOTE: Loads 4 consecutive triangles
+inline trianglex4 LoadTrianglex4(const triangle *src)
+{
+    trianglex4 result;
+
+    vec3x4 b = LoadVec3x4(&src[0].b, sizeof(triangle)),
+           c = LoadVec3x4(&src[0].c, sizeof(triangle));
+
+    result.a = LoadVec3x4(&src[0].a, sizeof(triangle));
+    result.e1 = b - result.a;
+    result.e2 = c - result.a;
+
+    return result;
+}
+
+// NOTE: Loads 8 consecutive triangles
+inline trianglex8 LoadTrianglex8(const triangle *src)
+{
+    trianglex8 result;
+
+    trianglex4 lo = LoadTrianglex4(src),
+               hi = LoadTrianglex4(src + 4);
+
+    result.a = Vec3x8(lo.a, hi.a);
+    result.e1 = Vec3x8(lo.e1, hi.e1);
+    result.e2 = Vec3x8(lo.e2, hi.e2);
+
+    return result;
+}
+
+// NOTE: Packs count triangles into (count + 3) / 4 packets. The lanes past
+//       count get zero edges, which never hit.
+inline void PackTriangles(const triangle *src, u32 count, trianglex4 *dst)
+{
+    u32 i = 0;
+    for(; i + 4 <= count; i += 4)
+    {
+        dst[i / 4] = LoadTrianglex4(src + i);
+    }
+    if(i < count)
+    {
+        triangle tail[4];
+
+        for(u32 j = 0; j < 4; ++j)
+        {
+            vec3 a = src[(i + j < count) ? i + j : count - 1].a;
+            tail[j] = (i + j < count) ? src[i + j] : Triangle(a, a, a);
+        }
+
+        dst[i / 4] = LoadTrianglex4(tail);
+    }
+}
+
+// NOTE: As above, (count + 7) / 8 packets
+inline void PackTriangles(const triangle *src, u32 count, trianglex8 *dst)
+{
+    u32 i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        dst[i / 8] = LoadTrianglex8(src + i);
+    }
+    if(i < count)
+    {
+        triangle tail[8];
+
+        for(u32 j = 0; j < 8; ++j)
+        {
+            vec3 a = src[(i + j < count) ? i + j : count - 1].a;
+            tail[j] = (i + j < count) ? src[i + j] : Triangle(a, a, a);
+        }
+
+        dst[i / 8] = LoadTrianglex8(tail);
+    }
+}
+
+// NOTE: Möller-Trumbore per lane, same cases as the scalar version. Returns
+//       the mask of lanes hit by maxT, t/u/v are only valid in those lanes.
+inline r32x4 Intersects(const trianglex4 &tri, const ray3 &r, r32x4 &t, r32x4 &u, r32x4 &v,
+                        r32 maxT = FLT_MAX)
+{
+    vec3x4 d = Vec3x4(r.direction),
+           p = Cross(d, tri.e2),
+           s = Vec3x4(r.origin) - tri.a,
+           q = Cross(s, tri.e1);
+
+    r32x4 zero = R32x4(0.0f),
+          det = Dot(tri.e1, p),
+          invDet = 1.0f / det;
+
+    u = Dot(s, p) * invDet;
+    v = Dot(d, q) * invDet;
+    t = Dot(tri.e2, q) * invDet;
+
+    return (det != zero) & (u >= zero) & (v >= zero) & (u + v <= R32x4(1.0f))
+           & (t >= zero) & (t <= R32x4(maxT));
+}
+
+inline r32x8 Intersects(const trianglex8 &tri, const ray3 &r, r32x8 &t, r32x8 &u, r32x8 &v,
+                        r32 maxT = FLT_MAX)
+{
+    vec3x8 d = Vec3x8(r.direction),
+           p = Cross(d, tri.e2),
+           s = Vec3x8(r.origin) - tri.a,
+           q = Cross(s, tri.e1);
+
+    r32x8 zero = R32x8(0.0f),
+          det = Dot(tri.e1, p),
+          invDet = 1.0f / det;
+
+    u = Dot(s, p) * invDet;
+    v = Dot(d, q) * invDet;
+    t = Dot(tri.e2, q) * invDet;
+
+    return (det != zero) & (u >= zero) & (v >= zero) & (u + v <= R32x8(1.0f))
+           & (t >= zero) & (t <= R32x8(maxT));
+}
+
+// NOTE: Nearest hit over packetCount packets from PackTriangles. index is the
+//       triangle's index in the packed array, u and v its barycentrics as in
+//       the scalar version. Nothing is written on a miss.
+inline b32 RayCastClosest(const trianglex4 *packets, u32 packetCount, const ray3 &r,
+                          u32 &index, r32 &t, r32 &u, r32 &v, r32 maxT = FLT_MAX)
+{
+    b32 result = false;
+    r32 closest = maxT;
+
+    for(u32 i = 0; i < packetCount; ++i)
+    {
+        r32x4 pt, pu, pv;
+        u32 bits = MoveMask(Intersects(packets[i], r, pt, pu, pv, closest));
+
+        for(u32 lane = 0; bits && lane < 4; ++lane)
+        {
+            if((bits & (1 << lane)) && (!result || pt.E[lane] < closest))
+            {
+                result = true;
+                closest = pt.E[lane];
+                index = 4 * i + lane;
+                u = pu.E[lane];
+                v = pv.E[lane];
+            }
+        }
+    }
+
+    if(result)
+        t = closest;
+
+    return result;
+}
+
+inline b32 RayCastClosest(const trianglex8 *packets, u32 packetCount, const ray3 &r,
+                          u32 &index, r32 &t, r32 &u, r32 &v, r32 maxT = FLT_MAX)
+{
+    b32 result = false;
+    r32 closest = maxT;
+
+    for(u32 i = 0; i < packetCount; ++i)
+    {
+        r32x8 pt, pu, pv;
+        u32 bits = MoveMask(Intersects(packets[i], r, pt, pu, pv, closest));
+
+        for(u32 lane = 0; bits && lane < 8; ++lane)
+        {
+            if((bits & (1 << lane)) && (!result || pt.E[lane] < closest))
+            {
+                result = true;
+                closest = pt.E[lane];
+                index = 8 * i + lane;
+                u = pu.E[lane];
+                v = pv.E[lane];
+            }
+        }
+    }
+
+    if(result)
+        t = closest;
+
+    return result;
+}
+
+//
+// NOTE: SoA segments, closest points between 4 or 8 segment pairs at a time
+//
+
+typedef struct _lineseg3x4
+{
+    vec3x4 origin,
+           direction;
+} lineseg3x4;
+
+typedef struct _lineseg3x8
+{
+    vec3x8 origin,
+           direction;
+} lineseg3x8;
+
+inline lineseg3x4 LineSeg3x4(const lineseg3 &line)
+{
+    lineseg3x4 result;
+
+    result.origin = Vec3x4(line.origin);
+    result.direction = Vec3x4(line.direction);
+
+    return result;
+}
+
+inline lineseg3x8 LineSeg3x8(const lineseg3 &line)
+{
+    lineseg3x8 result;
+
+    result.origin = Vec3x8(line.origin);
+    result.direction = Vec3x8(line.direction);
+
+    return result;
+}
+
+// NOTE: Loads 4 consecutive segments
+inline lineseg3x4 LoadLineSeg3x4(const lineseg3 *src)
+{
+    lineseg3x4 result;
+
+    // NOTE: Lanes alternate origin, direction, origin, direction
+    vec3x4 a = LoadVec3x4(&src[0].origin),
+           b = LoadVec3x4(&src[2].origin);
+
+    result.origin = Vec3x4(EvenLanes(a.x, b.x), EvenLanes(a.y, b.y), EvenLanes(a.z, b.z));
+    result.direction = Vec3x4(OddLanes(a.x, b.x), OddLanes(a.y, b.y), OddLanes(a.z, b.z));
+
+    return result;
+}
+
+// NOTE: Loads 8 consecutive segments
+inline lineseg3x8 LoadLineSeg3x8(const lineseg3 *src)
+{
+    lineseg3x8 result;
+
+    lineseg3x4 lo = LoadLineSeg3x4(src),
+               hi = LoadLineSeg3x4(src + 4);
+
+    result.origin = Vec3x8(lo.origin, hi.origin);
+    result.direction = Vec3x8(lo.direction, hi.direction);
+
+    return result;
+}
+
+// NOTE: The scalar ClosestPoints(lineseg3, lineseg3) with every branch turned
+//       into a select, s and t are the parameters along lineA and lineB.
+//       A div at or below EPSILON * a * c (FMA can take it negative) counts
+//       as parallel.
+inline void ClosestParameters(const lineseg3x4 &lineA, const lineseg3x4 &lineB, r32x4 &s, r32x4 &t)
+{
+    vec3x4 w = lineA.origin - lineB.origin;
+    r32x4 a = Dot(lineA.direction, lineA.direction),
+          b = Dot(lineA.direction, lineB.direction),
+          c = Dot(lineB.direction, lineB.direction),
+          d = Dot(lineA.direction, w),
+          e = Dot(lineB.direction, w),
+          div = a * c - b * b;
+
+    r32x4 zero = R32x4(0.0f),
+          one = R32x4(1.0f),
+          tiny = R32x4(FLT_MIN),
+          epsilon = R32x4(EPSILON),
+          parallel = div <= epsilon * a * c;
+
+    r32x4 sd = Select(parallel, c, div),
+          sn = Select(parallel, zero, b * e - c * d),
+          tn = Select(parallel, e, a * e - b * d),
+          td = sd;
+
+    // NOTE: Clamp S point
+    r32x4 clamp = sn < zero;
+    sn = Select(clamp, zero, sn);
+    tn = Select(clamp, e, tn);
+    td = Select(clamp, c, td);
+
+    clamp = sn > sd;
+    sn = Select(clamp, sd, sn);
+    tn = Select(clamp, e + b, tn);
+    td = Select(clamp, c, td);
+
+    // NOTE: Clamp T point, then S again against the clamped end of B
+    r32x4 lowT = tn < zero,
+          highT = AndNot(lowT, tn > td),
+          invA = one / Max(a, tiny);
+
+    t = Select(lowT, zero, Select(highT, one, tn / Max(td, tiny)));
+    s = Select(lowT, Clamp01(-d * invA),
+               Select(highT, Clamp01((b - d) * invA), sn / Max(sd, tiny)));
+
+    // NOTE: A point segment clamps the other one's parameter against it
+    r32x4 pointA = a <= epsilon,
+          pointB = c <= epsilon;
+
+    t = Select(pointB, zero, Select(pointA, Clamp01(e / Max(c, tiny)), t));
+    s = Select(pointA, zero, Select(pointB, Clamp01(-d * invA), s));
+}
+
+inline void ClosestParameters(const lineseg3x8 &lineA, const lineseg3x8 &lineB, r32x8 &s, r32x8 &t)
+{
+    vec3x8 w = lineA.origin - lineB.origin;
+    r32x8 a = Dot(lineA.direction, lineA.direction),
+          b = Dot(lineA.direction, lineB.direction),
+          c = Dot(lineB.direction, lineB.direction),
+          d = Dot(lineA.direction, w),
+          e = Dot(lineB.direction, w),
+          div = a * c - b * b;
+
+    r32x8 zero = R32x8(0.0f),
+          one = R32x8(1.0f),
+          tiny = R32x8(FLT_MIN),
+          epsilon = R32x8(EPSILON),
+          parallel = div <= epsilon * a * c;
+
+    r32x8 sd = Select(parallel, c, div),
+          sn = Select(parallel, zero, b * e - c * d),
+          tn = Select(parallel, e, a * e - b * d),
+          td = sd;
+
+    // NOTE: Clamp S point
+    r32x8 clamp = sn < zero;
+    sn = Select(clamp, zero, sn);
+    tn = Select(clamp, e, tn);
+    td = Select(clamp, c, td);
+
+    clamp = sn > sd;
+    sn = Select(clamp, sd, sn);
+    tn = Select(clamp, e + b, tn);
+    td = Select(clamp, c, td);
+
+    // NOTE: Clamp T point, then S again against the clamped end of B
+    r32x8 lowT = tn < zero,
+          highT = AndNot(lowT, tn > td),
+          invA = one / Max(a, tiny);
+
+    t = Select(lowT, zero, Select(highT, one, tn / Max(td, tiny)));
+    s = Select(lowT, Clamp01(-d * invA),
+               Select(highT, Clamp01((b - d) * invA), sn / Max(sd, tiny)));
+
+    // NOTE: A point segment clamps the other one's parameter against it
+    r32x8 pointA = a <= epsilon,
+          pointB = c <= epsilon;
+
+    t = Select(pointB, zero, Select(pointA, Clamp01(e / Max(c, tiny)), t));
+    s = Select(pointA, zero, Select(pointB, Clamp01(-d * invA), s));
+}
+
+inline void ClosestPoints(const lineseg3x4 &lineA, const lineseg3x4 &lineB, vec3x4 &pointA, vec3x4 &pointB)
+{
+    r32x4 s, t;
+    ClosestParameters(lineA, lineB, s, t);
+
+    pointA = lineA.origin + s * lineA.direction;
+    pointB = lineB.origin + t * lineB.direction;
+}
+
+inline void ClosestPoints(const lineseg3x8 &lineA, const lineseg3x8 &lineB, vec3x8 &pointA, vec3x8 &pointB)
+{
+    r32x8 s, t;
+    ClosestParameters(lineA, lineB, s, t);
+
+    pointA = lineA.origin + s * lineA.direction;
+    pointB = lineB.origin + t * lineB.direction;
+}
+
+inline r32x4 DistanceSq(const lineseg3x4 &lineA, const lineseg3x4 &lineB)
+{
+    vec3x4 a, b;
+    ClosestPoints(lineA, lineB, a, b);
+
+    return LengthSq(a - b);
+}
+
+inline r32x8 DistanceSq(const lineseg3x8 &lineA, const lineseg3x8 &lineB)
+{
+    vec3x8 a, b;
+    ClosestPoints(lineA, lineB, a, b);
+
+    return LengthSq(a - b);
+}
+
+// NOTE: out[i] = DistanceSq(linesA[i], linesB[i]). The tail is padded with
+//       copies of the last pair, so every pair goes through the same code.
+inline void DistanceSq(const lineseg3 *linesA, const lineseg3 *linesB, u32 count, r32 *out)
+{
+    u32 i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        Store(out + i, DistanceSq(LoadLineSeg3x8(linesA + i), LoadLineSeg3x8(linesB + i)));
+    }
+    if(i < count)
+    {
+        lineseg3 tailA[8], tailB[8];
+        r32 tailOut[8];
+
+        for(u32 j = 0; j < 8; ++j)
+        {
+            u32 k = (i + j < count) ? i + j : count - 1;
+            tailA[j] = linesA[k];
+            tailB[j] = linesB[k];
+        }
+
+        Store(tailOut, DistanceSq(LoadLineSeg3x8(tailA), LoadLineSeg3x8(tailB)));
+
+        for(u32 j = 0; i + j < count; ++j)
+        {
+            out[i + j] = tailOut[j];
+        }
+    }
+}
+
+// NOTE: One against many, out[i] = DistanceSq(line, lines[i])
+inline void DistanceSq(const lineseg3 &line, const lineseg3 *lines, u32 count, r32 *out)
+{
+    lineseg3x8 lineA = LineSeg3x8(line);
+
+    u32 i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        Store(out + i, DistanceSq(lineA, LoadLineSeg3x8(lines + i)));
+    }
+    if(i < count)
+    {
+        lineseg3 tail[8];
+        r32 tailOut[8];
+
+        for(u32 j = 0; j < 8; ++j)
+        {
+            tail[j] = lines[(i + j < count) ? i + j : count - 1];
+        }
+
+        Store(tailOut, DistanceSq(lineA, LoadLineSeg3x8(tail)));
+
+        for(u32 j = 0; i + j < count; ++j)
+        {
+            out[i + j] = tailOut[j];
+        }
+    }
+}
+
+//
+// NOTE: SoA segment queries, one shape against 4 or 8 segments at a time
+//
+
+inline r32x4 DistanceSq(const lineseg3x4 &line, const vec3 &point)
+{
+    vec3x4 w = Vec3x4(point) - line.origin;
+    r32x4 t = Clamp01(Dot(w, line.direction) / Max(LengthSq(line.direction), R32x4(FLT_MIN)));
+
+    return LengthSq(w - t * line.direction);
+}
+
+inline r32x4 AABBSegmentSlope(const vec3x4 &min, const vec3x4 &max, const lineseg3x4 &line, const r32x4 &t)
+{
+    vec3x4 p = line.origin + t * line.direction,
+           q = Vec3x4(Min(Max(p.x, min.x), max.x), Min(Max(p.y, min.y), max.y), Min(Max(p.z, min.z), max.z));
+
+    return Dot(p - q, line.direction);
+}
+
+// NOTE: The scalar ClosestParameter(aabb, lineseg3) with selects. A break
+//       from a zero direction is NaN or inf and never inside (tLo, tHi).
+inline r32x4 ClosestParameter(const aabb &bb, const lineseg3x4 &line)
+{
+    vec3x4 min = Vec3x4(bb.min),
+           max = Vec3x4(bb.max);
+    r32x4 zero = R32x4(0.0f),
+          tLo = zero,
+          tHi = R32x4(1.0f),
+          slopeLo = AABBSegmentSlope(min, max, line, tLo),
+          slopeHi = AABBSegmentSlope(min, max, line, tHi),
+          start = slopeLo >= zero,
+          end = slopeHi <= zero;
+
+    vec3x4 invDirection = Vec3x4(1.0f / line.direction.x, 1.0f / line.direction.y, 1.0f / line.direction.z),
+           lower = Hadamard(min - line.origin, invDirection),
+           upper = Hadamard(max - line.origin, invDirection);
+    r32x4 breaks[6] = { lower.x, upper.x, lower.y, upper.y, lower.z, upper.z };
+
+    for(u32 i = 0; i < 6; ++i)
+    {
+        r32x4 t = breaks[i],
+              slope = AABBSegmentSlope(min, max, line, t),
+              inside = (t > tLo) & (t < tHi),
+              lo = inside & (slope <= zero),
+              hi = AndNot(lo, inside);
+
+        tLo = Select(lo, t, tLo);
+        slopeLo = Select(lo, slope, slopeLo);
+        tHi = Select(hi, t, tHi);
+        slopeHi = Select(hi, slope, slopeHi);
+    }
+
+    r32x4 t = tLo - slopeLo * (tHi - tLo) / (slopeHi - slopeLo);
+
+    return Select(start, zero, Select(end, R32x4(1.0f), t));
+}
+
+inline r32x4 DistanceSq(const aabb &bb, const lineseg3x4 &line)
+{
+    vec3x4 p = line.origin + ClosestParameter(bb, line) * line.direction,
+           min = Vec3x4(bb.min),
+           max = Vec3x4(bb.max);
+
+    return LengthSq(p - Vec3x4(Min(Max(p.x, min.x), max.x), Min(Max(p.y, min.y), max.y), Min(Max(p.z, min.z), max.z)));
+}
+
+// NOTE: The scalar ClosestPoints(ray3, lineseg3) with selects, one ray against
+//       4 segments
+inline void ClosestParameters(const ray3 &ray, const lineseg3x4 &line, r32x4 &s, r32x4 &t)
+{
+    vec3x4 rayDirection = Vec3x4(ray.direction),
+           w = Vec3x4(ray.origin) - line.origin;
+    r32x4 a = R32x4(Dot(ray.direction, ray.direction)),
+          b = Dot(rayDirection, line.direction),
+          c = Dot(line.direction, line.direction),
+          d = Dot(rayDirection, w),
+          e = Dot(line.direction, w),
+          div = a * c - b * b;
+
+    r32x4 zero = R32x4(0.0f),
+          one = R32x4(1.0f),
+          tiny = R32x4(FLT_MIN),
+          epsilon = R32x4(EPSILON),
+          parallel = div <= epsilon * a * c;
+
+    r32x4 sn = Select(parallel, zero, b * e - c * d),
+          sd = Select(parallel, one, div),
+          tn = Select(parallel, e, a * e - b * d),
+          td = Select(parallel, c, div);
+
+    // NOTE: Clamp S point
+    r32x4 clamp = sn < zero;
+    sn = Select(clamp, zero, sn);
+    tn = Select(clamp, e, tn);
+    td = Select(clamp, c, td);
+
+    // NOTE: Clamp T point, then S again against the clamped end of the segment
+    r32x4 lowT = tn < zero,
+          highT = AndNot(lowT, tn > td),
+          invA = one / Max(a, tiny);
+
+    t = Select(lowT, zero, Select(highT, one, tn / Max(td, tiny)));
+    s = Select(lowT, Max(-d, zero) * invA,
+               Select(highT, Max(b - d, zero) * invA, sn / Max(sd, tiny)));
+
+    r32x4 pointA = a <= epsilon,
+          pointB = c <= epsilon;
+
+    t = Select(pointB, zero, Select(pointA, Clamp01(e / Max(c, tiny)), t));
+    s = Select(pointA, zero, Select(pointB, Max(-d, zero) * invA, s));
+}
+
+inline r32x4 DistanceSq(const ray3 &ray, const lineseg3x4 &line)
+{
+    r32x4 s, t;
+    ClosestParameters(ray, line, s, t);
+
+    return LengthSq(Vec3x4(ray.origin) + s * Vec3x4(ray.direction) - (line.origin + t * line.direction));
+}
+
+inline r32x8 DistanceSq(const lineseg3x8 &line, const vec3 &point)
+{
+    vec3x8 w = Vec3x8(point) - line.origin;
+    r32x8 t = Clamp01(Dot(w, line.direction) / Max(LengthSq(line.direction), R32x8(FLT_MIN)));
+
+    return LengthSq(w - t * line.direction);
+}
+
+inline r32x8 AABBSegmentSlope(const vec3x8 &min, const vec3x8 &max, const lineseg3x8 &line, const r32x8 &t)
+{
+    vec3x8 p = line.origin + t * line.direction,
+           q = Vec3x8(Min(Max(p.x, min.x), max.x), Min(Max(p.y, min.y), max.y), Min(Max(p.z, min.z), max.z));
+
+    return Dot(p - q, line.direction);
+}
+
+// NOTE: The scalar ClosestParameter(aabb, lineseg3) with selects. A break
+//       from a zero direction is NaN or inf and never inside (tLo, tHi).
+inline r32x8 ClosestParameter(const aabb &bb, const lineseg3x8 &line)
+{
+    vec3x8 min = Vec3x8(bb.min),
+           max = Vec3x8(bb.max);
+    r32x8 zero = R32x8(0.0f),
+          tLo = zero,
+          tHi = R32x8(1.0f),
+          slopeLo = AABBSegmentSlope(min, max, line, tLo),
+          slopeHi = AABBSegmentSlope(min, max, line, tHi),
+          start = slopeLo >= zero,
+          end = slopeHi <= zero;
+
+    vec3x8 invDirection = Vec3x8(1.0f / line.direction.x, 1.0f / line.direction.y, 1.0f / line.direction.z),
+           lower = Hadamard(min - line.origin, invDirection),
+           upper = Hadamard(max - line.origin, invDirection);
+    r32x8 breaks[6] = { lower.x, upper.x, lower.y, upper.y, lower.z, upper.z };
+
+    for(u32 i = 0; i < 6; ++i)
+    {
+        r32x8 t = breaks[i],
+              slope = AABBSegmentSlope(min, max, line, t),
+              inside = (t > tLo) & (t < tHi),
+              lo = inside & (slope <= zero),
+              hi = AndNot(lo, inside);
+
+        tLo = Select(lo, t, tLo);
+        slopeLo = Select(lo, slope, slopeLo);
+        tHi = Select(hi, t, tHi);
+        slopeHi = Select(hi, slope, slopeHi);
+    }
+
+    r32x8 t = tLo - slopeLo * (tHi - tLo) / (slopeHi - slopeLo);
+
+    return Select(start, zero, Select(end, R32x8(1.0f), t));
+}
+
+inline r32x8 DistanceSq(const aabb &bb, const lineseg3x8 &line)
+{
+    vec3x8 p = line.origin + ClosestParameter(bb, line) * line.direction,
+           min = Vec3x8(bb.min),
+           max = Vec3x8(bb.max);
+
+    return LengthSq(p - Vec3x8(Min(Max(p.x, min.x), max.x), Min(Max(p.y, min.y), max.y), Min(Max(p.z, min.z), max.z)));
+}
+
+// NOTE: The scalar ClosestPoints(ray3, lineseg3) with selects, one ray against
+//       8 segments
+inline void ClosestParameters(const ray3 &ray, const lineseg3x8 &line, r32x8 &s, r32x8 &t)
+{
+    vec3x8 rayDirection = Vec3x8(ray.direction),
+           w = Vec3x8(ray.origin) - line.origin;
+    r32x8 a = R32x8(Dot(ray.direction, ray.direction)),
+          b = Dot(rayDirection, line.direction),
+          c = Dot(line.direction, line.direction),
+          d = Dot(rayDirection, w),
+          e = Dot(line.direction, w),
+          div = a * c - b * b;
+
+    r32x8 zero = R32x8(0.0f),
+          one = R32x8(1.0f),
+          tiny = R32x8(FLT_MIN),
+          epsilon = R32x8(EPSILON),
+          parallel = div <= epsilon * a * c;
+
+    r32x8 sn = Select(parallel, zero, b * e - c * d),
+          sd = Select(parallel, one, div),
+          tn = Select(parallel, e, a * e - b * d),
+          td = Select(parallel, c, div);
+
+    // NOTE: Clamp S point
+    r32x8 clamp = sn < zero;
+    sn = Select(clamp, zero, sn);
+    tn = Select(clamp, e, tn);
+    td = Select(clamp, c, td);
+
+    // NOTE: Clamp T point, then S again against the clamped end of the segment
+    r32x8 lowT = tn < zero,
+          highT = AndNot(lowT, tn > td),
+          invA = one / Max(a, tiny);
+
+    t = Select(lowT, zero, Select(highT, one, tn / Max(td, tiny)));
+    s = Select(lowT, Max(-d, zero) * invA,
+               Select(highT, Max(b - d, zero) * invA, sn / Max(sd, tiny)));
+
+    r32x8 pointA = a <= epsilon,
+          pointB = c <= epsilon;
+
+    t = Select(pointB, zero, Select(pointA, Clamp01(e / Max(c, tiny)), t));
+    s = Select(pointA, zero, Select(pointB, Max(-d, zero) * invA, s));
+}
+
+inline r32x8 DistanceSq(const ray3 &ray, const lineseg3x8 &line)
+{
+    r32x8 s, t;
+    ClosestParameters(ray, line, s, t);
+
+    return LengthSq(Vec3x8(ray.origin) + s * Vec3x8(ray.direction) - (line.origin + t * line.direction));
+}
+
+//
+// NOTE: SoA capsules, 4 or 8 per lane set
+//
+
+typedef struct _capsulex4
+{
+    lineseg3x4 segment;
+    r32x4 radius;
+} capsulex4;
+
+typedef struct _capsulex8
+{
+    lineseg3x8 segment;
+    r32x8 radius;
+} capsulex8;
+
+inline capsulex4 Capsulex4(const capsule &c)
+{
+    capsulex4 result;
+
+    result.segment = LineSeg3x4(c.segment);
+    result.radius = R32x4(c.radius);
+
+    return result;
+}
+
+inline capsulex8 Capsulex8(const capsule &c)
+{
+    capsulex8 result;
+
+    result.segment = LineSeg3x8(c.segment);
+    result.radius = R32x8(c.radius);
+
+    return result;
+}
+
+// NOTE: Loads the first count (1 to 4) capsules, the remaining lanes repeat
+//       the last one
+inline capsulex4 LoadCapsulex4(const capsule *src, u32 count = 4)
+{
+    AAM_Assert(count > 0);
+
+    capsulex4 result;
+
+    u32 i1 = (count > 1) ? 1 : 0,
+        i2 = (count > 2) ? 2 : i1,
+        i3 = (count > 3) ? 3 : i2;
+
+    const capsule &c0 = src[0],
+                  &c1 = src[i1],
+                  &c2 = src[i2],
+                  &c3 = src[i3];
+
+#if defined(AAMATH_SSE4)
+    // NOTE: Two overlapping 4x4 transposes, origin + direction.x then
+    //       direction + radius
+    __m128 o0 = _mm_loadu_ps(&c0.segment.origin.x),
+           o1 = _mm_loadu_ps(&c1.segment.origin.x),
+           o2 = _mm_loadu_ps(&c2.segment.origin.x),
+           o3 = _mm_loadu_ps(&c3.segment.origin.x),
+           d0 = _mm_loadu_ps(&c0.segment.direction.x),
+           d1 = _mm_loadu_ps(&c1.segment.direction.x),
+           d2 = _mm_loadu_ps(&c2.segment.direction.x),
+           d3 = _mm_loadu_ps(&c3.segment.direction.x);
+
+    _MM_TRANSPOSE4_PS(o0, o1, o2, o3);
+    _MM_TRANSPOSE4_PS(d0, d1, d2, d3);
+
+    result.segment.origin.x.m = o0;
+    result.segment.origin.y.m = o1;
+    result.segment.origin.z.m = o2;
+    result.segment.direction.x.m = d0;
+    result.segment.direction.y.m = d1;
+    result.segment.direction.z.m = d2;
+    result.radius.m = d3;
+#else
+    result.segment.origin = Vec3x4(R32x4(c0.segment.origin.x, c1.segment.origin.x, c2.segment.origin.x, c3.segment.origin.x),
+                                   R32x4(c0.segment.origin.y, c1.segment.origin.y, c2.segment.origin.y, c3.segment.origin.y),
+                                   R32x4(c0.segment.origin.z, c1.segment.origin.z, c2.segment.origin.z, c3.segment.origin.z));
+    result.segment.direction = Vec3x4(R32x4(c0.segment.direction.x, c1.segment.direction.x, c2.segment.direction.x, c3.segment.direction.x),
+                                      R32x4(c0.segment.direction.y, c1.segment.direction.y, c2.segment.direction.y, c3.segment.direction.y),
+                                      R32x4(c0.segment.direction.z, c1.segment.direction.z, c2.segment.direction.z, c3.segment.direction.z));
+    result.radius = R32x4(c0.radius, c1.radius, c2.radius, c3.radius);
+#endif
+
+    return result;
+}
+
+// NOTE: As above, 1 to 8 capsules
+inline capsulex8 LoadCapsulex8(const capsule *src, u32 count = 8)
+{
+    AAM_Assert(count > 0);
+
+    capsulex8 result;
+
+    capsulex4 lo = LoadCapsulex4(src, count),
+              hi = (count > 4) ? LoadCapsulex4(src + 4, count - 4) : LoadCapsulex4(src + count - 1, 1);
+
+    result.segment.origin = Vec3x8(lo.segment.origin, hi.segment.origin);
+    result.segment.direction = Vec3x8(lo.segment.direction, hi.segment.direction);
+    result.radius = R32x8(lo.radius, hi.radius);
+
+    return result;
+}
+
+inline r32x4 Distance(const capsulex4 &a, const capsulex4 &b)
+{
+    return Sqrt(DistanceSq(a.segment, b.segment)) - (a.radius + b.radius);
+}
+
+inline r32x4 Distance(const capsulex4 &c, const sphere &s)
+{
+    return Sqrt(DistanceSq(c.segment, s.origin)) - (c.radius + R32x4(s.radius));
+}
+
+inline r32x4 Distance(const capsulex4 &c, const aabb &bb)
+{
+    return Sqrt(DistanceSq(bb, c.segment)) - c.radius;
+}
+
+inline r32x4 Distance(const capsulex4 &c, const ray3 &r)
+{
+    return Sqrt(DistanceSq(r, c.segment)) - c.radius;
+}
+
+inline r32x4 Intersects(const capsulex4 &a, const capsulex4 &b)
+{
+    r32x4 radius = a.radius + b.radius;
+
+    return DistanceSq(a.segment, b.segment) <= radius * radius;
+}
+
+inline r32x4 Intersects(const capsulex4 &c, const sphere &s)
+{
+    r32x4 radius = c.radius + R32x4(s.radius);
+
+    return DistanceSq(c.segment, s.origin) <= radius * radius;
+}
+
+inline r32x4 Intersects(const capsulex4 &c, const aabb &bb)
+{
+    return DistanceSq(bb, c.segment) <= c.radius * c.radius;
+}
+
+inline r32x4 Intersects(const capsulex4 &c, const ray3 &r)
+{
+    return DistanceSq(r, c.segment) <= c.radius * c.radius;
+}
+
+inline r32x8 Distance(const capsulex8 &a, const capsulex8 &b)
+{
+    return Sqrt(DistanceSq(a.segment, b.segment)) - (a.radius + b.radius);
+}
+
+inline r32x8 Distance(const capsulex8 &c, const sphere &s)
+{
+    return Sqrt(DistanceSq(c.segment, s.origin)) - (c.radius + R32x8(s.radius));
+}
+
+inline r32x8 Distance(const capsulex8 &c, const aabb &bb)
+{
+    return Sqrt(DistanceSq(bb, c.segment)) - c.radius;
+}
+
+inline r32x8 Distance(const capsulex8 &c, const ray3 &r)
+{
+    return Sqrt(DistanceSq(r, c.segment)) - c.radius;
+}
+
+inline r32x8 Intersects(const capsulex8 &a, const capsulex8 &b)
+{
+    r32x8 radius = a.radius + b.radius;
+
+    return DistanceSq(a.segment, b.segment) <= radius * radius;
+}
+
+inline r32x8 Intersects(const capsulex8 &c, const sphere &s)
+{
+    r32x8 radius = c.radius + R32x8(s.radius);
+
+    return DistanceSq(c.segment, s.origin) <= radius * radius;
+}
+
+inline r32x8 Intersects(const capsulex8 &c, const aabb &bb)
+{
+    return DistanceSq(bb, c.segment) <= c.radius * c.radius;
+}
+
+inline r32x8 Intersects(const capsulex8 &c, const ray3 &r)
+{
+    return DistanceSq(r, c.segment) <= c.radius * c.radius;
+}
+
+// NOTE: out[i] = Distance(query, capsules[i]), negative where they overlap
+inline void Distance(const capsule &query, const capsule *capsules, u32 count, r32 *out)
+{
+    capsulex8 q = Capsulex8(query);
+
+    for(u32 i = 0; i < count; i += 8)
+    {
+        Store(out + i, Distance(q, LoadCapsulex8(capsules + i, count - i)), count - i);
+    }
+}
+
+inline void Distance(const sphere &query, const capsule *capsules, u32 count, r32 *out)
+{
+    for(u32 i = 0; i < count; i += 8)
+    {
+        Store(out + i, Distance(LoadCapsulex8(capsules + i, count - i), query), count - i);
+    }
+}
+
+inline void Distance(const aabb &query, const capsule *capsules, u32 count, r32 *out)
+{
+    for(u32 i = 0; i < count; i += 8)
+    {
+        Store(out + i, Distance(LoadCapsulex8(capsules + i, count - i), query), count - i);
+    }
+}
+
+inline void Distance(const ray3 &query, const capsule *capsules, u32 count, r32 *out)
+{
+    for(u32 i = 0; i < count; i += 8)
+    {
+        Store(out + i, Distance(LoadCapsulex8(capsules + i, count - i), query), count - i);
+    }
+}
+
+// NOTE: out[i] = Distance(capsulesA[i], capsulesB[i])
+inline void Distance(const capsule *capsulesA, const capsule *capsulesB, u32 count, r32 *out)
+{
+    for(u32 i = 0; i < count; i += 8)
+    {
+        Store(out + i, Distance(LoadCapsulex8(capsulesA + i, count - i), LoadCapsulex8(capsulesB + i, count - i)), count - i);
+    }
+}
+
+//
+// NOTE: Frustum
+//
+
+// NOTE: Planes face inwards, in the order left, right, bottom, top, near, far
+typedef struct _frustum
+{
+    plane planes[6];
+} frustum;
+
+// NOTE: Gribb/Hartmann plane extraction from a (view-)projection matrix,
+//       -w <= x, y, z <= w clip space as produced by Perspective/Orthographic.
+//       Math row i of our basis-row layout is (x.E[i], y.E[i], z.E[i], t.E[i]).
+inline frustum Frustum(const mat4 &m)
+{
+    frustum result;
+
+    for(u32 i = 0; i < 3; ++i)
+    {
+        result.planes[2 * i] = Plane(m.xw + m.x.E[i], m.yw + m.y.E[i],
+                                     m.zw + m.z.E[i], m.ww + m.t.E[i]);
+        result.planes[2 * i + 1] = Plane(m.xw - m.x.E[i], m.yw - m.y.E[i],
+                                         m.zw - m.z.E[i], m.ww - m.t.E[i]);
+    }
+
+    return result;
+}
+
+// NOTE: False only when the box is entirely outside one of the planes
+inline b32 Intersects(const frustum &f, const aabb &bb)
+{
+    for(u32 i = 0; i < 6; ++i)
+    {
+        if(Test(bb, f.planes[i]) < 0.0f)
+            return false;
+    }
+
+    return true;
+}
+
+inline b32 Intersects(const frustum &f, const sphere &s)
+{
+    for(u32 i = 0; i < 6; ++i)
+    {
+        if(Test(f.planes[i], s.origin) < -s.radius)
+            return false;
+    }
+
+    return true;
+}
+
+// NOTE: Lanes entirely behind the plane, for boxes given as centre/half-extents
+inline r32x4 Outside(const plane &p, const vec3x4 &centre, const vec3x4 &extents)
+{
+    r32x4 dist = Dot(Vec3x4(p.normal), centre) + p.offset;
+    r32x4 radius = MulAdd(R32x4(fabsf(p.normal.z)), extents.z,
+                          MulAdd(R32x4(fabsf(p.normal.y)), extents.y,
+                                 R32x4(fabsf(p.normal.x)) * extents.x));
+
+    return (dist + radius) < R32x4(0.0f);
+}
+
+// NOTE: Same as above, with a different plane per lane
+inline r32x4 Outside(const vec3x4 &normal, const r32x4 &offset, const vec3x4 &centre, const vec3x4 &extents)
+{
+    r32x4 dist = Dot(normal, centre) + offset;
+    r32x4 radius = MulAdd(Abs(normal.z), extents.z,
+                          MulAdd(Abs(normal.y), extents.y, Abs(normal.x) * extents.x));
+
+    return (dist + radius) < R32x4(0.0f);
+}
+
+// NOTE: Gathers one plane per lane (the cached rejecting planes)
+inline void LoadPlanes(const frustum &f, const u8 *indices, vec3x4 &normal, r32x4 &offset)
+{
+    const plane &p0 = f.planes[indices[0]],
+                &p1 = f.planes[indices[1]],
+                &p2 = f.planes[indices[2]],
+                &p3 = f.planes[indices[3]];
+
+    normal = Vec3x4(R32x4(p0.normal.x, p1.normal.x, p2.normal.x, p3.normal.x),
+                    R32x4(p0.normal.y, p1.normal.y, p2.normal.y, p3.normal.y),
+                    R32x4(p0.normal.z, p1.normal.z, p2.normal.z, p3.normal.z));
+    offset = R32x4(p0.offset, p1.offset, p2.offset, p3.offset);
+}
+
+// NOTE: Writes a visibility bitmask, bit (i % 32) of visible[i / 32] set when
+//       boxes[i] is at least partially inside; visible needs (count + 31) / 32 words.
+//
+//       planeCache is optional (0 to skip), one entry per box holding the last
+//       plane that rejected it (0..5). That plane is tested first, as objects
+//       tend to stay culled by the same plane from frame to frame; initialise
+//       the cache to zeros.
+inline void Cull(const frustum &f, const aabb *boxes, u32 count, u32 *visible, u8 *planeCache = 0)
+{
+    for(u32 i = 0; i < (count + 31) / 32; ++i)
+    {
+        visible[i] = 0;
+    }
+
+    u32 i = 0;
+    for(; i + 4 <= count; i += 4)
+    {
+        aabbx4 bb = LoadAABBx4(boxes + i);
+        vec3x4 centre = 0.5f * (bb.min + bb.max),
+               extents = 0.5f * (bb.max - bb.min);
+
+        r32x4 outside = R32x4(0.0f);
+
+        if(planeCache)
+        {
+            vec3x4 normal;
+            r32x4 offset;
+            LoadPlanes(f, planeCache + i, normal, offset);
+
+            outside = Outside(normal, offset, centre, extents);
+        }
+
+        for(u32 p = 0; p < 6 && !All(outside); ++p)
+        {
+            r32x4 rejected = AndNot(outside, Outside(f.planes[p], centre, extents));
+
+            if(planeCache)
+            {
+                u32 bits = MoveMask(rejected);
+                for(u32 lane = 0; lane < 4; ++lane)
+                {
+                    if(bits & (1 << lane))
+                        planeCache[i + lane] = (u8)p;
+                }
+            }
+
+            outside = outside | rejected;
+        }
+
+        visible[i >> 5] |= (~MoveMask(outside) & 0xF) << (i & 31);
+    }
+    for(; i < count; ++i)
+    {
+        b32 inside = true;
+
+        if(planeCache && Test(boxes[i], f.planes[planeCache[i]]) < 0.0f)
+        {
+            inside = false;
+        }
+
+        for(u32 p = 0; inside && p < 6; ++p)
+        {
+            if(Test(boxes[i], f.planes[p]) < 0.0f)
+            {
+                inside = false;
+                if(planeCache)
+                    planeCache[i] = (u8)p;
+            }
+        }
+
+        if(inside)
+            visible[i >> 5] |= 1 << (i & 31);
+    }
+}
+
+// NOTE: As above, for spheres
+inline void Cull(const frustum &f, const sphere *spheres, u32 count, u32 *visible, u8 *planeCache = 0)
+{
+    for(u32 i = 0; i < (count + 31) / 32; ++i)
+    {
+        visible[i] = 0;
+    }
+
+    u32 i = 0;
+    for(; i + 4 <= count; i += 4)
+    {
+        // NOTE: sphere is laid out as a vec4 (origin, radius)
+        vec4x4 s = LoadVec4x4((const vec4 *)(spheres + i));
+        vec3x4 centre = Vec3x4(s.x, s.y, s.z);
+        r32x4 negRadius = -s.w;
+
+        r32x4 outside = R32x4(0.0f);
+
+        if(planeCache)
+        {
+            vec3x4 normal;
+            r32x4 offset;
+            LoadPlanes(f, planeCache + i, normal, offset);
+
+            outside = (Dot(normal, centre) + offset) < negRadius;
+        }
+
+        for(u32 p = 0; p < 6 && !All(outside); ++p)
+        {
+            const plane &pl = f.planes[p];
+            r32x4 dist = Dot(Vec3x4(pl.normal), centre) + pl.offset;
+            r32x4 rejected = AndNot(outside, dist < negRadius);
+
+            if(planeCache)
+            {
+                u32 bits = MoveMask(rejected);
+                for(u32 lane = 0; lane < 4; ++lane)
+                {
+                    if(bits & (1 << lane))
+                        planeCache[i + lane] = (u8)p;
+                }
+            }
+
+            outside = outside | rejected;
+        }
+
+        visible[i >> 5] |= (~MoveMask(outside) & 0xF) << (i & 31);
+    }
+    for(; i < count; ++i)
+    {
+        const sphere &s = spheres[i];
+        b32 inside = true;
+
+        if(planeCache && Test(f.planes[planeCache[i]], s.origin) < -s.radius)
+        {
+            inside = false;
+        }
+
+        for(u32 p = 0; inside && p < 6; ++p)
+        {
+            if(Test(f.planes[p], s.origin) < -s.radius)
+            {
+                inside = false;
+                if(planeCache)
+                    planeCache[i] = (u8)p;
+            }
+        }
+
+        if(inside)
+            visible[i >> 5] |= 1 << (i & 31);
+    }
+}
+
+//
+// NOTE: Plane classification, one plane against many points or spheres
+//
+
+// NOTE: Sides of a plane as bits, so the sides of several points can be or'd
+//       together (a polygon with PLANE_SPANNING crosses the plane)
+typedef enum _planeside
+{
+    PLANE_ON = 0,           // NOTE: Within epsilon, or a sphere straddling the plane
+    PLANE_FRONT = 1,
+    PLANE_BACK = 2,
+    PLANE_SPANNING = PLANE_FRONT | PLANE_BACK
+} planeside;
+
+inline u32 Classify(const plane &p, const vec3 &point, r32 epsilon = 0.0f)
+{
+    r32 dist = Test(p, point);
+
+    return (dist > epsilon) ? PLANE_FRONT : ((dist < -epsilon) ? PLANE_BACK : PLANE_ON);
+}
+
+inline u32 Classify(const plane &p, const sphere &s)
+{
+    r32 dist = Test(p, s.origin);
+
+    return (dist > s.radius) ? PLANE_FRONT : ((dist < -s.radius) ? PLANE_BACK : PLANE_ON);
+}
+
+// NOTE: Writes the sides of 8 lanes from their front and back masks, one
+//       byte each
+inline void StoreSides(u8 *dst, const r32x8 &front, const r32x8 &back)
+{
+#if defined(AAMATH_SSE4)
+    __m128i one = _mm_set1_epi32(PLANE_FRONT),
+            two = _mm_set1_epi32(PLANE_BACK),
+            lo = _mm_or_si128(_mm_and_si128(_mm_castps_si128(Low(front).m), one),
+                              _mm_and_si128(_mm_castps_si128(Low(back).m), two)),
+            hi = _mm_or_si128(_mm_and_si128(_mm_castps_si128(High(front).m), one),
+                              _mm_and_si128(_mm_castps_si128(High(back).m), two)),
+            words = _mm_packus_epi32(lo, hi);
+
+    _mm_storel_epi64((__m128i *)dst, _mm_packus_epi16(words, words));
+#else
+    // NOTE: Spreads 4 mask bits at a time over the bytes, so the multiply
+    //       carries never reach the next byte
+    u32 f = MoveMask(front),
+        b = MoveMask(back),
+        lo = ((f & 0xF) * 0x00204081u & 0x01010101u) | (((b & 0xF) * 0x00204081u & 0x01010101u) << 1),
+        hi = ((f >> 4) * 0x00204081u & 0x01010101u) | (((b >> 4) * 0x00204081u & 0x01010101u) << 1);
+
+    for(u32 i = 0; i < 4; ++i)
+    {
+        dst[i] = (u8)(lo >> (8 * i));
+        dst[i + 4] = (u8)(hi >> (8 * i));
+    }
+#endif
+}
+
+// NOTE: outDist[i] = Test(p, points[i]) and outSide[i] = Classify(p, points[i],
+//       epsilon), either output may be 0. Streams 8 points at a time, the
+//       plane stays in registers.
+inline void ClassifyPoints(const plane &p, const vec3 *points, u32 count,
+                           r32 *outDist, u8 *outSide, r32 epsilon = 0.0f)
+{
+    vec3x8 normal = Vec3x8(p.normal);
+    r32x8 offset = R32x8(p.offset),
+          front = R32x8(epsilon),
+          back = R32x8(-epsilon);
+
+    u32 i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        r32x8 dist = Dot(normal, LoadVec3x8(points + i)) + offset;
+
+        if(outDist)
+            Store(outDist + i, dist);
+
+        if(outSide)
+            StoreSides(outSide + i, dist > front, dist < back);
+    }
+    for(; i < count; ++i)
+    {
+        r32 dist = Test(p, points[i]);
+
+        if(outDist)
+            outDist[i] = dist;
+
+        if(outSide)
+            outSide[i] = (u8)((dist > epsilon) ? PLANE_FRONT : ((dist < -epsilon) ? PLANE_BACK : PLANE_ON));
+    }
+}
+
+// NOTE: outDist[i] = Test(p, spheres[i]) (0 while straddling) and
+//       outSide[i] = Classify(p, spheres[i]), either output may be 0
+inline void ClassifySpheres(const plane &p, const sphere *spheres, u32 count,
+                            r32 *outDist, u8 *outSide)
+{
+    vec3x8 normal = Vec3x8(p.normal);
+    r32x8 offset = R32x8(p.offset);
+
+    u32 i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        // NOTE: sphere is laid out as a vec4 (origin, radius)
+        vec4x4 lo = LoadVec4x4((const vec4 *)(spheres + i)),
+               hi = LoadVec4x4((const vec4 *)(spheres + i + 4));
+        vec3x8 centre = Vec3x8(R32x8(lo.x, hi.x), R32x8(lo.y, hi.y), R32x8(lo.z, hi.z));
+        r32x8 radius = R32x8(lo.w, hi.w),
+              dist = Dot(normal, centre) + offset;
+
+        if(outDist)
+            Store(outDist + i, dist - Min(Max(dist, -radius), radius));
+
+        if(outSide)
+            StoreSides(outSide + i, dist > radius, dist < -radius);
+    }
+    for(; i < count; ++i)
+    {
+        if(outDist)
+            outDist[i] = Test(p, spheres[i]);
+
+        if(outSide)
+            outSide[i] = (u8)Classify(p, spheres[i]);
+    }
+}
+
+// NOTE: Every point against every plane. outMasks holds planeCount rows of
+//       (count + 31) / 32 words, bit (i % 32) of word i / 32 in row j is set
+//       when points[i] is on or in front of planes[j]. And'ing the rows of
+//       inward facing planes gives the points inside their convex volume.
+inline void ClassifyPoints(const plane *planes, u32 planeCount, const vec3 *points, u32 count, u32 *outMasks)
+{
+    u32 words = (count + 31) / 32;
+    r32x8 zero = R32x8(0.0f);
+
+    // NOTE: 32 points at a time, a whole word per plane
+    u32 i = 0;
+    for(; i + 32 <= count; i += 32)
+    {
+        vec3x8 v0 = LoadVec3x8(points + i),
+               v1 = LoadVec3x8(points + i + 8),
+               v2 = LoadVec3x8(points + i + 16),
+               v3 = LoadVec3x8(points + i + 24);
+        u32 *row = outMasks + (i >> 5);
+
+        for(u32 j = 0; j < planeCount; ++j, row += words)
+        {
+            vec3x8 normal = Vec3x8(planes[j].normal);
+            r32x8 offset = R32x8(planes[j].offset);
+
+            *row = ~(MoveMask(Dot(normal, v0) + offset < zero)
+                     | (MoveMask(Dot(normal, v1) + offset < zero) << 8)
+                     | (MoveMask(Dot(normal, v2) + offset < zero) << 16)
+                     | (MoveMask(Dot(normal, v3) + offset < zero) << 24));
+        }
+    }
+
+    if(i < count)
+    {
+        u32 *row = outMasks + (i >> 5);
+
+        for(u32 j = 0; j < planeCount; ++j)
+        {
+            row[j * words] = 0;
+        }
+    }
+
+    for(; i + 8 <= count; i += 8)
+    {
+        vec3x8 v = LoadVec3x8(points + i);
+        u32 *row = outMasks + (i >> 5);
+
+        for(u32 j = 0; j < planeCount; ++j, row += words)
+        {
+            r32x8 dist = Dot(Vec3x8(planes[j].normal), v) + planes[j].offset;
+
+            *row |= (~MoveMask(dist < zero) & 0xFF) << (i & 31);
+        }
+    }
+    for(; i < count; ++i)
+    {
+        u32 *row = outMasks + (i >> 5);
+
+        for(u32 j = 0; j < planeCount; ++j, row += words)
+        {
+            if(Test(planes[j], points[i]) >= 0.0f)
+                *row |= 1 << (i & 31);
+        }
+    }
+}
+
 } // NOTE: Namespace
 
 #endif
@@ -0,0 +1,167 @@
+// NOTE: CPU feature detection and table binding for dispatch.h. Built without
+//       any SIMD flags and calls nothing from the library, only the fill
+//       functions of the per-level translation units.
+
+#define AAMATH_DISPATCH_KERNELS
+#include "dispatch.h"
+
+#if defined(AAMATH_DISPATCH_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace aam {
+
+#if defined(AAMATH_DISPATCH_X86)
+static void CPUID(u32 leaf, u32 subleaf, u32 *regs)
+{
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, (int)leaf, (int)subleaf);
+    regs[0] = (u32)r[0];
+    regs[1] = (u32)r[1];
+    regs[2] = (u32)r[2];
+    regs[3] = (u32)r[3];
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// NOTE: Register state the OS saves on context switches (XCR0)
+static u64 XGETBV()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    u32 lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((u64)hi << 32) | lo;
+#endif
+}
+#endif
+
+static simdlevel DetectSIMDLevelOnce()
+{
+    simdlevel result = SIMD_LEVEL_SCALAR;
+
+#if defined(AAMATH_DISPATCH_X86)
+    u32 regs[4];
+
+    CPUID(0, 0, regs);
+    u32 maxLeaf = regs[0];
+
+    if(maxLeaf < 1)
+        return result;
+
+    CPUID(1, 0, regs);
+    u32 ecx1 = regs[2];
+
+    b32 sse41 = (ecx1 >> 19) & 1,
+        fma = (ecx1 >> 12) & 1,
+        osxsave = (ecx1 >> 27) & 1,
+        avx = (ecx1 >> 28) & 1;
+
+    if(!sse41)
+        return result;
+
+    result = SIMD_LEVEL_SSE4;
+
+    if(!osxsave || !avx || maxLeaf < 7)
+        return result;
+
+    // NOTE: XMM and YMM state, then opmask and both ZMM halves
+    u64 xcr0 = XGETBV();
+    b32 osAVX = (xcr0 & 0x6) == 0x6,
+        osAVX512 = (xcr0 & 0xE6) == 0xE6;
+
+    CPUID(7, 0, regs);
+    u32 ebx7 = regs[1];
+
+    b32 avx2 = (ebx7 >> 5) & 1,
+        avx512f = (ebx7 >> 16) & 1,
+        avx512dq = (ebx7 >> 17) & 1,
+        avx512bw = (ebx7 >> 30) & 1,
+        avx512vl = (ebx7 >> 31) & 1;
+
+    if(!osAVX || !avx2 || !fma)
+        return result;
+
+    result = SIMD_LEVEL_AVX2;
+
+    if(osAVX512 && avx512f && avx512dq && avx512bw && avx512vl)
+        result = SIMD_LEVEL_AVX512;
+#endif
+
+    return result;
+}
+
+simdlevel DetectSIMDLevel()
+{
+    static simdlevel detected = DetectSIMDLevelOnce();
+
+    return detected;
+}
+
+static dispatchtable GlobalDispatchTable;
+
+static void BindDispatchTable(simdlevel level)
+{
+    switch(level)
+    {
+#if defined(AAMATH_DISPATCH_X86)
+        case SIMD_LEVEL_AVX512: FillDispatchTableAVX512(GlobalDispatchTable); break;
+        case SIMD_LEVEL_AVX2: FillDispatchTableAVX2(GlobalDispatchTable); break;
+        case SIMD_LEVEL_SSE4: FillDispatchTableSSE4(GlobalDispatchTable); break;
+#endif
+        default: level = SIMD_LEVEL_SCALAR; FillDispatchTableScalar(GlobalDispatchTable); break;
+    }
+
+    GlobalDispatchTable.level = level;
+}
+
+static b32 InitDispatchTable()
+{
+    BindDispatchTable(DetectSIMDLevel());
+
+    return true;
+}
+
+const dispatchtable &GetDispatchTable()
+{
+    static b32 initialized = InitDispatchTable();
+    (void)initialized;
+
+    return GlobalDispatchTable;
+}
+
+simdlevel SetSIMDLevel(simdlevel level)
+{
+    GetDispatchTable();
+
+    simdlevel detected = DetectSIMDLevel();
+    BindDispatchTable((level < detected) ? level : detected);
+
+    return GlobalDispatchTable.level;
+}
+
+simdlevel GetSIMDLevel()
+{
+    return GetDispatchTable().level;
+}
+
+const char *SIMDLevelName(simdlevel level)
+{
+    switch(level)
+    {
+        case SIMD_LEVEL_SCALAR: return "scalar";
+        case SIMD_LEVEL_SSE4: return "sse4.1";
+        case SIMD_LEVEL_AVX2: return "avx2";
+        case SIMD_LEVEL_AVX512: return "avx512";
+        default: return "unknown";
+    }
+}
+
+} // NOTE: Namespace
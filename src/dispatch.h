@@ -0,0 +1,187 @@
+#ifndef DISPATCH_H
+#define DISPATCH_H
+
+#include "aatypes.h"
+
+namespace aam {
+
+// NOTE: Runtime dispatch of the array-level kernels, for binaries that have to
+//       run on several CPU generations. The rest of the library picks its
+//       backend at compile time (AAMATH_SSE4/AAMATH_AVX2); these kernels are
+//       instead built once per level (dispatch_*.cpp, each with its own
+//       compiler flags) and the best level the CPU and OS support is bound on
+//       first use. Not header-only: link the aamath_dispatch library.
+//
+//       SIMD_LEVEL_AVX512 runs the AVX2 kernels built with the AVX-512 flags,
+//       the library has no 512-bit code paths of its own.
+//
+//       The kernels take untyped pointers so the per-level translation units
+//       never see the aam types of the including code, the typed wrappers are
+//       in aam::dispatch below.
+
+typedef enum _simdlevel
+{
+    SIMD_LEVEL_SCALAR,
+    SIMD_LEVEL_SSE4,
+    SIMD_LEVEL_AVX2,
+    SIMD_LEVEL_AVX512,
+
+    SIMD_LEVEL_COUNT
+} simdlevel;
+
+// NOTE: m is a mat4 or mat4x3, in/out arrays of vec3 or vec4
+typedef void dispatch_transform(const void *m, const void *in, void *out, u32 count);
+// NOTE: t is per element, or a single value shared by the batch when tStride is 0
+typedef void dispatch_interpolate(const void *start, const void *end, const r32 *t, u32 tStride,
+                                  void *out, u32 count, b32 approxNormalize);
+typedef void dispatch_cull(const void *f, const void *volumes, u32 count, u32 *visible, u8 *planeCache);
+typedef void dispatch_skin(const void *palette, const void *weights, const void *positions, const void *normals,
+                           void *outPositions, void *outNormals, u32 count);
+
+typedef struct _dispatchtable
+{
+    simdlevel level;
+
+    dispatch_transform *transformPoints,
+                       *transformDirections,
+                       *transformPointsProjective,
+                       *transformVec4,
+                       *transformPointsAffine,
+                       *transformDirectionsAffine;
+
+    dispatch_interpolate *slerp,
+                         *nlerp,
+                         *approxSlerp;
+
+    dispatch_cull *cullAABBs,
+                  *cullSpheres;
+
+    dispatch_skin *skinLinear,
+                  *skinDualQuat;
+} dispatchtable;
+
+// NOTE: One per level, defined in dispatch_<level>.cpp
+void FillDispatchTableScalar(dispatchtable &table);
+void FillDispatchTableSSE4(dispatchtable &table);
+void FillDispatchTableAVX2(dispatchtable &table);
+void FillDispatchTableAVX512(dispatchtable &table);
+
+// NOTE: Highest level the CPU and OS support (cpuid/xgetbv), checked once
+simdlevel DetectSIMDLevel();
+
+// NOTE: Rebinds the table, e.g. to test a lower level. Levels above the
+//       detected one are clamped, returns the level in use. Not thread-safe,
+//       call it before any worker thread uses the kernels.
+simdlevel SetSIMDLevel(simdlevel level);
+
+// NOTE: The bound level, for telemetry
+simdlevel GetSIMDLevel();
+const char *SIMDLevelName(simdlevel level);
+
+const dispatchtable &GetDispatchTable();
+
+} // NOTE: Namespace
+
+#if !defined(AAMATH_DISPATCH_KERNELS)
+
+#include "aamath.h"
+
+namespace aam {
+namespace dispatch {
+
+// NOTE: Same signatures as the inline versions, through the bound table
+
+inline void TransformPoints(const mat4 &m, const vec3 *in, vec3 *out, u32 count)
+{
+    GetDispatchTable().transformPoints(&m, in, out, count);
+}
+
+inline void TransformDirections(const mat4 &m, const vec3 *in, vec3 *out, u32 count)
+{
+    GetDispatchTable().transformDirections(&m, in, out, count);
+}
+
+inline void TransformPointsProjective(const mat4 &m, const vec3 *in, vec3 *out, u32 count)
+{
+    GetDispatchTable().transformPointsProjective(&m, in, out, count);
+}
+
+inline void Transform(const mat4 &m, const vec4 *in, vec4 *out, u32 count)
+{
+    GetDispatchTable().transformVec4(&m, in, out, count);
+}
+
+inline void TransformPoints(const mat4x3 &m, const vec3 *in, vec3 *out, u32 count)
+{
+    GetDispatchTable().transformPointsAffine(&m, in, out, count);
+}
+
+inline void TransformDirections(const mat4x3 &m, const vec3 *in, vec3 *out, u32 count)
+{
+    GetDispatchTable().transformDirectionsAffine(&m, in, out, count);
+}
+
+inline void SlerpBatch(const quat *start, const quat *end, const r32 *t, quat *out, u32 count)
+{
+    GetDispatchTable().slerp(start, end, t, 1, out, count, false);
+}
+
+inline void SlerpBatch(const quat *start, const quat *end, r32 t, quat *out, u32 count)
+{
+    GetDispatchTable().slerp(start, end, &t, 0, out, count, false);
+}
+
+inline void NlerpBatch(const quat *start, const quat *end, const r32 *t, quat *out, u32 count,
+                       b32 approxNormalize = false)
+{
+    GetDispatchTable().nlerp(start, end, t, 1, out, count, approxNormalize);
+}
+
+inline void NlerpBatch(const quat *start, const quat *end, r32 t, quat *out, u32 count,
+                       b32 approxNormalize = false)
+{
+    GetDispatchTable().nlerp(start, end, &t, 0, out, count, approxNormalize);
+}
+
+inline void ApproxSlerpBatch(const quat *start, const quat *end, const r32 *t, quat *out, u32 count,
+                             b32 approxNormalize = false)
+{
+    GetDispatchTable().approxSlerp(start, end, t, 1, out, count, approxNormalize);
+}
+
+inline void ApproxSlerpBatch(const quat *start, const quat *end, r32 t, quat *out, u32 count,
+                             b32 approxNormalize = false)
+{
+    GetDispatchTable().approxSlerp(start, end, &t, 0, out, count, approxNormalize);
+}
+
+inline void Cull(const frustum &f, const aabb *boxes, u32 count, u32 *visible, u8 *planeCache = 0)
+{
+    GetDispatchTable().cullAABBs(&f, boxes, count, visible, planeCache);
+}
+
+inline void Cull(const frustum &f, const sphere *spheres, u32 count, u32 *visible, u8 *planeCache = 0)
+{
+    GetDispatchTable().cullSpheres(&f, spheres, count, visible, planeCache);
+}
+
+inline void SkinLinear(const mat4 *palette, const skinweights *weights,
+                       const vec3 *positions, const vec3 *normals,
+                       vec3 *outPositions, vec3 *outNormals, u32 count)
+{
+    GetDispatchTable().skinLinear(palette, weights, positions, normals, outPositions, outNormals, count);
+}
+
+inline void SkinDualQuat(const dualquat *palette, const skinweights *weights,
+                         const vec3 *positions, const vec3 *normals,
+                         vec3 *outPositions, vec3 *outNormals, u32 count)
+{
+    GetDispatchTable().skinDualQuat(palette, weights, positions, normals, outPositions, outNormals, count);
+}
+
+} // NOTE: Namespace dispatch
+} // NOTE: Namespace
+
+#endif
+
+#endif
@@ -0,0 +1,7 @@
+// NOTE: AVX2 kernels for the dispatch tables, built with -mavx2 -mfma
+
+#define AAMATH_SSE4
+#define AAMATH_AVX2
+
+#define AAMATH_DISPATCH_FILL FillDispatchTableAVX2
+#include "dispatchkernels.h"
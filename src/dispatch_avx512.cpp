@@ -0,0 +1,8 @@
+// NOTE: The AVX2 kernels again, built with the AVX-512 (F, VL, DQ, BW) flags so
+//       the compiler can use the wider registers and EVEX encodings
+
+#define AAMATH_SSE4
+#define AAMATH_AVX2
+
+#define AAMATH_DISPATCH_FILL FillDispatchTableAVX512
+#include "dispatchkernels.h"
@@ -0,0 +1,7 @@
+// NOTE: Scalar kernels for the dispatch tables, built without SIMD flags
+
+#undef AAMATH_SSE4
+#undef AAMATH_AVX2
+
+#define AAMATH_DISPATCH_FILL FillDispatchTableScalar
+#include "dispatchkernels.h"
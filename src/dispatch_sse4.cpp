@@ -0,0 +1,7 @@
+// NOTE: SSE4.1 kernels for the dispatch tables, built with -msse4.1
+
+#undef AAMATH_AVX2
+#define AAMATH_SSE4
+
+#define AAMATH_DISPATCH_FILL FillDispatchTableSSE4
+#include "dispatchkernels.h"
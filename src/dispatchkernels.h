@@ -0,0 +1,134 @@
+// NOTE: Body of the per-level dispatch translation units (dispatch_<level>.cpp),
+//       not a public header. The including file sets the AAMATH_SSE4/AAMATH_AVX2
+//       switches and AAMATH_DISPATCH_FILL (the name of its table fill function).
+//
+//       The library is included inside an anonymous namespace, so the inline
+//       functions compiled here with this level's flags get internal linkage
+//       and can never be merged by the linker with the copies from other
+//       translation units. The system headers go first, at global scope, so
+//       the library's own includes of them are no-ops.
+
+#if !defined(AAMATH_DISPATCH_FILL)
+#error "Define AAMATH_DISPATCH_FILL before including dispatchkernels.h"
+#endif
+
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdint.h>
+#if defined(AAMATH_SSE4)
+#include <immintrin.h>
+#include <smmintrin.h>
+#endif
+
+#define AAMATH_DISPATCH_KERNELS
+#include "dispatch.h"
+
+namespace {
+
+#include "aamath.h"
+
+using namespace aam;
+
+void DispatchTransformPoints(const void *m, const void *in, void *out, u32 count)
+{
+    TransformPoints(*(const mat4 *)m, (const vec3 *)in, (vec3 *)out, count);
+}
+
+void DispatchTransformDirections(const void *m, const void *in, void *out, u32 count)
+{
+    TransformDirections(*(const mat4 *)m, (const vec3 *)in, (vec3 *)out, count);
+}
+
+void DispatchTransformPointsProjective(const void *m, const void *in, void *out, u32 count)
+{
+    TransformPointsProjective(*(const mat4 *)m, (const vec3 *)in, (vec3 *)out, count);
+}
+
+void DispatchTransformVec4(const void *m, const void *in, void *out, u32 count)
+{
+    Transform(*(const mat4 *)m, (const vec4 *)in, (vec4 *)out, count);
+}
+
+void DispatchTransformPointsAffine(const void *m, const void *in, void *out, u32 count)
+{
+    TransformPoints(*(const mat4x3 *)m, (const vec3 *)in, (vec3 *)out, count);
+}
+
+void DispatchTransformDirectionsAffine(const void *m, const void *in, void *out, u32 count)
+{
+    TransformDirections(*(const mat4x3 *)m, (const vec3 *)in, (vec3 *)out, count);
+}
+
+void DispatchSlerp(const void *start, const void *end, const r32 *t, u32 tStride,
+                   void *out, u32 count, b32 approxNormalize)
+{
+    if(tStride)
+        SlerpBatch((const quat *)start, (const quat *)end, t, (quat *)out, count);
+    else
+        SlerpBatch((const quat *)start, (const quat *)end, *t, (quat *)out, count);
+}
+
+void DispatchNlerp(const void *start, const void *end, const r32 *t, u32 tStride,
+                   void *out, u32 count, b32 approxNormalize)
+{
+    if(tStride)
+        NlerpBatch((const quat *)start, (const quat *)end, t, (quat *)out, count, approxNormalize);
+    else
+        NlerpBatch((const quat *)start, (const quat *)end, *t, (quat *)out, count, approxNormalize);
+}
+
+void DispatchApproxSlerp(const void *start, const void *end, const r32 *t, u32 tStride,
+                         void *out, u32 count, b32 approxNormalize)
+{
+    if(tStride)
+        ApproxSlerpBatch((const quat *)start, (const quat *)end, t, (quat *)out, count, approxNormalize);
+    else
+        ApproxSlerpBatch((const quat *)start, (const quat *)end, *t, (quat *)out, count, approxNormalize);
+}
+
+void DispatchCullAABBs(const void *f, const void *volumes, u32 count, u32 *visible, u8 *planeCache)
+{
+    Cull(*(const frustum *)f, (const aabb *)volumes, count, visible, planeCache);
+}
+
+void DispatchCullSpheres(const void *f, const void *volumes, u32 count, u32 *visible, u8 *planeCache)
+{
+    Cull(*(const frustum *)f, (const sphere *)volumes, count, visible, planeCache);
+}
+
+void DispatchSkinLinear(const void *palette, const void *weights, const void *positions, const void *normals,
+                        void *outPositions, void *outNormals, u32 count)
+{
+    SkinLinear((const mat4 *)palette, (const skinweights *)weights, (const vec3 *)positions,
+               (const vec3 *)normals, (vec3 *)outPositions, (vec3 *)outNormals, count);
+}
+
+void DispatchSkinDualQuat(const void *palette, const void *weights, const void *positions, const void *normals,
+                          void *outPositions, void *outNormals, u32 count)
+{
+    SkinDualQuat((const dualquat *)palette, (const skinweights *)weights, (const vec3 *)positions,
+                 (const vec3 *)normals, (vec3 *)outPositions, (vec3 *)outNormals, count);
+}
+
+} // NOTE: Namespace
+
+void ::aam::AAMATH_DISPATCH_FILL(::aam::dispatchtable &table)
+{
+    table.transformPoints = DispatchTransformPoints;
+    table.transformDirections = DispatchTransformDirections;
+    table.transformPointsProjective = DispatchTransformPointsProjective;
+    table.transformVec4 = DispatchTransformVec4;
+    table.transformPointsAffine = DispatchTransformPointsAffine;
+    table.transformDirectionsAffine = DispatchTransformDirectionsAffine;
+
+    table.slerp = DispatchSlerp;
+    table.nlerp = DispatchNlerp;
+    table.approxSlerp = DispatchApproxSlerp;
+
+    table.cullAABBs = DispatchCullAABBs;
+    table.cullSpheres = DispatchCullSpheres;
+
+    table.skinLinear = DispatchSkinLinear;
+    table.skinDualQuat = DispatchSkinDualQuat;
+}
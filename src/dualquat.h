@@ -0,0 +1,259 @@
+#ifndef DUALQUAT_H
+#define DUALQUAT_H
+
+#include "aamath.h"
+#include "vec3.h"
+#include "quat.h"
+#include "mat4.h"
+#include "wide.h"
+
+namespace aam
+{
+
+// NOTE: Unit dual quaternions represent rigid transforms, real is the rotation
+//       and dual = 0.5 * t * real for the translation t (as a pure quaternion).
+//       Composition follows the quaternion product, a * b applies b first.
+
+typedef struct _dualquat
+{
+    quat real,
+         dual;
+} dualquat;
+
+typedef struct _dualquatx4
+{
+    quatx4 real,
+           dual;
+} dualquatx4;
+
+inline dualquat DualQuat(const quat &real, const quat &dual)
+{
+    dualquat result;
+
+    result.real = real;
+    result.dual = dual;
+
+    return result;
+}
+
+// NOTE: Rotate then translate, rotation must be unit length
+inline dualquat DualQuat(const quat &rotation, const vec3 &translation)
+{
+    dualquat result;
+
+    result.real = rotation;
+    result.dual = Quat(0.0f, translation) * rotation * 0.5f;
+
+    return result;
+}
+
+//
+// NOTE: Static constants
+//
+
+static const dualquat DUALQUAT_IDENTITY = {{1.0f, 0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 0.0f, 0.0f}};
+
+//
+// NOTE: Operators
+//
+
+inline dualquat operator+(const dualquat &a, const dualquat &b)
+{
+    return DualQuat(a.real + b.real, a.dual + b.dual);
+}
+
+inline dualquat operator-(const dualquat &a, const dualquat &b)
+{
+    return DualQuat(a.real - b.real, a.dual - b.dual);
+}
+
+inline dualquat operator-(const dualquat &dq)
+{
+    return DualQuat(-dq.real, -dq.dual);
+}
+
+inline dualquat operator*(const dualquat &dq, r32 s)
+{
+    return DualQuat(dq.real * s, dq.dual * s);
+}
+
+inline dualquat operator*(r32 s, const dualquat &dq)
+{
+    return dq * s;
+}
+
+// NOTE: (ar + e ad)(br + e bd) = ar br + e (ar bd + ad br)
+inline dualquat operator*(const dualquat &a, const dualquat &b)
+{
+    dualquat result;
+
+    result.real = a.real * b.real;
+    result.dual = a.real * b.dual + a.dual * b.real;
+
+    return result;
+}
+
+inline dualquat &operator*=(dualquat &a, const dualquat &b)
+{
+    a = a * b;
+
+    return a;
+}
+
+inline dualquat &operator+=(dualquat &a, const dualquat &b)
+{
+    a = a + b;
+
+    return a;
+}
+
+//
+// NOTE: Functions
+//
+
+// NOTE: Quaternion conjugate of both parts, the inverse of a unit dual quaternion
+inline dualquat Conjugate(const dualquat &dq)
+{
+    return DualQuat(Conjugate(dq.real), Conjugate(dq.dual));
+}
+
+inline dualquat Inverse(const dualquat &dq)
+{
+    dualquat result;
+
+    // NOTE: (r + e d)^-1 = r^-1 - e r^-1 d r^-1
+    result.real = Inverse(dq.real);
+    result.dual = -(result.real * dq.dual * result.real);
+
+    return result;
+}
+
+// NOTE: Scales to a unit real part and removes the component of dual along real,
+//       so the result is a proper rigid transform again (e.g. after blending)
+inline void Normalize(dualquat &dq)
+{
+    r32 norm = Norm(dq.real);
+
+    if(IsZero(norm))
+    {
+        dq = DUALQUAT_IDENTITY;
+    }
+    else
+    {
+        r32 recip = InvSqrt(norm);
+
+        dq.real *= recip;
+        dq.dual *= recip;
+        dq.dual -= dq.real * Dot(dq.real, dq.dual);
+    }
+}
+
+inline dualquat Normalized(const dualquat &dq)
+{
+    dualquat result = dq;
+
+    Normalize(result);
+
+    return result;
+}
+
+inline quat GetRotation(const dualquat &dq)
+{
+    return dq.real;
+}
+
+// NOTE: t = 2 * dual * conjugate(real)
+inline vec3 GetTranslation(const dualquat &dq)
+{
+    const quat &r = dq.real,
+               &d = dq.dual;
+
+    return 2.0f * (r.w * d.xyz - d.w * r.xyz - Cross(d.xyz, r.xyz));
+}
+
+// NOTE: Unit dual quaternion
+inline vec3 TransformPoint(const dualquat &dq, const vec3 &p)
+{
+    return Rotate(dq.real, p) + GetTranslation(dq);
+}
+
+inline vec3 TransformDirection(const dualquat &dq, const vec3 &d)
+{
+    return Rotate(dq.real, d);
+}
+
+inline mat4 ToMat4(const dualquat &dq)
+{
+    mat4 result = Mat4Rotation(dq.real);
+
+    result.t.xyz = GetTranslation(dq);
+
+    return result;
+}
+
+// NOTE: Rigid transform (rotation and translation only) back to a dual quaternion
+inline dualquat DualQuat(const mat4 &m)
+{
+    return DualQuat(GetQuaternion(m), m.t.xyz);
+}
+
+// NOTE: Dual quaternion linear blend, b flipped to a's hemisphere, not normalised
+inline dualquat Lerp(const dualquat &a, r32 t, const dualquat &b)
+{
+    r32 sign = (Dot(a.real, b.real) < 0.0f) ? -1.0f : 1.0f;
+
+    return (1.0f - t) * a + (t * sign) * b;
+}
+
+//
+// NOTE: dualquatx4
+//
+
+inline dualquatx4 DualQuatx4(const quatx4 &real, const quatx4 &dual)
+{
+    dualquatx4 result;
+
+    result.real = real;
+    result.dual = dual;
+
+    return result;
+}
+
+// NOTE: Same as Normalize(dualquat) per lane, zero lanes become identity
+inline void Normalize(dualquatx4 &dq)
+{
+    r32x4 norm = Norm(dq.real);
+    r32x4 valid = norm > R32x4(EPSILON);
+    r32x4 recip = InvSqrt(Select(valid, norm, R32x4(1.0f)));
+
+    dq.real = dq.real * recip;
+    dq.dual = dq.dual * recip;
+    dq.dual = dq.dual - dq.real * Dot(dq.real, dq.dual);
+
+    dq.real = Select(valid, dq.real, Quatx4(QUAT_IDENTITY));
+    dq.dual = Select(valid, dq.dual, Quatx4(QUAT_ZERO));
+}
+
+inline vec3x4 GetTranslation(const dualquatx4 &dq)
+{
+    const quatx4 &r = dq.real,
+                 &d = dq.dual;
+    vec3x4 rv = Vec3x4(r.x, r.y, r.z),
+           dv = Vec3x4(d.x, d.y, d.z);
+
+    return 2.0f * (r.w * dv - d.w * rv - Cross(dv, rv));
+}
+
+inline vec3x4 TransformPoint(const dualquatx4 &dq, const vec3x4 &p)
+{
+    return Rotate(dq.real, p) + GetTranslation(dq);
+}
+
+inline vec3x4 TransformDirection(const dualquatx4 &dq, const vec3x4 &d)
+{
+    return Rotate(dq.real, d);
+}
+
+} // NOTE: Namespace
+
+#endif
@@ -0,0 +1,947 @@
+#ifndef GJK_H
+#define GJK_H
+
+#include "aamath.h"
+#include "vec3.h"
+#include "mat3.h"
+#include "mat4.h"
+#include "quat.h"
+#include "collision.h"
+
+namespace aam {
+
+// NOTE: Convex queries over support functions. GJK finds the distance and
+//       the closest points of two convex shapes from the point of their
+//       Minkowski difference A - B closest to the origin, EPA expands GJK's
+//       final simplex into a polytope to find the penetration depth when the
+//       shapes overlap. Any shape that can answer "furthest point along d"
+//       works, under any affine transform without projection.
+//
+//       Spheres and capsules run as their core point or segment plus a
+//       radius: GJK converges slowly on curved surfaces but exactly on the
+//       cores, and the radii come off the core distance afterwards. Only
+//       overlapping cores need EPA on the whole shapes.
+
+#ifndef GJK_MAX_ITERATIONS
+#define GJK_MAX_ITERATIONS  32
+#endif
+
+// NOTE: Stop when a support step closes less than this part of |v|^2
+#ifndef GJK_TOLERANCE
+#define GJK_TOLERANCE       1.0e-6f
+#endif
+
+// NOTE: Smooth shapes overlapping almost concentrically need the most, every
+//       face of the polytope is then about as close to the origin
+#ifndef EPA_MAX_ITERATIONS
+#define EPA_MAX_ITERATIONS  128
+#endif
+
+// NOTE: Stop when a support step deepens the closest face by less than this
+//       part of its distance
+#ifndef EPA_TOLERANCE
+#define EPA_TOLERANCE       1.0e-4f
+#endif
+
+#define EPA_MAX_VERTICES    (EPA_MAX_ITERATIONS + 4)
+#define EPA_MAX_FACES       (2 * EPA_MAX_VERTICES)
+
+typedef enum _convextype
+{
+    CONVEX_SPHERE,
+    CONVEX_AABB,
+    CONVEX_CAPSULE,
+    CONVEX_OBB,
+    CONVEX_HULL
+} convextype;
+
+// NOTE: A shape in its local space plus a local to world transform. Hull
+//       points are not copied and have to outlive the convex.
+typedef struct _convex
+{
+    convextype type;
+
+    union
+    {
+        sphere sphereShape;
+        aabb aabbShape;
+        capsule capsuleShape;
+        obb obbShape;
+        struct
+        {
+            const vec3 *points;
+            u32 count;
+        } hull;
+    };
+
+    mat3 basis;         // NOTE: Rows are the local axes in world space
+    vec3 translation;
+} convex;
+
+inline convex Convex(convextype type)
+{
+    convex result;
+
+    result.type = type;
+    result.basis = MAT3_IDENTITY;
+    result.translation = VEC3_ZERO;
+
+    return result;
+}
+
+inline convex Convex(const sphere &s)
+{
+    convex result = Convex(CONVEX_SPHERE);
+    result.sphereShape = s;
+
+    return result;
+}
+
+inline convex Convex(const aabb &bb)
+{
+    convex result = Convex(CONVEX_AABB);
+    result.aabbShape = bb;
+
+    return result;
+}
+
+inline convex Convex(const capsule &c)
+{
+    convex result = Convex(CONVEX_CAPSULE);
+    result.capsuleShape = c;
+
+    return result;
+}
+
+inline convex Convex(const obb &box)
+{
+    convex result = Convex(CONVEX_OBB);
+    result.obbShape = box;
+
+    return result;
+}
+
+// NOTE: The convex hull of the points
+inline convex Convex(const vec3 *points, u32 count)
+{
+    AAM_Assert(points && count > 0);
+
+    convex result = Convex(CONVEX_HULL);
+    result.hull.points = points;
+    result.hull.count = count;
+
+    return result;
+}
+
+// NOTE: The affine part of m, scale and shear included
+inline void SetTransform(convex &shape, const mat4 &m)
+{
+    shape.basis.x = Vec3(m.xx, m.xy, m.xz);
+    shape.basis.y = Vec3(m.yx, m.yy, m.yz);
+    shape.basis.z = Vec3(m.zx, m.zy, m.zz);
+    shape.translation = Vec3(m.tx, m.ty, m.tz);
+}
+
+inline void SetTransform(convex &shape, const quat &rotation, const vec3 &translation)
+{
+    shape.basis = Mat3Rotation(rotation);
+    shape.translation = translation;
+}
+
+// NOTE: Furthest local point of the core along a local direction
+inline vec3 LocalSupport(const convex &shape, const vec3 &d)
+{
+    vec3 result;
+
+    switch(shape.type)
+    {
+        case CONVEX_SPHERE:
+        {
+            result = shape.sphereShape.origin;
+        } break;
+
+        case CONVEX_AABB:
+        {
+            const aabb &bb = shape.aabbShape;
+
+            result = Vec3((d.x >= 0.0f) ? bb.max.x : bb.min.x,
+                          (d.y >= 0.0f) ? bb.max.y : bb.min.y,
+                          (d.z >= 0.0f) ? bb.max.z : bb.min.z);
+        } break;
+
+        case CONVEX_CAPSULE:
+        {
+            const capsule &c = shape.capsuleShape;
+
+            result = c.segment.origin;
+
+            if(Dot(c.segment.direction, d) > 0.0f)
+                result += c.segment.direction;
+        } break;
+
+        case CONVEX_OBB:
+        {
+            const obb &box = shape.obbShape;
+
+            result = box.centre;
+
+            for(u32 i = 0; i < 3; ++i)
+            {
+                r32 e = box.extents.E[i];
+                result += (Dot(box.axes.v[i], d) >= 0.0f) ? e * box.axes.v[i] : -e * box.axes.v[i];
+            }
+        } break;
+
+        case CONVEX_HULL:
+        {
+            const vec3 *points = shape.hull.points;
+            u32 best = 0;
+            r32 bestDot = Dot(points[0], d);
+
+            for(u32 i = 1; i < shape.hull.count; ++i)
+            {
+                r32 dot = Dot(points[i], d);
+
+                if(dot > bestDot)
+                {
+                    bestDot = dot;
+                    best = i;
+                }
+            }
+
+            result = points[best];
+        } break;
+
+        default:
+        {
+            AAM_Assert(!"Unknown convex type");
+            result = VEC3_ZERO;
+        } break;
+    }
+
+    return result;
+}
+
+// NOTE: World radius around the core, rounded shapes assume no scale or a
+//       uniform one
+inline r32 ConvexRadius(const convex &shape)
+{
+    r32 result = 0.0f;
+
+    if(shape.type == CONVEX_SPHERE)
+        result = shape.sphereShape.radius * Length(shape.basis.x);
+    else if(shape.type == CONVEX_CAPSULE)
+        result = shape.capsuleShape.radius * Length(shape.basis.x);
+
+    return result;
+}
+
+// NOTE: Furthest world point of the core along a world direction. The support
+//       of M s is M support(M^T d), which holds for any linear M.
+inline vec3 CoreSupport(const convex &shape, const vec3 &d)
+{
+    vec3 local = Vec3(Dot(shape.basis.x, d), Dot(shape.basis.y, d), Dot(shape.basis.z, d));
+
+    return shape.basis * LocalSupport(shape, local) + shape.translation;
+}
+
+// NOTE: Furthest world point along a world direction
+inline vec3 Support(const convex &shape, const vec3 &d)
+{
+    vec3 result = CoreSupport(shape, d);
+    r32 radius = ConvexRadius(shape),
+        lengthSq = LengthSq(d);
+
+    if(radius > 0.0f && lengthSq > 0.0f)
+        result += d * (radius / AASqrt(lengthSq));
+
+    return result;
+}
+
+//
+// NOTE: GJK
+//
+
+// NOTE: A point of A - B with the points of A and B it came from and the
+//       search direction that found it
+typedef struct _gjkvertex
+{
+    vec3 w,
+         a,
+         b,
+         direction;
+} gjkvertex;
+
+typedef struct _gjksimplex
+{
+    gjkvertex v[4];
+    r32 weights[4];     // NOTE: Barycentric weights of the closest point
+    vec3 closest;       // NOTE: Point of the simplex closest to the origin
+    u32 count;
+} gjksimplex;
+
+// NOTE: Search directions of the last simplex, kept between frames. A query
+//       starts from the supports along them, which for shapes that moved a
+//       little is already close to the answer. Zero initialise for a cold
+//       start.
+typedef struct _gjkcache
+{
+    vec3 directions[4];
+    u32 count;
+} gjkcache;
+
+inline gjkvertex GJKSupport(const convex &a, const convex &b, const vec3 &d, b32 cores)
+{
+    gjkvertex result;
+
+    result.direction = d;
+    result.a = cores ? CoreSupport(a, d) : Support(a, d);
+    result.b = cores ? CoreSupport(b, -d) : Support(b, -d);
+    result.w = result.a - result.b;
+
+    return result;
+}
+
+inline void GJKKeep(gjksimplex &s, u32 i0, r32 w0)
+{
+    s.v[0] = s.v[i0];
+    s.weights[0] = w0;
+    s.closest = s.v[0].w;
+    s.count = 1;
+}
+
+inline void GJKKeep(gjksimplex &s, u32 i0, u32 i1, r32 w0, r32 w1)
+{
+    gjkvertex v0 = s.v[i0],
+              v1 = s.v[i1];
+
+    s.v[0] = v0;
+    s.v[1] = v1;
+    s.weights[0] = w0;
+    s.weights[1] = w1;
+    s.closest = w0 * v0.w + w1 * v1.w;
+    s.count = 2;
+}
+
+inline void GJKKeep(gjksimplex &s, u32 i0, u32 i1, u32 i2, r32 w0, r32 w1, r32 w2)
+{
+    gjkvertex v0 = s.v[i0],
+              v1 = s.v[i1],
+              v2 = s.v[i2];
+
+    s.v[0] = v0;
+    s.v[1] = v1;
+    s.v[2] = v2;
+    s.weights[0] = w0;
+    s.weights[1] = w1;
+    s.weights[2] = w2;
+    s.closest = w0 * v0.w + w1 * v1.w + w2 * v2.w;
+    s.count = 3;
+}
+
+inline void GJKClosestSegment(gjksimplex &s, u32 i0, u32 i1)
+{
+    vec3 a = s.v[i0].w,
+         ab = s.v[i1].w - a;
+    r32 lengthSq = LengthSq(ab),
+        t = (lengthSq > 0.0f) ? -Dot(a, ab) / lengthSq : 0.0f;
+
+    if(t <= 0.0f)
+        GJKKeep(s, i0, 1.0f);
+    else if(t >= 1.0f)
+        GJKKeep(s, i1, 1.0f);
+    else
+        GJKKeep(s, i0, i1, 1.0f - t, t);
+}
+
+// NOTE: Closest point to the origin by Voronoi regions (Ericson 5.1.5)
+inline void GJKClosestTriangle(gjksimplex &s, u32 i0, u32 i1, u32 i2)
+{
+    vec3 a = s.v[i0].w,
+         b = s.v[i1].w,
+         c = s.v[i2].w,
+         ab = b - a,
+         ac = c - a;
+
+    r32 d1 = -Dot(ab, a),
+        d2 = -Dot(ac, a);
+    if(d1 <= 0.0f && d2 <= 0.0f)
+    {
+        GJKKeep(s, i0, 1.0f);
+        return;
+    }
+
+    r32 d3 = -Dot(ab, b),
+        d4 = -Dot(ac, b);
+    if(d3 >= 0.0f && d4 <= d3)
+    {
+        GJKKeep(s, i1, 1.0f);
+        return;
+    }
+
+    r32 vc = d1 * d4 - d3 * d2;
+    if(vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+    {
+        r32 t = d1 / (d1 - d3);
+        GJKKeep(s, i0, i1, 1.0f - t, t);
+        return;
+    }
+
+    r32 d5 = -Dot(ab, c),
+        d6 = -Dot(ac, c);
+    if(d6 >= 0.0f && d5 <= d6)
+    {
+        GJKKeep(s, i2, 1.0f);
+        return;
+    }
+
+    r32 vb = d5 * d2 - d1 * d6;
+    if(vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+    {
+        r32 t = d2 / (d2 - d6);
+        GJKKeep(s, i0, i2, 1.0f - t, t);
+        return;
+    }
+
+    r32 va = d3 * d6 - d5 * d4;
+    if(va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+    {
+        r32 t = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        GJKKeep(s, i1, i2, 1.0f - t, t);
+        return;
+    }
+
+    va = Max(va, 0.0f);
+    vb = Max(vb, 0.0f);
+    vc = Max(vc, 0.0f);
+
+    vec3 n = Cross(ab, ac);
+    r32 sum = va + vb + vc,
+        nn = LengthSq(n);
+
+    // NOTE: (Nearly) collinear, the normal is noise and the regions above
+    //       can be wrong, the closest of the edges instead
+    if(!(sum > 0.0f && nn > 1.0e-10f * LengthSq(ab) * LengthSq(ac)))
+    {
+        static const u32 edges[3][2] = {{0, 1}, {0, 2}, {1, 2}};
+        u32 indices[3] = {i0, i1, i2};
+        gjksimplex best = s;
+        r32 bestDistSq = FLT_MAX;
+
+        for(u32 e = 0; e < 3; ++e)
+        {
+            gjksimplex edge = s;
+            GJKClosestSegment(edge, indices[edges[e][0]], indices[edges[e][1]]);
+
+            r32 distSq = LengthSq(edge.closest);
+            if(distSq < bestDistSq)
+            {
+                bestDistSq = distSq;
+                best = edge;
+            }
+        }
+
+        s = best;
+        return;
+    }
+
+    r32 inverse = 1.0f / sum;
+    GJKKeep(s, i0, i1, i2, va * inverse, vb * inverse, vc * inverse);
+
+    // NOTE: The products above cancel out on long thin triangles, enough for
+    //       the witness points but not for the search direction. Projecting
+    //       along the normal keeps more precision.
+    s.closest = n * (Dot(n, a) / nn);
+}
+
+// NOTE: The origin is inside when the volumes with each vertex swapped for the
+//       origin all share the sign of the whole and add up to it. On slivers
+//       those volumes cancel out instead, so anything else checks all faces.
+inline void GJKClosestTetrahedron(gjksimplex &s)
+{
+    vec3 a = s.v[0].w,
+         ab = s.v[1].w - a,
+         ac = s.v[2].w - a,
+         ad = s.v[3].w - a;
+    r32 volume = Dot(ab, Cross(ac, ad)),
+        v1 = -Dot(a, Cross(ac, ad)),
+        v2 = -Dot(ab, Cross(a, ad)),
+        v3 = -Dot(ab, Cross(ac, a)),
+        v0 = volume - v1 - v2 - v3;
+
+    if(volume != 0.0f && v0 * volume >= 0.0f && v1 * volume >= 0.0f && v2 * volume >= 0.0f && v3 * volume >= 0.0f
+       && fabsf(v0) + fabsf(v1) + fabsf(v2) + fabsf(v3) <= 1.0001f * fabsf(volume))
+    {
+        r32 inverse = 1.0f / volume;
+
+        s.weights[0] = v0 * inverse;
+        s.weights[1] = v1 * inverse;
+        s.weights[2] = v2 * inverse;
+        s.weights[3] = v3 * inverse;
+        s.closest = VEC3_ZERO;
+
+        return;
+    }
+
+    static const u32 faces[4][3] = {{0, 1, 2}, {0, 1, 3}, {0, 2, 3}, {1, 2, 3}};
+
+    gjksimplex best = s;
+    r32 bestDistSq = FLT_MAX;
+
+    for(u32 f = 0; f < 4; ++f)
+    {
+        gjksimplex face = s;
+        GJKClosestTriangle(face, faces[f][0], faces[f][1], faces[f][2]);
+
+        r32 distSq = LengthSq(face.closest);
+        if(distSq < bestDistSq)
+        {
+            bestDistSq = distSq;
+            best = face;
+        }
+    }
+
+    s = best;
+}
+
+// NOTE: Reduces the simplex to the vertices supporting its point closest to
+//       the origin and returns that point
+inline vec3 GJKClosest(gjksimplex &s)
+{
+    switch(s.count)
+    {
+        case 1: GJKKeep(s, 0, 1.0f); break;
+        case 2: GJKClosestSegment(s, 0, 1); break;
+        case 3: GJKClosestTriangle(s, 0, 1, 2); break;
+        case 4: GJKClosestTetrahedron(s); break;
+        default: AAM_Assert(!"Bad simplex"); break;
+    }
+
+    return s.closest;
+}
+
+inline b32 GJKContains(const gjksimplex &s, const vec3 &w)
+{
+    for(u32 i = 0; i < s.count; ++i)
+    {
+        if(s.v[i].w.x == w.x && s.v[i].w.y == w.y && s.v[i].w.z == w.z)
+            return true;
+    }
+
+    return false;
+}
+
+// NOTE: Runs GJK on a - b, of the cores or of the whole shapes, and returns
+//       true when they overlap. With a stopDistance of 0 or more it returns
+//       as soon as the distance is known to be within it (true) or past it,
+//       without converging.
+inline b32 GJKSolve(const convex &a, const convex &b, b32 cores, gjksimplex &simplex,
+                    gjkcache *cache, r32 stopDistance = -1.0f)
+{
+    simplex.count = 0;
+
+    if(cache)
+    {
+        for(u32 i = 0; i < cache->count; ++i)
+        {
+            gjkvertex vertex = GJKSupport(a, b, cache->directions[i], cores);
+
+            if(!GJKContains(simplex, vertex.w))
+                simplex.v[simplex.count++] = vertex;
+        }
+    }
+
+    // NOTE: Cold start along the line between two points of the shapes
+    if(simplex.count == 0)
+    {
+        vec3 d = CoreSupport(b, VEC3_ZERO) - CoreSupport(a, VEC3_ZERO);
+        simplex.v[simplex.count++] = GJKSupport(a, b, IsZero(d) ? Vec3(1.0f, 0.0f, 0.0f) : d, cores);
+    }
+
+    vec3 v = GJKClosest(simplex);
+    r32 stopSq = stopDistance * stopDistance;
+    b32 result = false;
+
+    for(u32 iteration = 0; iteration < GJK_MAX_ITERATIONS; ++iteration)
+    {
+        r32 vv = LengthSq(v),
+            scale = 0.0f;
+
+        for(u32 i = 0; i < simplex.count; ++i)
+            scale = Max(scale, LengthSq(simplex.v[i].w));
+
+        if(simplex.count == 4 || vv <= 1.0e-10f * scale)
+        {
+            result = true;
+            break;
+        }
+
+        if(stopDistance >= 0.0f && vv <= stopSq)
+            break;
+
+        gjkvertex vertex = GJKSupport(a, b, -v, cores);
+        r32 vw = Dot(v, vertex.w);
+
+        // NOTE: All of a - b is past the plane through w, at least vw / |v|
+        //       from the origin
+        if(stopDistance >= 0.0f && vw > 0.0f && vw * vw > stopSq * vv)
+            break;
+
+        if(vv - vw <= GJK_TOLERANCE * vv || GJKContains(simplex, vertex.w))
+            break;
+
+        gjksimplex previous = simplex;
+        simplex.v[simplex.count++] = vertex;
+
+        vec3 next = GJKClosest(simplex);
+
+        // NOTE: No progress, rounding has taken over
+        if(LengthSq(next) >= vv)
+        {
+            simplex = previous;
+            break;
+        }
+
+        v = next;
+    }
+
+    if(cache)
+    {
+        cache->count = simplex.count;
+
+        for(u32 i = 0; i < simplex.count; ++i)
+            cache->directions[i] = simplex.v[i].direction;
+    }
+
+    return result;
+}
+
+inline void GJKWitnessPoints(const gjksimplex &simplex, vec3 &pointA, vec3 &pointB)
+{
+    pointA = pointB = VEC3_ZERO;
+
+    for(u32 i = 0; i < simplex.count; ++i)
+    {
+        pointA += simplex.weights[i] * simplex.v[i].a;
+        pointB += simplex.weights[i] * simplex.v[i].b;
+    }
+}
+
+// NOTE: Distance between the shapes and their closest points, 0 when they
+//       overlap (see Penetration). The cache may be 0.
+inline r32 Distance(const convex &a, const convex &b, vec3 &pointA, vec3 &pointB, gjkcache *cache = 0)
+{
+    gjksimplex simplex;
+    b32 overlap = GJKSolve(a, b, true, simplex, cache);
+
+    GJKWitnessPoints(simplex, pointA, pointB);
+
+    if(overlap)
+        return 0.0f;
+
+    r32 radiusA = ConvexRadius(a),
+        radiusB = ConvexRadius(b),
+        distance = Length(simplex.closest);
+
+    if(distance <= radiusA + radiusB)
+        return 0.0f;
+
+    // NOTE: closest is pointA - pointB
+    vec3 normal = simplex.closest * (1.0f / distance);
+
+    pointA -= radiusA * normal;
+    pointB += radiusB * normal;
+
+    return distance - radiusA - radiusB;
+}
+
+inline r32 Distance(const convex &a, const convex &b, gjkcache *cache = 0)
+{
+    vec3 pointA, pointB;
+
+    return Distance(a, b, pointA, pointB, cache);
+}
+
+inline b32 Intersects(const convex &a, const convex &b, gjkcache *cache = 0)
+{
+    gjksimplex simplex;
+    r32 radius = ConvexRadius(a) + ConvexRadius(b);
+
+    return GJKSolve(a, b, true, simplex, cache, radius)
+           || LengthSq(simplex.closest) <= radius * radius;
+}
+
+//
+// NOTE: EPA
+//
+
+typedef struct _epaface
+{
+    u32 i[3];           // NOTE: Counter-clockwise seen from outside
+    vec3 normal;        // NOTE: Unit, outwards
+    r32 distance;       // NOTE: Of the plane from the origin
+} epaface;
+
+inline b32 EPAFace(const gjkvertex *vertices, u32 i0, u32 i1, u32 i2, epaface &face)
+{
+    vec3 n = Cross(vertices[i1].w - vertices[i0].w, vertices[i2].w - vertices[i0].w);
+    r32 lengthSq = LengthSq(n);
+
+    if(!(lengthSq > 0.0f))
+        return false;
+
+    face.i[0] = i0;
+    face.i[1] = i1;
+    face.i[2] = i2;
+    face.normal = n * (1.0f / AASqrt(lengthSq));
+    face.distance = Dot(face.normal, vertices[i0].w);
+
+    return true;
+}
+
+// NOTE: Adds support points until the simplex is a tetrahedron with volume,
+//       false when the shapes only touch (a - b is flat around the origin)
+inline b32 EPAInflate(const convex &a, const convex &b, gjksimplex &s)
+{
+    static const vec3 axes[3] = {{1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}};
+
+    if(s.count == 1)
+    {
+        for(u32 i = 0; i < 6 && s.count == 1; ++i)
+        {
+            gjkvertex vertex = GJKSupport(a, b, (i & 1) ? -axes[i / 2] : axes[i / 2], false);
+
+            if(LengthSq(vertex.w - s.v[0].w) > 0.0f)
+                s.v[s.count++] = vertex;
+        }
+    }
+
+    if(s.count == 2)
+    {
+        vec3 edge = s.v[1].w - s.v[0].w;
+
+        for(u32 i = 0; i < 6 && s.count == 2; ++i)
+        {
+            vec3 d = Cross(edge, axes[i / 2]);
+
+            if(!(LengthSq(d) > 0.0f))
+                continue;
+
+            gjkvertex vertex = GJKSupport(a, b, (i & 1) ? -d : d, false);
+
+            if(LengthSq(Cross(vertex.w - s.v[0].w, edge)) > 1.0e-12f * LengthSq(edge) * LengthSq(vertex.w - s.v[0].w))
+                s.v[s.count++] = vertex;
+        }
+    }
+
+    if(s.count == 3)
+    {
+        vec3 n = Cross(s.v[1].w - s.v[0].w, s.v[2].w - s.v[0].w);
+
+        for(u32 i = 0; i < 2 && s.count == 3; ++i)
+        {
+            gjkvertex vertex = GJKSupport(a, b, i ? -n : n, false);
+            r32 height = Dot(vertex.w - s.v[0].w, n);
+
+            if(height * height > 1.0e-12f * LengthSq(n) * LengthSq(vertex.w - s.v[0].w))
+                s.v[s.count++] = vertex;
+        }
+    }
+
+    return s.count == 4;
+}
+
+// NOTE: Penetration of overlapping shapes: moving a by -depth * normal (or b
+//       by depth * normal) separates them. normal points from a towards b,
+//       pointA and pointB are the deepest points of each inside the other.
+//       Returns false when the shapes do not overlap. The cache may be 0.
+inline b32 Penetration(const convex &a, const convex &b, vec3 &normal, r32 &depth,
+                       vec3 &pointA, vec3 &pointB, gjkcache *cache = 0)
+{
+    gjksimplex simplex;
+
+    if(!GJKSolve(a, b, true, simplex, cache))
+    {
+        // NOTE: Separate cores, only the radii overlap (if anything)
+        r32 radiusA = ConvexRadius(a),
+            radiusB = ConvexRadius(b),
+            distance = Length(simplex.closest);
+
+        if(distance > radiusA + radiusB || !(distance > 0.0f))
+            return false;
+
+        GJKWitnessPoints(simplex, pointA, pointB);
+
+        normal = simplex.closest * (-1.0f / distance);
+        depth = radiusA + radiusB - distance;
+        pointA += radiusA * normal;
+        pointB -= radiusB * normal;
+
+        return true;
+    }
+
+    if(ConvexRadius(a) > 0.0f || ConvexRadius(b) > 0.0f)
+        GJKSolve(a, b, false, simplex, 0);
+
+    if(!EPAInflate(a, b, simplex))
+    {
+        // NOTE: Touching, no depth to resolve
+        vec3 d = Support(b, VEC3_ZERO) - Support(a, VEC3_ZERO);
+
+        normal = IsZero(d) ? Vec3(1.0f, 0.0f, 0.0f) : Normalized(d);
+        depth = 0.0f;
+        pointA = pointB = simplex.v[0].a;
+
+        return true;
+    }
+
+    gjkvertex vertices[EPA_MAX_VERTICES];
+    epaface faces[EPA_MAX_FACES];
+    u32 vertexCount = 4,
+        faceCount = 0;
+
+    for(u32 i = 0; i < 4; ++i)
+        vertices[i] = simplex.v[i];
+
+    // NOTE: Wind (0, 1, 2) away from vertex 3
+    if(Dot(Cross(vertices[1].w - vertices[0].w, vertices[2].w - vertices[0].w), vertices[3].w - vertices[0].w) > 0.0f)
+    {
+        gjkvertex tmp = vertices[1];
+        vertices[1] = vertices[2];
+        vertices[2] = tmp;
+    }
+
+    static const u32 tetrahedron[4][3] = {{0, 1, 2}, {0, 3, 1}, {0, 2, 3}, {1, 3, 2}};
+
+    for(u32 f = 0; f < 4; ++f)
+    {
+        if(EPAFace(vertices, tetrahedron[f][0], tetrahedron[f][1], tetrahedron[f][2], faces[faceCount]))
+            ++faceCount;
+    }
+
+    u32 closest;
+
+    // NOTE: Bounded by EPA_MAX_VERTICES
+    for(;;)
+    {
+        closest = 0;
+
+        for(u32 f = 1; f < faceCount; ++f)
+        {
+            if(faces[f].distance < faces[closest].distance)
+                closest = f;
+        }
+
+        gjkvertex vertex = GJKSupport(a, b, faces[closest].normal, false);
+        r32 supportDistance = Dot(vertex.w, faces[closest].normal);
+
+        if(supportDistance - faces[closest].distance <= EPA_TOLERANCE * Max(supportDistance, FLT_MIN)
+           || vertexCount == EPA_MAX_VERTICES)
+            break;
+
+        // NOTE: The boundary of the faces the new vertex sees, an edge seen
+        //       from both sides cancels out. The closest face counts as seen
+        //       even when rounding says otherwise.
+        b32 visible[EPA_MAX_FACES];
+        u32 edges[EPA_MAX_FACES * 3][2];
+        u32 edgeCount = 0,
+            visibleCount = 0;
+
+        for(u32 f = 0; f < faceCount; ++f)
+        {
+            visible[f] = (f == closest) || Dot(faces[f].normal, vertex.w - vertices[faces[f].i[0]].w) > 0.0f;
+
+            if(!visible[f])
+                continue;
+
+            ++visibleCount;
+
+            for(u32 e = 0; e < 3; ++e)
+            {
+                u32 from = faces[f].i[e],
+                    to = faces[f].i[(e + 1) % 3],
+                    k = 0;
+
+                while(k < edgeCount && !(edges[k][0] == to && edges[k][1] == from))
+                    ++k;
+
+                if(k < edgeCount)
+                {
+                    edges[k][0] = edges[edgeCount - 1][0];
+                    edges[k][1] = edges[edgeCount - 1][1];
+                    --edgeCount;
+                }
+                else
+                {
+                    edges[edgeCount][0] = from;
+                    edges[edgeCount][1] = to;
+                    ++edgeCount;
+                }
+            }
+        }
+
+        // NOTE: Only a polytope broken by rounding grows faster than 2n - 4
+        if(faceCount - visibleCount + edgeCount > EPA_MAX_FACES)
+            break;
+
+        u32 kept = 0;
+
+        for(u32 f = 0; f < faceCount; ++f)
+        {
+            if(!visible[f])
+                faces[kept++] = faces[f];
+        }
+
+        faceCount = kept;
+
+        u32 index = vertexCount++;
+        vertices[index] = vertex;
+
+        for(u32 e = 0; e < edgeCount; ++e)
+        {
+            if(EPAFace(vertices, edges[e][0], edges[e][1], index, faces[faceCount]))
+                ++faceCount;
+        }
+
+        if(faceCount == 0)
+            return false;
+    }
+
+    const epaface &face = faces[closest];
+
+    normal = face.normal;
+    depth = face.distance;
+
+    // NOTE: Barycentrics of the origin's projection on the face
+    vec3 p = face.distance * face.normal,
+         v0 = vertices[face.i[1]].w - vertices[face.i[0]].w,
+         v1 = vertices[face.i[2]].w - vertices[face.i[0]].w,
+         v2 = p - vertices[face.i[0]].w;
+    r32 d00 = Dot(v0, v0),
+        d01 = Dot(v0, v1),
+        d11 = Dot(v1, v1),
+        d20 = Dot(v2, v0),
+        d21 = Dot(v2, v1),
+        denom = d00 * d11 - d01 * d01,
+        u = 1.0f / 3.0f,
+        v = 1.0f / 3.0f;
+
+    if(denom > 0.0f)
+    {
+        u = (d11 * d20 - d01 * d21) / denom;
+        v = (d00 * d21 - d01 * d20) / denom;
+    }
+
+    const gjkvertex &a0 = vertices[face.i[0]],
+                    &a1 = vertices[face.i[1]],
+                    &a2 = vertices[face.i[2]];
+
+    pointA = (1.0f - u - v) * a0.a + u * a1.a + v * a2.a;
+    pointB = (1.0f - u - v) * a0.b + u * a1.b + v * a2.b;
+
+    return true;
+}
+
+} // NOTE: Namespace
+
+#endif
@@ -0,0 +1,295 @@
+#ifndef HIERARCHY_H
+#define HIERARCHY_H
+
+#include "aamath.h"
+#include "mat4x3.h"
+#include "transform.h"
+
+namespace aam {
+
+// NOTE: Parent/child transform hierarchy. Nodes are stored breadth-first, so
+//       every depth level is a contiguous range, parents come before their
+//       children and the children of a node are contiguous in the next level.
+//       Locals are transforms, worlds are mat4x3 (ToMat4 for a full matrix).
+//       SetLocal/MarkDirty queue a node on its level, UpdateHierarchy then walks
+//       the levels top-down and recomputes only the queued nodes, queueing
+//       their children as it goes, so the cost follows the number of moved
+//       nodes and their descendants rather than the size of the hierarchy.
+//       The topology is fixed after BuildHierarchy, rebuild it when it changes.
+//       All memory is owned by the caller, see HierarchyMemorySize().
+
+#define HIERARCHY_ROOT          0xFFFFFFFF
+// NOTE: Deeper hierarchies fail to build, at most 256 (depth is a u8)
+#define HIERARCHY_MAX_DEPTH     64
+
+// NOTE: Levels with fewer dirty nodes than this are updated on the calling
+//       thread, the parallel-for overhead would dominate
+#ifndef HIERARCHY_PARALLEL_THRESHOLD
+#define HIERARCHY_PARALLEL_THRESHOLD 4096
+#endif
+
+typedef struct _hierarchy
+{
+    mat4x3 *world;
+    transform *local;
+    u32 *parents,
+        *firstChild,
+        *childCount,
+        *dirty;         // NOTE: Per-level queues, level l starts at levelStart[l]
+    u8 *depth,
+       *queued;
+    u32 count,
+        levelCount;
+    u32 levelStart[HIERARCHY_MAX_DEPTH + 1],
+        dirtyCount[HIERARCHY_MAX_DEPTH];
+} hierarchy;
+
+// NOTE: Runs task over [0, count) split into ranges and returns when all of
+//       them are done, e.g. on a job system. Ranges must not overlap.
+typedef void hierarchy_task(void *data, u32 first, u32 onePastLast);
+typedef void hierarchy_parallel_for(void *user, hierarchy_task *task, void *data, u32 count);
+
+// NOTE: Bytes of 16-byte aligned memory BuildHierarchy needs for count nodes
+inline u64 HierarchyMemorySize(u32 count)
+{
+    return (u64)count * (sizeof(mat4x3) + sizeof(transform) + 4 * sizeof(u32) + 2 * sizeof(u8));
+}
+
+// NOTE: Empty hierarchy, what a failed BuildHierarchy leaves
+inline void ClearHierarchy(hierarchy &h)
+{
+    h.count = 0;
+    h.levelCount = 0;
+    h.levelStart[0] = 0;
+}
+
+// NOTE: parents[i] is the parent of node i (HIERARCHY_ROOT for roots), in the
+//       caller's numbering and in any order. remap[i] receives the hierarchy
+//       index of the caller's node i, which every other function takes.
+//       All locals start as the identity and every node is dirty. Returns
+//       false, and leaves an empty hierarchy, for a parent out of range, a
+//       cycle or more than HIERARCHY_MAX_DEPTH levels.
+inline b32 BuildHierarchy(hierarchy &h, void *memory, const u32 *parents, u32 count, u32 *remap)
+{
+    AAM_Assert(memory && (parents || count == 0) && (remap || count == 0));
+    AAM_Assert(((u64)memory & 15) == 0);
+
+    u8 *at = (u8 *)memory;
+    h.world = (mat4x3 *)at;         at += count * sizeof(mat4x3);
+    h.local = (transform *)at;      at += count * sizeof(transform);
+    h.parents = (u32 *)at;          at += count * sizeof(u32);
+    h.firstChild = (u32 *)at;       at += count * sizeof(u32);
+    h.childCount = (u32 *)at;       at += count * sizeof(u32);
+    h.dirty = (u32 *)at;            at += count * sizeof(u32);
+    h.depth = at;                   at += count;
+    h.queued = at;
+    h.count = count;
+    h.levelCount = 0;
+    h.levelStart[0] = 0;
+
+    if(count == 0)
+        return true;
+
+    // NOTE: The worlds are computed by the first update, until then their
+    //       memory holds the child lists in the caller's numbering and the
+    //       breadth-first queue
+    u32 *childStart = (u32 *)h.world,
+        *children = childStart + count + 1,
+        *cursor = children + count,
+        *queue = cursor + count;
+
+    for(u32 i = 0; i <= count; ++i)
+    {
+        childStart[i] = 0;
+    }
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        if(parents[i] != HIERARCHY_ROOT)
+        {
+            if(parents[i] >= count || parents[i] == i)
+            {
+                ClearHierarchy(h);
+                return false;
+            }
+
+            ++childStart[parents[i] + 1];
+        }
+    }
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        childStart[i + 1] += childStart[i];
+        cursor[i] = childStart[i];
+    }
+
+    u32 tail = 0;
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        if(parents[i] == HIERARCHY_ROOT)
+        {
+            queue[tail++] = i;
+        }
+        else
+        {
+            children[cursor[parents[i]]++] = i;
+        }
+    }
+
+    // NOTE: Breadth-first, one level at a time
+    u32 head = 0;
+
+    while(head < tail)
+    {
+        if(h.levelCount == HIERARCHY_MAX_DEPTH)
+        {
+            ClearHierarchy(h);
+            return false;
+        }
+
+        u32 level = h.levelCount++,
+            levelEnd = tail;
+
+        h.levelStart[level] = head;
+        h.dirtyCount[level] = levelEnd - head;
+
+        for(; head < levelEnd; ++head)
+        {
+            u32 node = queue[head];
+
+            remap[node] = head;
+            h.firstChild[head] = tail;
+            h.childCount[head] = childStart[node + 1] - childStart[node];
+            h.depth[head] = (u8)level;
+
+            for(u32 c = childStart[node]; c < childStart[node + 1]; ++c)
+            {
+                queue[tail++] = children[c];
+            }
+        }
+    }
+
+    h.levelStart[h.levelCount] = head;
+
+    // NOTE: Fewer nodes reached than given means a cycle
+    if(head != count)
+    {
+        ClearHierarchy(h);
+        return false;
+    }
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        u32 parent = parents[queue[i]];
+
+        h.parents[i] = (parent == HIERARCHY_ROOT) ? HIERARCHY_ROOT : remap[parent];
+        h.local[i] = TRANSFORM_IDENTITY;
+        h.dirty[i] = i;
+        h.queued[i] = 1;
+    }
+
+    return true;
+}
+
+inline void MarkDirty(hierarchy &h, u32 node)
+{
+    AAM_Assert(node < h.count);
+
+    if(!h.queued[node])
+    {
+        u32 level = h.depth[node];
+
+        h.queued[node] = 1;
+        h.dirty[h.levelStart[level] + h.dirtyCount[level]++] = node;
+    }
+}
+
+inline void SetLocal(hierarchy &h, u32 node, const transform &local)
+{
+    AAM_Assert(node < h.count);
+
+    h.local[node] = local;
+    MarkDirty(h, node);
+}
+
+inline const transform &GetLocal(const hierarchy &h, u32 node)
+{
+    AAM_Assert(node < h.count);
+
+    return h.local[node];
+}
+
+// NOTE: Valid after UpdateHierarchy
+inline const mat4x3 &GetWorld(const hierarchy &h, u32 node)
+{
+    AAM_Assert(node < h.count);
+
+    return h.world[node];
+}
+
+typedef struct _hierarchylevel
+{
+    hierarchy *h;
+    const u32 *nodes;
+} hierarchylevel;
+
+// NOTE: hierarchy_task over one level's queue, the parents are up to date
+inline void HierarchyUpdateRange(void *data, u32 first, u32 onePastLast)
+{
+    hierarchylevel *level = (hierarchylevel *)data;
+    hierarchy &h = *level->h;
+
+    for(u32 i = first; i < onePastLast; ++i)
+    {
+        u32 node = level->nodes[i],
+            parent = h.parents[node];
+
+        if(parent == HIERARCHY_ROOT)
+            h.world[node] = ToMat4x3(h.local[node]);
+        else
+            h.world[node] = h.world[parent] * ToMat4x3(h.local[node]);
+    }
+}
+
+// NOTE: Recomputes the world of every queued node and its descendants.
+//       parallelFor may be 0 to update everything on the calling thread.
+inline void UpdateHierarchy(hierarchy &h, hierarchy_parallel_for *parallelFor = 0, void *user = 0)
+{
+    for(u32 level = 0; level < h.levelCount; ++level)
+    {
+        u32 dirtyCount = h.dirtyCount[level];
+
+        if(dirtyCount == 0)
+            continue;
+
+        hierarchylevel data = {&h, h.dirty + h.levelStart[level]};
+
+        if(parallelFor && dirtyCount >= HIERARCHY_PARALLEL_THRESHOLD)
+            parallelFor(user, HierarchyUpdateRange, &data, dirtyCount);
+        else
+            HierarchyUpdateRange(&data, 0, dirtyCount);
+
+        // NOTE: Queue the children on the next level, this pass only touches
+        //       the dirty nodes so it stays on the calling thread
+        for(u32 i = 0; i < dirtyCount; ++i)
+        {
+            u32 node = data.nodes[i],
+                first = h.firstChild[node],
+                onePastLast = first + h.childCount[node];
+
+            h.queued[node] = 0;
+
+            for(u32 child = first; child < onePastLast; ++child)
+            {
+                MarkDirty(h, child);
+            }
+        }
+
+        h.dirtyCount[level] = 0;
+    }
+}
+
+} // NOTE: Namespace
+
+#endif
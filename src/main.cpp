@@ -117,7 +117,7 @@
         point in triangle
         barycentric coords
         triangle-triangle intersection
-        triangle-ray intersection
+    x   triangle-ray intersection
 
     Planes:
     x   transform
@@ -127,6 +127,10 @@
      x   plane point
      x   plane sphere
      x   plane AABB
+    x   classification
+     x   points (batched)
+     x   spheres (batched)
+     x   plane sets (bitmasks)
 
     Common:
     x   constants (pi, tau/2pi, halfpi, epsilon etc) 
@@ -148,14 +152,26 @@
     x   AABB
      x   AABB AABB
      x   AABB ray
-        OBB
+    x   OBB
+     x   OBB OBB
+     x   OBB ray
+     x   OBB sphere
+     x   OBB plane
     x   Bounding spheres
      x   sphere sphere
      x   sphere ray
-        Capsules
-
-    SIMD optimisations?
-    Self-implemented standard library functions (cos, sin etc)?
+    x   Capsules
+     x   capsule capsule
+     x   capsule sphere
+     x   capsule AABB
+     x   capsule ray
+    x   GJK / EPA (convex support shapes)
+     x   distance, closest points
+     x   penetration depth
+     x   warm start
+
+\   SIMD optimisations
+\   Self-implemented standard library functions (cos, sin etc)?
 
 */
 
@@ -198,10 +214,10 @@ int main(int argv, char **argc)
 
     printf("cross: <%.3f, %.3f, %.3f>\n", cross.x, cross.y, cross.z);
 
-    mat4 t = Mat4Translation(5.0f, 5.0f, 5.0f);
-    mat4 r = Mat4RotationZ(PIOVERFOUR);
-    mat4 s = Mat4Scaling(1.0f, 3.0f, 2.0f);
-    mat4 wrld = t * r * s;
+    transform tf = Transform(Vec3(5.0f, 5.0f, 5.0f),
+                             QuatAxisAngle(VEC3_ZAXIS, PIOVERFOUR),
+                             Vec3(1.0f, 3.0f, 2.0f));
+    mat4 wrld = ToMat4(tf);
     mat4 view = LookAt(Vec4(0, 2.0f, 2.0f, 0), VEC4_ORIGIN, VEC4_YAXIS);
     mat4 pers = Perspective(45.0f, 4.0f / 3.0f, 0.1f, 100.0f);
     mat4 WVP = pers * view * wrld;
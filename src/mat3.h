@@ -333,6 +333,71 @@ inline mat3 Inverse(const mat3 &m)
     return result;
 }
 
+// NOTE: Eigen decomposition of a symmetric matrix by cyclic Jacobi rotations.
+//       vectors.v[i] is the unit eigenvector for values.E[i], the rows form a
+//       right-handed rotation. Only the upper triangle of m is read.
+inline void EigenSymmetric(const mat3 &m, vec3 &values, mat3 &vectors)
+{
+    r32 a[3][3];
+
+    for(u32 i = 0; i < 3; ++i)
+    {
+        for(u32 j = 0; j < 3; ++j)
+        {
+            a[i][j] = (i <= j) ? m.m[i][j] : m.m[j][i];
+        }
+    }
+
+    // NOTE: Accumulates the rotations, eigenvectors end up in the rows
+    mat3 v = MAT3_IDENTITY;
+
+    for(u32 sweep = 0; sweep < 16; ++sweep)
+    {
+        r32 off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2],
+            diag = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+
+        if(off <= 1.0e-12f * diag || off == 0.0f)
+            break;
+
+        for(u32 p = 0; p < 2; ++p)
+        {
+            for(u32 q = p + 1; q < 3; ++q)
+            {
+                if(a[p][q] == 0.0f)
+                    continue;
+
+                // NOTE: Rotation in the pq plane that zeroes a[p][q]
+                r32 theta = (a[q][q] - a[p][p]) / (2.0f * a[p][q]),
+                    t = ((theta >= 0.0f) ? 1.0f : -1.0f) / (fabsf(theta) + AASqrt(theta * theta + 1.0f)),
+                    c = 1.0f / AASqrt(t * t + 1.0f),
+                    s = t * c;
+
+                u32 k = 3 - p - q;
+                r32 akp = a[k][p],
+                    akq = a[k][q];
+
+                a[p][p] -= t * a[p][q];
+                a[q][q] += t * a[p][q];
+                a[p][q] = a[q][p] = 0.0f;
+                a[k][p] = a[p][k] = c * akp - s * akq;
+                a[k][q] = a[q][k] = s * akp + c * akq;
+
+                for(u32 i = 0; i < 3; ++i)
+                {
+                    r32 vp = v.m[p][i],
+                        vq = v.m[q][i];
+
+                    v.m[p][i] = c * vp - s * vq;
+                    v.m[q][i] = s * vp + c * vq;
+                }
+            }
+        }
+    }
+
+    values = Vec3(a[0][0], a[1][1], a[2][2]);
+    vectors = v;
+}
+
 inline mat3 Hadamard(const mat3 &a, const mat3 &b)
 {
     mat3 result;
@@ -640,12 +705,12 @@ inline vec3 GetEulerAngles(const mat3 &m)
 {
     vec3 result;
 
-    result.x = atan2f(m.yz, m.zz);
+    result.x = Atan2(m.yz, m.zz);
     r32 c2 = AASqrt((m.xx * m.xx) + (m.xy * m.xy));
-    result.y = atan2f(-m.xz, c2);
+    result.y = Atan2(-m.xz, c2);
     r32 s, c;
     SinCos(result.x, s, c);
-    result.z = atan2f((s * m.zx) - (c * m.yx), (c * m.yy) - (s * m.zy));
+    result.z = Atan2((s * m.zx) - (c * m.yx), (c * m.yy) - (s * m.zy));
 
     return result;
 }
@@ -653,7 +718,7 @@ inline vec3 GetEulerAngles(const mat3 &m)
 inline void GetAxisAngle(const mat3 &m, vec3 &axis, r32 &angle)
 {
     r32 trace = m.xx + m.yy + m.zz;
-    angle = acosf(0.5f * (trace - 1.0f));
+    angle = Acos(0.5f * (trace - 1.0f));
 
     if(IsZero(angle))
     {
@@ -701,20 +766,21 @@ inline quat GetQuaternion(const mat3 &m)
     quat result;
     r32 trace = 1.0f + m.xx + m.yy + m.zz;
 
-    if (trace > EPSILON)
+    // NOTE: Only when w is large (trace > 0), dividing by a small w loses precision
+    if (trace > 1.0f)
     {
         r32 s = AASqrt(trace) * 2.0f,
             oneOverS = 1.0f / s;
         result.w = s * 0.25f;
-        result.x = (m.zy - m.yz) * oneOverS;
-        result.y = (m.xz - m.zx) * oneOverS;
-        result.z = (m.yx - m.xy) * oneOverS;
+        result.x = (m.yz - m.zy) * oneOverS;
+        result.y = (m.zx - m.xz) * oneOverS;
+        result.z = (m.xy - m.yx) * oneOverS;
     }
     else if (m.xx > m.yy && m.xx > m.zz)
     {
         r32 s = AASqrt(1.0f + m.xx - m.yy - m.zz) * 2.0f,
             oneOverS = 1.0f / s;
-        result.w = (m.zy - m.yz) * oneOverS;
+        result.w = (m.yz - m.zy) * oneOverS;
         result.x = s * 0.25f;
         result.y = (m.xy + m.yx) * oneOverS;
         result.z = (m.xz + m.zx) * oneOverS;
@@ -723,7 +789,7 @@ inline quat GetQuaternion(const mat3 &m)
     {
         r32 s = AASqrt(1.0f + m.yy - m.xx - m.zz) * 2.0f,
             oneOverS = 1.0f / s;
-        result.w = (m.xz - m.zx) * oneOverS;
+        result.w = (m.zx - m.xz) * oneOverS;
         result.x = (m.xy + m.yx) * oneOverS;
         result.y = s * 0.25f;
         result.z = (m.yz + m.zy) * oneOverS;
@@ -732,7 +798,7 @@ inline quat GetQuaternion(const mat3 &m)
     {
         r32 s = AASqrt(1.0f + m.zz - m.xx - m.yy) * 2.0f,
             oneOverS = 1.0f / s;
-        result.w = (m.yx - m.xy) * oneOverS;
+        result.w = (m.xy - m.yx) * oneOverS;
         result.x = (m.xz + m.zx) * oneOverS;
         result.y = (m.yz + m.zy) * oneOverS;
         result.z = s * 0.25f;
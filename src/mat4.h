@@ -6,6 +6,7 @@
 #include "vec4.h"
 #include "mat3.h"
 #include "quat.h"
+#include "wide.h"
 
 namespace aam
 {
@@ -153,10 +154,20 @@ inline vec4 operator*(const mat4 &m, const vec4 &v)
 {
     vec4 result;
 
+#if defined(AAMATH_SSE4)
+    // NOTE: Broadcast each component and accumulate the basis rows,
+    //       same summation order as the scalar path
+    __m128 r = _mm_mul_ps(_mm_loadu_ps(m.v[0].E), _mm_set1_ps(v.x));
+    r = MulAdd(_mm_loadu_ps(m.v[1].E), _mm_set1_ps(v.y), r);
+    r = MulAdd(_mm_loadu_ps(m.v[2].E), _mm_set1_ps(v.z), r);
+    r = MulAdd(_mm_loadu_ps(m.v[3].E), _mm_set1_ps(v.w), r);
+    _mm_storeu_ps(result.E, r);
+#else
     result.x = m.xx * v.x + m.yx * v.y + m.zx * v.z + m.tx * v.w;
     result.y = m.xy * v.x + m.yy * v.y + m.zy * v.z + m.ty * v.w;
     result.z = m.xz * v.x + m.yz * v.y + m.zz * v.z + m.tz * v.w;
     result.w = m.xw * v.x + m.yw * v.y + m.zw * v.z + m.ww * v.w;
+#endif
 
     return result;
 }
@@ -186,6 +197,47 @@ inline mat4 operator*(const mat4 &a, const mat4 &b)
     }
 */
 
+#if defined(AAMATH_AVX2)
+    // NOTE: Two result rows per register, each row of B broadcast per component
+    //       within its 128-bit half
+    __m256 a0 = _mm256_broadcast_ps((const __m128 *)a.v[0].E),
+           a1 = _mm256_broadcast_ps((const __m128 *)a.v[1].E),
+           a2 = _mm256_broadcast_ps((const __m128 *)a.v[2].E),
+           a3 = _mm256_broadcast_ps((const __m128 *)a.v[3].E);
+
+    __m256 b01 = _mm256_loadu_ps(b.v[0].E),
+           b23 = _mm256_loadu_ps(b.v[2].E);
+
+    __m256 r01 = _mm256_mul_ps(a0, _mm256_shuffle_ps(b01, b01, 0x00));
+    r01 = MulAdd(a1, _mm256_shuffle_ps(b01, b01, 0x55), r01);
+    r01 = MulAdd(a2, _mm256_shuffle_ps(b01, b01, 0xAA), r01);
+    r01 = MulAdd(a3, _mm256_shuffle_ps(b01, b01, 0xFF), r01);
+
+    __m256 r23 = _mm256_mul_ps(a0, _mm256_shuffle_ps(b23, b23, 0x00));
+    r23 = MulAdd(a1, _mm256_shuffle_ps(b23, b23, 0x55), r23);
+    r23 = MulAdd(a2, _mm256_shuffle_ps(b23, b23, 0xAA), r23);
+    r23 = MulAdd(a3, _mm256_shuffle_ps(b23, b23, 0xFF), r23);
+
+    _mm256_storeu_ps(result.v[0].E, r01);
+    _mm256_storeu_ps(result.v[2].E, r23);
+#elif defined(AAMATH_SSE4)
+    __m128 a0 = _mm_loadu_ps(a.v[0].E),
+           a1 = _mm_loadu_ps(a.v[1].E),
+           a2 = _mm_loadu_ps(a.v[2].E),
+           a3 = _mm_loadu_ps(a.v[3].E);
+
+    for(u32 i = 0; i < 4; ++i)
+    {
+        __m128 bi = _mm_loadu_ps(b.v[i].E);
+
+        __m128 r = _mm_mul_ps(a0, _mm_shuffle_ps(bi, bi, 0x00));
+        r = MulAdd(a1, _mm_shuffle_ps(bi, bi, 0x55), r);
+        r = MulAdd(a2, _mm_shuffle_ps(bi, bi, 0xAA), r);
+        r = MulAdd(a3, _mm_shuffle_ps(bi, bi, 0xFF), r);
+
+        _mm_storeu_ps(result.v[i].E, r);
+    }
+#else
     result.xx = a.xx * b.xx + a.yx * b.xy + a.zx * b.xz + a.tx * b.xw;
     result.xy = a.xy * b.xx + a.yy * b.xy + a.zy * b.xz + a.ty * b.xw;
     result.xz = a.xz * b.xx + a.yz * b.xy + a.zz * b.xz + a.tz * b.xw;
@@ -205,6 +257,7 @@ inline mat4 operator*(const mat4 &a, const mat4 &b)
     result.ty = a.xy * b.tx + a.yy * b.ty + a.zy * b.tz + a.ty * b.ww;
     result.tz = a.xz * b.tx + a.yz * b.ty + a.zz * b.tz + a.tz * b.ww;
     result.ww = a.xw * b.tx + a.yw * b.ty + a.zw * b.tz + a.ww * b.ww;
+#endif
 
     return result;
 }
@@ -470,6 +523,290 @@ inline mat4 Inverse(const mat4 &m)
     return result;
 }
 
+#if defined(AAMATH_SSE4)
+// NOTE: SSE helpers for the inverse kernels below
+#define AAM_Swizzle(v, x, y, z, w) _mm_shuffle_ps((v), (v), _MM_SHUFFLE(w, z, y, x))
+
+// NOTE: 2x2 row-major matrices packed as (m00, m01, m10, m11)
+//       A * B
+inline __m128 Mat2Mul(__m128 a, __m128 b)
+{
+    return _mm_add_ps(_mm_mul_ps(a, AAM_Swizzle(b, 0, 3, 0, 3)),
+                      _mm_mul_ps(AAM_Swizzle(a, 1, 0, 3, 2), AAM_Swizzle(b, 2, 1, 2, 1)));
+}
+
+// NOTE: Adjugate(A) * B
+inline __m128 Mat2AdjMul(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(AAM_Swizzle(a, 3, 3, 0, 0), b),
+                      _mm_mul_ps(AAM_Swizzle(a, 1, 1, 2, 2), AAM_Swizzle(b, 2, 3, 0, 1)));
+}
+
+// NOTE: A * Adjugate(B)
+inline __m128 Mat2MulAdj(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(a, AAM_Swizzle(b, 3, 0, 3, 0)),
+                      _mm_mul_ps(AAM_Swizzle(a, 1, 0, 3, 2), AAM_Swizzle(b, 2, 1, 2, 1)));
+}
+
+// NOTE: Cross product of the xyz lanes, w lane is zero
+inline __m128 Cross3(__m128 a, __m128 b)
+{
+    __m128 result = _mm_sub_ps(_mm_mul_ps(AAM_Swizzle(a, 1, 2, 0, 3), AAM_Swizzle(b, 2, 0, 1, 3)),
+                               _mm_mul_ps(AAM_Swizzle(a, 2, 0, 1, 3), AAM_Swizzle(b, 1, 2, 0, 3)));
+
+    return _mm_blend_ps(result, _mm_setzero_ps(), 0x8);
+}
+
+// NOTE: Writes the inverted upper 3x3 rows (w = 0) and -(t * inverse) with w = 1
+inline void StoreAffineInverse(mat4 &result, __m128 r0, __m128 r1, __m128 r2, const mat4 &m)
+{
+    __m128 t = _mm_mul_ps(r0, _mm_set1_ps(m.tx));
+    t = MulAdd(r1, _mm_set1_ps(m.ty), t);
+    t = MulAdd(r2, _mm_set1_ps(m.tz), t);
+    t = _mm_blend_ps(_mm_sub_ps(_mm_setzero_ps(), t), _mm_set1_ps(1.0f), 0x8);
+
+    _mm_storeu_ps(result.v[0].E, r0);
+    _mm_storeu_ps(result.v[1].E, r1);
+    _mm_storeu_ps(result.v[2].E, r2);
+    _mm_storeu_ps(result.v[3].E, t);
+}
+#endif
+
+// NOTE: Full 4x4 inverse, handles projection matrices.
+//       Inverting the stored array inverts the matrix it represents
+//       (inverse of the transpose is the transpose of the inverse),
+//       so no re-ordering is needed for our basis-row layout.
+//
+//       Only an exactly zero determinant is treated as singular, since
+//       orthographic projections legitimately have tiny determinants.
+inline mat4 InverseGeneral(const mat4 &m)
+{
+    mat4 result;
+
+#if defined(AAMATH_SSE4)
+    // NOTE: Block-wise Cramer's rule on 2x2 sub-matrices,
+    //       see Eric Zhang, "Fast 4x4 Matrix Inverse with SSE SIMD, Explained"
+    __m128 r0 = _mm_loadu_ps(m.v[0].E),
+           r1 = _mm_loadu_ps(m.v[1].E),
+           r2 = _mm_loadu_ps(m.v[2].E),
+           r3 = _mm_loadu_ps(m.v[3].E);
+
+    // NOTE: M = | A B |
+    //           | C D |
+    __m128 A = _mm_movelh_ps(r0, r1),
+           B = _mm_movehl_ps(r1, r0),
+           C = _mm_movelh_ps(r2, r3),
+           D = _mm_movehl_ps(r3, r2);
+
+    // NOTE: (|A|, |B|, |C|, |D|)
+    __m128 detSub = _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(2, 0, 2, 0)),
+                                          _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(3, 1, 3, 1))),
+                               _mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(3, 1, 3, 1)),
+                                          _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(2, 0, 2, 0))));
+    __m128 detA = AAM_Swizzle(detSub, 0, 0, 0, 0),
+           detB = AAM_Swizzle(detSub, 1, 1, 1, 1),
+           detC = AAM_Swizzle(detSub, 2, 2, 2, 2),
+           detD = AAM_Swizzle(detSub, 3, 3, 3, 3);
+
+    __m128 DC = Mat2AdjMul(D, C),
+           AB = Mat2AdjMul(A, B);
+
+    // NOTE: Adjugates of the inverse's blocks
+    __m128 X = _mm_sub_ps(_mm_mul_ps(detD, A), Mat2Mul(B, DC)),
+           W = _mm_sub_ps(_mm_mul_ps(detA, D), Mat2Mul(C, AB)),
+           Y = _mm_sub_ps(_mm_mul_ps(detB, C), Mat2MulAdj(D, AB)),
+           Z = _mm_sub_ps(_mm_mul_ps(detC, B), Mat2MulAdj(A, DC));
+
+    // NOTE: |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+    __m128 tr = _mm_mul_ps(AB, AAM_Swizzle(DC, 0, 2, 1, 3));
+    tr = _mm_hadd_ps(tr, tr);
+    tr = _mm_hadd_ps(tr, tr);
+
+    __m128 detM = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), tr);
+
+    if(_mm_cvtss_f32(detM) != 0.0f)
+    {
+        __m128 invDet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+
+        X = _mm_mul_ps(X, invDet);
+        Y = _mm_mul_ps(Y, invDet);
+        Z = _mm_mul_ps(Z, invDet);
+        W = _mm_mul_ps(W, invDet);
+
+        // NOTE: Adjugate swizzle folded into the store shuffle
+        _mm_storeu_ps(result.v[0].E, _mm_shuffle_ps(X, Y, _MM_SHUFFLE(1, 3, 1, 3)));
+        _mm_storeu_ps(result.v[1].E, _mm_shuffle_ps(X, Y, _MM_SHUFFLE(0, 2, 0, 2)));
+        _mm_storeu_ps(result.v[2].E, _mm_shuffle_ps(Z, W, _MM_SHUFFLE(1, 3, 1, 3)));
+        _mm_storeu_ps(result.v[3].E, _mm_shuffle_ps(Z, W, _MM_SHUFFLE(0, 2, 0, 2)));
+    }
+#else
+    // NOTE: 2x2 sub-determinants of the top and bottom row pairs
+    r32 s0 = m.m[0][0] * m.m[1][1] - m.m[1][0] * m.m[0][1],
+        s1 = m.m[0][0] * m.m[1][2] - m.m[1][0] * m.m[0][2],
+        s2 = m.m[0][0] * m.m[1][3] - m.m[1][0] * m.m[0][3],
+        s3 = m.m[0][1] * m.m[1][2] - m.m[1][1] * m.m[0][2],
+        s4 = m.m[0][1] * m.m[1][3] - m.m[1][1] * m.m[0][3],
+        s5 = m.m[0][2] * m.m[1][3] - m.m[1][2] * m.m[0][3];
+
+    r32 c5 = m.m[2][2] * m.m[3][3] - m.m[3][2] * m.m[2][3],
+        c4 = m.m[2][1] * m.m[3][3] - m.m[3][1] * m.m[2][3],
+        c3 = m.m[2][1] * m.m[3][2] - m.m[3][1] * m.m[2][2],
+        c2 = m.m[2][0] * m.m[3][3] - m.m[3][0] * m.m[2][3],
+        c1 = m.m[2][0] * m.m[3][2] - m.m[3][0] * m.m[2][2],
+        c0 = m.m[2][0] * m.m[3][1] - m.m[3][0] * m.m[2][1];
+
+    r32 det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+
+    if(det != 0.0f)
+    {
+        r32 invdet = 1.0f / det;
+
+        result.m[0][0] = ( m.m[1][1] * c5 - m.m[1][2] * c4 + m.m[1][3] * c3) * invdet;
+        result.m[0][1] = (-m.m[0][1] * c5 + m.m[0][2] * c4 - m.m[0][3] * c3) * invdet;
+        result.m[0][2] = ( m.m[3][1] * s5 - m.m[3][2] * s4 + m.m[3][3] * s3) * invdet;
+        result.m[0][3] = (-m.m[2][1] * s5 + m.m[2][2] * s4 - m.m[2][3] * s3) * invdet;
+
+        result.m[1][0] = (-m.m[1][0] * c5 + m.m[1][2] * c2 - m.m[1][3] * c1) * invdet;
+        result.m[1][1] = ( m.m[0][0] * c5 - m.m[0][2] * c2 + m.m[0][3] * c1) * invdet;
+        result.m[1][2] = (-m.m[3][0] * s5 + m.m[3][2] * s2 - m.m[3][3] * s1) * invdet;
+        result.m[1][3] = ( m.m[2][0] * s5 - m.m[2][2] * s2 + m.m[2][3] * s1) * invdet;
+
+        result.m[2][0] = ( m.m[1][0] * c4 - m.m[1][1] * c2 + m.m[1][3] * c0) * invdet;
+        result.m[2][1] = (-m.m[0][0] * c4 + m.m[0][1] * c2 - m.m[0][3] * c0) * invdet;
+        result.m[2][2] = ( m.m[3][0] * s4 - m.m[3][1] * s2 + m.m[3][3] * s0) * invdet;
+        result.m[2][3] = (-m.m[2][0] * s4 + m.m[2][1] * s2 - m.m[2][3] * s0) * invdet;
+
+        result.m[3][0] = (-m.m[1][0] * c3 + m.m[1][1] * c1 - m.m[1][2] * c0) * invdet;
+        result.m[3][1] = ( m.m[0][0] * c3 - m.m[0][1] * c1 + m.m[0][2] * c0) * invdet;
+        result.m[3][2] = (-m.m[3][0] * s3 + m.m[3][1] * s1 - m.m[3][2] * s0) * invdet;
+        result.m[3][3] = ( m.m[2][0] * s3 - m.m[2][1] * s1 + m.m[2][2] * s0) * invdet;
+    }
+#endif
+    else
+    {
+        // NOTE: Singular matrix
+        AAM_Assert(false)
+        result = MAT4_IDENTITY;
+    }
+
+    return result;
+}
+
+// NOTE: Inverse of an affine matrix (last column 0, 0, 0, 1),
+//       any invertible upper 3x3 (rotation, scale, shear)
+inline mat4 InverseAffine(const mat4 &m)
+{
+    mat4 result;
+
+#if defined(AAMATH_SSE4)
+    __m128 x = _mm_loadu_ps(m.v[0].E),
+           y = _mm_loadu_ps(m.v[1].E),
+           z = _mm_loadu_ps(m.v[2].E);
+
+    // NOTE: Rows of the inverse are the cross products over the determinant,
+    //       transposed back into our basis-row layout
+    __m128 yz = Cross3(y, z),
+           zx = Cross3(z, x),
+           xy = Cross3(x, y),
+           zero = _mm_setzero_ps();
+
+    __m128 det = _mm_dp_ps(x, yz, 0x7F);
+
+    if(_mm_cvtss_f32(det) != 0.0f)
+    {
+        __m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+        yz = _mm_mul_ps(yz, invDet);
+        zx = _mm_mul_ps(zx, invDet);
+        xy = _mm_mul_ps(xy, invDet);
+
+        _MM_TRANSPOSE4_PS(yz, zx, xy, zero);
+
+        StoreAffineInverse(result, yz, zx, xy, m);
+    }
+#else
+    r32 co1 = m.yy * m.zz - m.zy * m.yz,
+        co2 = m.zy * m.xz - m.xy * m.zz,
+        co3 = m.xy * m.yz - m.yy * m.xz;
+
+    r32 det = m.xx * co1 + m.yx * co2 + m.zx * co3;
+
+    if(det != 0.0f)
+    {
+        r32 invdet = 1.0f / det;
+
+        result.xx = invdet * co1;
+        result.xy = invdet * co2;
+        result.xz = invdet * co3;
+        result.xw = 0;
+
+        result.yx = invdet * (m.zx * m.yz - m.yx * m.zz);
+        result.yy = invdet * (m.xx * m.zz - m.zx * m.xz);
+        result.yz = invdet * (m.yx * m.xz - m.xx * m.yz);
+        result.yw = 0;
+
+        result.zx = invdet * (m.yx * m.zy - m.zx * m.yy);
+        result.zy = invdet * (m.zx * m.xy - m.xx * m.zy);
+        result.zz = invdet * (m.xx * m.yy - m.yx * m.xy);
+        result.zw = 0;
+
+        result.tx = -(result.xx * m.tx + result.yx * m.ty + result.zx * m.tz);
+        result.ty = -(result.xy * m.tx + result.yy * m.ty + result.zy * m.tz);
+        result.tz = -(result.xz * m.tx + result.yz * m.ty + result.zz * m.tz);
+        result.ww = 1.0f;
+    }
+#endif
+    else
+    {
+        // NOTE: Singular matrix
+        AAM_Assert(false)
+        result = MAT4_IDENTITY;
+    }
+
+    return result;
+}
+
+// NOTE: Inverse of a rotation + translation matrix (orthonormal upper 3x3),
+//       the rotation is just transposed
+inline mat4 InverseRigid(const mat4 &m)
+{
+    mat4 result;
+
+#if defined(AAMATH_SSE4)
+    __m128 x = _mm_loadu_ps(m.v[0].E),
+           y = _mm_loadu_ps(m.v[1].E),
+           z = _mm_loadu_ps(m.v[2].E),
+           w = _mm_setzero_ps();
+
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+
+    StoreAffineInverse(result, x, y, z, m);
+#else
+    result.xx = m.xx;
+    result.xy = m.yx;
+    result.xz = m.zx;
+    result.xw = 0;
+
+    result.yx = m.xy;
+    result.yy = m.yy;
+    result.yz = m.zy;
+    result.yw = 0;
+
+    result.zx = m.xz;
+    result.zy = m.yz;
+    result.zz = m.zz;
+    result.zw = 0;
+
+    result.tx = -(m.xx * m.tx + m.xy * m.ty + m.xz * m.tz);
+    result.ty = -(m.yx * m.tx + m.yy * m.ty + m.yz * m.tz);
+    result.tz = -(m.zx * m.tx + m.zy * m.ty + m.zz * m.tz);
+    result.ww = 1.0f;
+#endif
+
+    return result;
+}
+
 inline mat4 Hadamard(const mat4 &a, const mat4 &b)
 {
     mat4 result;
@@ -820,17 +1157,17 @@ inline mat4 Mat4Rotation(const quat &q)
     zz = q.z * zs;
 
     result.xx = 1.0f - (yy + zz);
-    result.xy = xy - wz;
-    result.xz = xz + wy;
+    result.xy = xy + wz;
+    result.xz = xz - wy;
     result.tx = 0;
 
-    result.yx = xy + wz;
+    result.yx = xy - wz;
     result.yy = 1.0f - (xx + zz);
-    result.yz = yz - wx;
+    result.yz = yz + wx;
     result.ty = 0;
 
-    result.zx = xz - wy;
-    result.zy = yz + wx;
+    result.zx = xz + wy;
+    result.zy = yz - wx;
     result.zz = 1.0f - (xx + yy);
     result.tz = 0;
 
@@ -944,12 +1281,12 @@ inline vec4 GetEulerAngles(const mat4 &m)
 {
     vec4 result;
 
-    result.x = atan2f(m.yz, m.zz);
+    result.x = Atan2(m.yz, m.zz);
     r32 c2 = AASqrt((m.xx * m.xx) + (m.xy * m.xy));
-    result.y = atan2f(-m.xz, c2);
+    result.y = Atan2(-m.xz, c2);
     r32 s, c;
     SinCos(result.x, s, c);
-    result.z = atan2f((s * m.zx) - (c * m.yx), (c * m.yy) - (s * m.zy));
+    result.z = Atan2((s * m.zx) - (c * m.yx), (c * m.yy) - (s * m.zy));
     result.w = 0;
 
     return result;
@@ -958,7 +1295,7 @@ inline vec4 GetEulerAngles(const mat4 &m)
 inline void GetAxisAngle(const mat4 &m, vec4 &axis, r32 &angle)
 {
     r32 trace = m.xx + m.yy + m.zz;
-    angle = acosf(0.5f * (trace - 1.0f));
+    angle = Acos(0.5f * (trace - 1.0f));
 
     if(IsZero(angle))
     {
@@ -1008,40 +1345,41 @@ inline quat GetQuaternion(const mat4 &m)
     quat result;
     r32 trace = 1.0f + m.xx + m.yy + m.zz;
 
-    if(trace > EPSILON)
+    // NOTE: Only when w is large (trace > 0), dividing by a small w loses precision
+    if(trace > 1.0f)
     {
         r32 s = AASqrt(trace) * 2.0f,
             oneOverS = 1.0f / s;
         result.w = s * 0.25f;
-        result.x = (m.zy - m.yz) * s;
-        result.y = (m.xz - m.zx) * s;
-        result.z = (m.yx - m.xy) * s;
+        result.x = (m.yz - m.zy) * oneOverS;
+        result.y = (m.zx - m.xz) * oneOverS;
+        result.z = (m.xy - m.yx) * oneOverS;
     }
     else if(m.xx > m.yy && m.xx > m.zz)
     {
         r32 s = AASqrt(1.0f + m.xx - m.yy - m.zz) * 2.0f,
             oneOverS = 1.0f / s;
-        result.w = (m.zy - m.yz) * s;
+        result.w = (m.yz - m.zy) * oneOverS;
         result.x = s * 0.25f;
-        result.y = (m.xy + m.yx) * s;
-        result.z = (m.xz + m.zx) * s;
+        result.y = (m.xy + m.yx) * oneOverS;
+        result.z = (m.xz + m.zx) * oneOverS;
     }
     else if(m.yy > m.zz)
     {
         r32 s = AASqrt(1.0f + m.yy - m.xx - m.zz) * 2.0f,
             oneOverS = 1.0f / s;
-        result.w = (m.xz - m.zx) * s;
-        result.x = (m.xy + m.yx) * s;
+        result.w = (m.zx - m.xz) * oneOverS;
+        result.x = (m.xy + m.yx) * oneOverS;
         result.y = s * 0.25f;
-        result.z = (m.yz + m.zy) * s;
+        result.z = (m.yz + m.zy) * oneOverS;
     }
     else
     {
         r32 s = AASqrt(1.0f + m.zz - m.xx - m.yy) * 2.0f,
             oneOverS = 1.0f / s;
-        result.w = (m.yx - m.xy) * s;
-        result.x = (m.xz + m.zx) * s;
-        result.y = (m.yz + m.zy) * s;
+        result.w = (m.xy - m.yx) * oneOverS;
+        result.x = (m.xz + m.zx) * oneOverS;
+        result.y = (m.yz + m.zy) * oneOverS;
         result.z = s * 0.25f;
     }
 
@@ -1053,7 +1391,9 @@ inline mat4 PerspectiveLH(const r32 fov, const r32 aspect, const r32 nearZ, cons
 {
     mat4 result = MAT4_IDENTITY;
 
-    r32 d = 1.0f / tanf(fov / 360.0f * PI);
+    r32 s, c;
+    SinCos(fov / 360.0f * PI, s, c);
+    r32 d = c / s;
 
     result.xx = d / aspect;
     result.yy = d;
@@ -1072,7 +1412,9 @@ inline mat4 PerspectiveRH(const r32 fov, const r32 aspect, const r32 nearZ, cons
 
     // NOTE: condensed half fov deg -> rad conversion
     //       fov / 180 * pi / 2 -> fov / 360 * PI
-    r32 d = 1.0f / tanf(fov / 360.0f * PI);
+    r32 s, c;
+    SinCos(fov / 360.0f * PI, s, c);
+    r32 d = c / s;
 
     result.xx = d / aspect;
     result.yy = d;
@@ -1187,6 +1529,290 @@ inline mat4 LookAt(const vec4 &eye, const vec4 &at, const vec4 &up)
     return LookAt(eye.xyz, at.xyz, up.xyz);
 }
 
+//
+// NOTE: Point and direction transforms
+//
+
+// NOTE: m * (p, 1)
+inline vec3 TransformPoint(const mat4 &m, const vec3 &p)
+{
+    vec3 result;
+
+    result.x = m.xx * p.x + m.yx * p.y + m.zx * p.z + m.tx;
+    result.y = m.xy * p.x + m.yy * p.y + m.zy * p.z + m.ty;
+    result.z = m.xz * p.x + m.yz * p.y + m.zz * p.z + m.tz;
+
+    return result;
+}
+
+// NOTE: m * (d, 0)
+inline vec3 TransformDirection(const mat4 &m, const vec3 &d)
+{
+    vec3 result;
+
+    result.x = m.xx * d.x + m.yx * d.y + m.zx * d.z;
+    result.y = m.xy * d.x + m.yy * d.y + m.zy * d.z;
+    result.z = m.xz * d.x + m.yz * d.y + m.zz * d.z;
+
+    return result;
+}
+
+// NOTE: m * (p, 1), divided by the resulting w
+inline vec3 TransformPointProjective(const mat4 &m, const vec3 &p)
+{
+    r32 w = m.xw * p.x + m.yw * p.y + m.zw * p.z + m.ww;
+
+    return TransformPoint(m, p) * (1.0f / w);
+}
+
+inline vec3x4 TransformPoint(const mat4 &m, const vec3x4 &p)
+{
+    vec3x4 result;
+
+    result.x = MulAdd(R32x4(m.zx), p.z, MulAdd(R32x4(m.yx), p.y, MulAdd(R32x4(m.xx), p.x, R32x4(m.tx))));
+    result.y = MulAdd(R32x4(m.zy), p.z, MulAdd(R32x4(m.yy), p.y, MulAdd(R32x4(m.xy), p.x, R32x4(m.ty))));
+    result.z = MulAdd(R32x4(m.zz), p.z, MulAdd(R32x4(m.yz), p.y, MulAdd(R32x4(m.xz), p.x, R32x4(m.tz))));
+
+    return result;
+}
+
+inline vec3x4 TransformDirection(const mat4 &m, const vec3x4 &d)
+{
+    vec3x4 result;
+
+    result.x = MulAdd(R32x4(m.zx), d.z, MulAdd(R32x4(m.yx), d.y, R32x4(m.xx) * d.x));
+    result.y = MulAdd(R32x4(m.zy), d.z, MulAdd(R32x4(m.yy), d.y, R32x4(m.xy) * d.x));
+    result.z = MulAdd(R32x4(m.zz), d.z, MulAdd(R32x4(m.yz), d.y, R32x4(m.xz) * d.x));
+
+    return result;
+}
+
+inline vec3x4 TransformPointProjective(const mat4 &m, const vec3x4 &p)
+{
+    r32x4 w = MulAdd(R32x4(m.zw), p.z, MulAdd(R32x4(m.yw), p.y, MulAdd(R32x4(m.xw), p.x, R32x4(m.ww))));
+
+    return TransformPoint(m, p) / w;
+}
+
+inline vec3x8 TransformPoint(const mat4 &m, const vec3x8 &p)
+{
+    vec3x8 result;
+
+    result.x = MulAdd(R32x8(m.zx), p.z, MulAdd(R32x8(m.yx), p.y, MulAdd(R32x8(m.xx), p.x, R32x8(m.tx))));
+    result.y = MulAdd(R32x8(m.zy), p.z, MulAdd(R32x8(m.yy), p.y, MulAdd(R32x8(m.xy), p.x, R32x8(m.ty))));
+    result.z = MulAdd(R32x8(m.zz), p.z, MulAdd(R32x8(m.yz), p.y, MulAdd(R32x8(m.xz), p.x, R32x8(m.tz))));
+
+    return result;
+}
+
+inline vec3x8 TransformDirection(const mat4 &m, const vec3x8 &d)
+{
+    vec3x8 result;
+
+    result.x = MulAdd(R32x8(m.zx), d.z, MulAdd(R32x8(m.yx), d.y, R32x8(m.xx) * d.x));
+    result.y = MulAdd(R32x8(m.zy), d.z, MulAdd(R32x8(m.yy), d.y, R32x8(m.xy) * d.x));
+    result.z = MulAdd(R32x8(m.zz), d.z, MulAdd(R32x8(m.yz), d.y, R32x8(m.xz) * d.x));
+
+    return result;
+}
+
+inline vec3x8 TransformPointProjective(const mat4 &m, const vec3x8 &p)
+{
+    r32x8 w = MulAdd(R32x8(m.zw), p.z, MulAdd(R32x8(m.yw), p.y, MulAdd(R32x8(m.xw), p.x, R32x8(m.ww))));
+
+    return TransformPoint(m, p) / w;
+}
+
+//
+// NOTE: Batch transforms
+//
+//       8 (AVX2) or 4 elements per iteration, scalar tail. Large outputs that are
+//       16-byte aligned are written with streaming stores so they don't evict
+//       the working set, see AAMATH_STREAM_THRESHOLD.
+//       in and out may be the same array.
+//
+
+inline b32 UseStreamingStores(const void *out, u32 count)
+{
+    return (count >= AAMATH_STREAM_THRESHOLD) && (((uintptr_t)out & 15) == 0);
+}
+
+inline void TransformPoints(const mat4 &m, const vec3 *in, vec3 *out, u32 count)
+{
+    b32 stream = UseStreamingStores(out, count);
+    u32 i = 0;
+
+#if defined(AAMATH_AVX2)
+    for(; i + 8 <= count; i += 8)
+    {
+        vec3x8 p = TransformPoint(m, LoadVec3x8(in + i));
+
+        if(stream)
+            StoreStream(out + i, p);
+        else
+            Store(out + i, p);
+    }
+#endif
+    for(; i + 4 <= count; i += 4)
+    {
+        vec3x4 p = TransformPoint(m, LoadVec3x4(in + i));
+
+        if(stream)
+            StoreStream(out + i, p);
+        else
+            Store(out + i, p);
+    }
+    for(; i < count; ++i)
+    {
+        out[i] = TransformPoint(m, in[i]);
+    }
+
+    if(stream)
+        StreamFence();
+}
+
+inline void TransformDirections(const mat4 &m, const vec3 *in, vec3 *out, u32 count)
+{
+    b32 stream = UseStreamingStores(out, count);
+    u32 i = 0;
+
+#if defined(AAMATH_AVX2)
+    for(; i + 8 <= count; i += 8)
+    {
+        vec3x8 d = TransformDirection(m, LoadVec3x8(in + i));
+
+        if(stream)
+            StoreStream(out + i, d);
+        else
+            Store(out + i, d);
+    }
+#endif
+    for(; i + 4 <= count; i += 4)
+    {
+        vec3x4 d = TransformDirection(m, LoadVec3x4(in + i));
+
+        if(stream)
+            StoreStream(out + i, d);
+        else
+            Store(out + i, d);
+    }
+    for(; i < count; ++i)
+    {
+        out[i] = TransformDirection(m, in[i]);
+    }
+
+    if(stream)
+        StreamFence();
+}
+
+// NOTE: With w-divide, e.g. world -> NDC through a view-projection matrix
+inline void TransformPointsProjective(const mat4 &m, const vec3 *in, vec3 *out, u32 count)
+{
+    b32 stream = UseStreamingStores(out, count);
+    u32 i = 0;
+
+#if defined(AAMATH_AVX2)
+    for(; i + 8 <= count; i += 8)
+    {
+        vec3x8 p = TransformPointProjective(m, LoadVec3x8(in + i));
+
+        if(stream)
+            StoreStream(out + i, p);
+        else
+            Store(out + i, p);
+    }
+#endif
+    for(; i + 4 <= count; i += 4)
+    {
+        vec3x4 p = TransformPointProjective(m, LoadVec3x4(in + i));
+
+        if(stream)
+            StoreStream(out + i, p);
+        else
+            Store(out + i, p);
+    }
+    for(; i < count; ++i)
+    {
+        out[i] = TransformPointProjective(m, in[i]);
+    }
+
+    if(stream)
+        StreamFence();
+}
+
+// NOTE: Full 4D transform of an array of vec4
+inline void Transform(const mat4 &m, const vec4 *in, vec4 *out, u32 count)
+{
+#if defined(AAMATH_SSE4)
+    if(UseStreamingStores(out, count))
+    {
+        for(u32 i = 0; i < count; ++i)
+        {
+            vec4 v = m * in[i];
+            _mm_stream_ps(out[i].E, _mm_loadu_ps(v.E));
+        }
+
+        StreamFence();
+        return;
+    }
+#endif
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        out[i] = m * in[i];
+    }
+}
+
+// NOTE: Strided variants read/write vec3s spaced stride bytes apart,
+//       e.g. the position member of an interleaved vertex
+inline void TransformPointsStrided(const mat4 &m, const void *in, u32 inStride, void *out, u32 outStride, u32 count)
+{
+    const u8 *src = (const u8 *)in;
+    u8 *dst = (u8 *)out;
+    u32 i = 0;
+
+    for(; i + 4 <= count; i += 4)
+    {
+        Store(dst + i * outStride, outStride, TransformPoint(m, LoadVec3x4(src + i * inStride, inStride)));
+    }
+    for(; i < count; ++i)
+    {
+        *(vec3 *)(dst + i * outStride) = TransformPoint(m, *(const vec3 *)(src + i * inStride));
+    }
+}
+
+inline void TransformDirectionsStrided(const mat4 &m, const void *in, u32 inStride, void *out, u32 outStride, u32 count)
+{
+    const u8 *src = (const u8 *)in;
+    u8 *dst = (u8 *)out;
+    u32 i = 0;
+
+    for(; i + 4 <= count; i += 4)
+    {
+        Store(dst + i * outStride, outStride, TransformDirection(m, LoadVec3x4(src + i * inStride, inStride)));
+    }
+    for(; i < count; ++i)
+    {
+        *(vec3 *)(dst + i * outStride) = TransformDirection(m, *(const vec3 *)(src + i * inStride));
+    }
+}
+
+inline void TransformPointsProjectiveStrided(const mat4 &m, const void *in, u32 inStride, void *out, u32 outStride, u32 count)
+{
+    const u8 *src = (const u8 *)in;
+    u8 *dst = (u8 *)out;
+    u32 i = 0;
+
+    for(; i + 4 <= count; i += 4)
+    {
+        Store(dst + i * outStride, outStride, TransformPointProjective(m, LoadVec3x4(src + i * inStride, inStride)));
+    }
+    for(; i < count; ++i)
+    {
+        *(vec3 *)(dst + i * outStride) = TransformPointProjective(m, *(const vec3 *)(src + i * inStride));
+    }
+}
+
 } // NOTE: Namespace
 
 #endif
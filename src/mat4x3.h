@@ -0,0 +1,374 @@
+#ifndef MAT4X3_H
+#define MAT4X3_H
+
+#include "aamath.h"
+#include "vec3.h"
+#include "mat3.h"
+#include "mat4.h"
+#include "quat.h"
+#include "wide.h"
+
+namespace aam
+{
+
+// NOTE: Affine transform, mat4 without the constant (0, 0, 0, 1) column.
+//       Same basis-row layout as mat4 (x, y, z basis then translation t),
+//       12 floats instead of 16. Column vectors -- T * R * S * v.
+typedef union _mat4x3
+{
+    struct
+    {
+        r32 xx, xy, xz,
+            yx, yy, yz,
+            zx, zy, zz,
+            tx, ty, tz;
+    };
+
+    struct
+    {
+        vec3 x, y, z, t;
+    };
+
+    vec3 v[4];
+    r32 E[12];
+} mat4x3;
+
+//
+// NOTE: Static constants
+//
+
+static const mat4x3 MAT4X3_IDENTITY = {1.0f, 0.0f, 0.0f,
+                                       0.0f, 1.0f, 0.0f,
+                                       0.0f, 0.0f, 1.0f,
+                                       0.0f, 0.0f, 0.0f};
+
+//
+// NOTE: Conversions
+//
+
+inline mat4x3 Mat4x3(const mat3 &m, const vec3 &t)
+{
+    mat4x3 result;
+
+    result.x = m.x;
+    result.y = m.y;
+    result.z = m.z;
+    result.t = t;
+
+    return result;
+}
+
+// NOTE: Drops the w column, m must be affine
+inline mat4x3 Mat4x3(const mat4 &m)
+{
+    mat4x3 result;
+
+    result.x = m.x.xyz;
+    result.y = m.y.xyz;
+    result.z = m.z.xyz;
+    result.t = m.t.xyz;
+
+    return result;
+}
+
+// NOTE: Rotate then translate, rotation must be unit length
+inline mat4x3 Mat4x3(const quat &rotation, const vec3 &translation)
+{
+    return Mat4x3(Mat3Rotation(rotation), translation);
+}
+
+inline mat4 ToMat4(const mat4x3 &m)
+{
+    mat4 result;
+
+    result.x = Vec4(m.x, 0.0f);
+    result.y = Vec4(m.y, 0.0f);
+    result.z = Vec4(m.z, 0.0f);
+    result.t = Vec4(m.t, 1.0f);
+
+    return result;
+}
+
+inline mat3 Upper3x3(const mat4x3 &m)
+{
+    mat3 result;
+
+    result.x = m.x;
+    result.y = m.y;
+    result.z = m.z;
+
+    return result;
+}
+
+// NOTE: Rotation part, the basis must be orthonormal
+inline quat GetQuaternion(const mat4x3 &m)
+{
+    return GetQuaternion(Upper3x3(m));
+}
+
+#if defined(AAMATH_SSE4)
+// NOTE: The 12 floats as 3 loads, split into the 4 rows (w lanes undefined)
+inline void LoadRows(const mat4x3 &m, __m128 &x, __m128 &y, __m128 &z, __m128 &t)
+{
+    __m128 l0 = _mm_loadu_ps(m.E),
+           l1 = _mm_loadu_ps(m.E + 4),
+           l2 = _mm_loadu_ps(m.E + 8);
+
+    x = l0;
+    y = _mm_castsi128_ps(_mm_alignr_epi8(_mm_castps_si128(l1), _mm_castps_si128(l0), 12));
+    z = _mm_castsi128_ps(_mm_alignr_epi8(_mm_castps_si128(l2), _mm_castps_si128(l1), 8));
+    t = _mm_castsi128_ps(_mm_srli_si128(_mm_castps_si128(l2), 4));
+}
+
+// NOTE: Packs the xyz of 4 rows back into 3 stores
+inline void StoreRows(mat4x3 &m, __m128 x, __m128 y, __m128 z, __m128 t)
+{
+    __m128 s0 = _mm_blend_ps(x, _mm_shuffle_ps(y, y, _MM_SHUFFLE(0, 0, 0, 0)), 0x8),
+           s1 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 0, 2, 1)),
+           s2 = _mm_blend_ps(_mm_shuffle_ps(t, t, _MM_SHUFFLE(2, 1, 0, 0)),
+                             _mm_shuffle_ps(z, z, _MM_SHUFFLE(2, 2, 2, 2)), 0x1);
+
+    _mm_storeu_ps(m.E, s0);
+    _mm_storeu_ps(m.E + 4, s1);
+    _mm_storeu_ps(m.E + 8, s2);
+}
+#endif
+
+//
+// NOTE: Operators
+//
+
+// NOTE: a * b applies b first, as with mat4
+inline mat4x3 operator*(const mat4x3 &a, const mat4x3 &b)
+{
+    mat4x3 result;
+
+#if defined(AAMATH_SSE4)
+    __m128 ax, ay, az, at,
+           bx, by, bz, bt;
+    LoadRows(a, ax, ay, az, at);
+    LoadRows(b, bx, by, bz, bt);
+
+    // NOTE: Each result row is a's basis weighted by b's row (plus a.t for b.t)
+    __m128 rx = MulAdd(az, AAM_Swizzle(bx, 2, 2, 2, 2), MulAdd(ay, AAM_Swizzle(bx, 1, 1, 1, 1),
+                       _mm_mul_ps(ax, AAM_Swizzle(bx, 0, 0, 0, 0)))),
+           ry = MulAdd(az, AAM_Swizzle(by, 2, 2, 2, 2), MulAdd(ay, AAM_Swizzle(by, 1, 1, 1, 1),
+                       _mm_mul_ps(ax, AAM_Swizzle(by, 0, 0, 0, 0)))),
+           rz = MulAdd(az, AAM_Swizzle(bz, 2, 2, 2, 2), MulAdd(ay, AAM_Swizzle(bz, 1, 1, 1, 1),
+                       _mm_mul_ps(ax, AAM_Swizzle(bz, 0, 0, 0, 0)))),
+           rt = MulAdd(az, AAM_Swizzle(bt, 2, 2, 2, 2), MulAdd(ay, AAM_Swizzle(bt, 1, 1, 1, 1),
+                       MulAdd(ax, AAM_Swizzle(bt, 0, 0, 0, 0), at)));
+
+    StoreRows(result, rx, ry, rz, rt);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        const vec3 &r = b.v[i];
+
+        result.v[i] = a.x * r.x + a.y * r.y + a.z * r.z;
+    }
+
+    result.t += a.t;
+#endif
+
+    return result;
+}
+
+inline mat4x3 &operator*=(mat4x3 &a, const mat4x3 &b)
+{
+    a = a * b;
+
+    return a;
+}
+
+inline b32 operator==(const mat4x3 &a, const mat4x3 &b)
+{
+    return (a.x == b.x && a.y == b.y && a.z == b.z && a.t == b.t);
+}
+
+inline b32 operator!=(const mat4x3 &a, const mat4x3 &b)
+{
+    return !(a == b);
+}
+
+//
+// NOTE: Functions
+//
+
+inline r32 Determinant(const mat4x3 &m)
+{
+    return Dot(m.x, Cross(m.y, m.z));
+}
+
+// NOTE: General affine inverse, identity when the upper 3x3 is singular
+inline mat4x3 Inverse(const mat4x3 &m)
+{
+    mat4x3 result = MAT4X3_IDENTITY;
+
+#if defined(AAMATH_SSE4)
+    __m128 x, y, z, t;
+    LoadRows(m, x, y, z, t);
+
+    // NOTE: Same scheme as InverseAffine(mat4), the cross products over the
+    //       determinant are the rows of the transposed inverse
+    __m128 yz = Cross3(y, z),
+           zx = Cross3(z, x),
+           xy = Cross3(x, y),
+           w = _mm_setzero_ps();
+    __m128 det = _mm_dp_ps(x, yz, 0x7F);
+
+    if(_mm_cvtss_f32(det) != 0.0f)
+    {
+        __m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+        yz = _mm_mul_ps(yz, invDet);
+        zx = _mm_mul_ps(zx, invDet);
+        xy = _mm_mul_ps(xy, invDet);
+
+        _MM_TRANSPOSE4_PS(yz, zx, xy, w);
+
+        __m128 it = MulAdd(xy, AAM_Swizzle(t, 2, 2, 2, 2), MulAdd(zx, AAM_Swizzle(t, 1, 1, 1, 1),
+                           _mm_mul_ps(yz, AAM_Swizzle(t, 0, 0, 0, 0))));
+
+        StoreRows(result, yz, zx, xy, _mm_sub_ps(_mm_setzero_ps(), it));
+    }
+#else
+    vec3 yz = Cross(m.y, m.z),
+         zx = Cross(m.z, m.x),
+         xy = Cross(m.x, m.y);
+    r32 det = Dot(m.x, yz);
+
+    if(det != 0.0f)
+    {
+        r32 invDet = 1.0f / det;
+
+        yz *= invDet;
+        zx *= invDet;
+        xy *= invDet;
+
+        result.x = Vec3(yz.x, zx.x, xy.x);
+        result.y = Vec3(yz.y, zx.y, xy.y);
+        result.z = Vec3(yz.z, zx.z, xy.z);
+        result.t = -(result.x * m.t.x + result.y * m.t.y + result.z * m.t.z);
+    }
+#endif
+
+    return result;
+}
+
+// NOTE: Rotation and translation only (orthonormal basis): transpose the
+//       rotation and rotate back the negated translation
+inline mat4x3 InverseRigid(const mat4x3 &m)
+{
+    mat4x3 result;
+
+    result.x = Vec3(m.x.x, m.y.x, m.z.x);
+    result.y = Vec3(m.x.y, m.y.y, m.z.y);
+    result.z = Vec3(m.x.z, m.y.z, m.z.z);
+    result.t = -Vec3(Dot(m.x, m.t), Dot(m.y, m.t), Dot(m.z, m.t));
+
+    return result;
+}
+
+//
+// NOTE: Point and direction transforms
+//
+
+inline vec3 TransformPoint(const mat4x3 &m, const vec3 &p)
+{
+    vec3 result;
+
+    result.x = m.xx * p.x + m.yx * p.y + m.zx * p.z + m.tx;
+    result.y = m.xy * p.x + m.yy * p.y + m.zy * p.z + m.ty;
+    result.z = m.xz * p.x + m.yz * p.y + m.zz * p.z + m.tz;
+
+    return result;
+}
+
+inline vec3 TransformDirection(const mat4x3 &m, const vec3 &d)
+{
+    vec3 result;
+
+    result.x = m.xx * d.x + m.yx * d.y + m.zx * d.z;
+    result.y = m.xy * d.x + m.yy * d.y + m.zy * d.z;
+    result.z = m.xz * d.x + m.yz * d.y + m.zz * d.z;
+
+    return result;
+}
+
+inline vec3x4 TransformPoint(const mat4x3 &m, const vec3x4 &p)
+{
+    vec3x4 result;
+
+    result.x = MulAdd(R32x4(m.zx), p.z, MulAdd(R32x4(m.yx), p.y, MulAdd(R32x4(m.xx), p.x, R32x4(m.tx))));
+    result.y = MulAdd(R32x4(m.zy), p.z, MulAdd(R32x4(m.yy), p.y, MulAdd(R32x4(m.xy), p.x, R32x4(m.ty))));
+    result.z = MulAdd(R32x4(m.zz), p.z, MulAdd(R32x4(m.yz), p.y, MulAdd(R32x4(m.xz), p.x, R32x4(m.tz))));
+
+    return result;
+}
+
+inline vec3x4 TransformDirection(const mat4x3 &m, const vec3x4 &d)
+{
+    vec3x4 result;
+
+    result.x = MulAdd(R32x4(m.zx), d.z, MulAdd(R32x4(m.yx), d.y, R32x4(m.xx) * d.x));
+    result.y = MulAdd(R32x4(m.zy), d.z, MulAdd(R32x4(m.yy), d.y, R32x4(m.xy) * d.x));
+    result.z = MulAdd(R32x4(m.zz), d.z, MulAdd(R32x4(m.yz), d.y, R32x4(m.xz) * d.x));
+
+    return result;
+}
+
+inline vec3x8 TransformPoint(const mat4x3 &m, const vec3x8 &p)
+{
+    vec3x8 result;
+
+    result.x = MulAdd(R32x8(m.zx), p.z, MulAdd(R32x8(m.yx), p.y, MulAdd(R32x8(m.xx), p.x, R32x8(m.tx))));
+    result.y = MulAdd(R32x8(m.zy), p.z, MulAdd(R32x8(m.yy), p.y, MulAdd(R32x8(m.xy), p.x, R32x8(m.ty))));
+    result.z = MulAdd(R32x8(m.zz), p.z, MulAdd(R32x8(m.yz), p.y, MulAdd(R32x8(m.xz), p.x, R32x8(m.tz))));
+
+    return result;
+}
+
+inline vec3x8 TransformDirection(const mat4x3 &m, const vec3x8 &d)
+{
+    vec3x8 result;
+
+    result.x = MulAdd(R32x8(m.zx), d.z, MulAdd(R32x8(m.yx), d.y, R32x8(m.xx) * d.x));
+    result.y = MulAdd(R32x8(m.zy), d.z, MulAdd(R32x8(m.yy), d.y, R32x8(m.xy) * d.x));
+    result.z = MulAdd(R32x8(m.zz), d.z, MulAdd(R32x8(m.yz), d.y, R32x8(m.xz) * d.x));
+
+    return result;
+}
+
+// NOTE: Batch versions share the mat4 kernels (same layout, w column implied)
+inline void TransformPoints(const mat4x3 &m, const vec3 *in, vec3 *out, u32 count)
+{
+    TransformPoints(ToMat4(m), in, out, count);
+}
+
+inline void TransformDirections(const mat4x3 &m, const vec3 *in, vec3 *out, u32 count)
+{
+    TransformDirections(ToMat4(m), in, out, count);
+}
+
+// NOTE: out[i] = a[i] * b[i], e.g. parent world * local for a whole level
+inline void Multiply(const mat4x3 *a, const mat4x3 *b, mat4x3 *out, u32 count)
+{
+    for(u32 i = 0; i < count; ++i)
+    {
+        out[i] = a[i] * b[i];
+    }
+}
+
+// NOTE: out[i] = a * b[i]
+inline void Multiply(const mat4x3 &a, const mat4x3 *b, mat4x3 *out, u32 count)
+{
+    for(u32 i = 0; i < count; ++i)
+    {
+        out[i] = a * b[i];
+    }
+}
+
+} // NOTE: Namespace
+
+#endif
@@ -16,7 +16,7 @@ typedef union _quat
     };
     struct
     {
-        r32 w;
+        r32 pad0;
         vec3 xyz;
     };
     vec4 v;
@@ -173,7 +173,7 @@ inline quat Conjugate(const quat &q)
 
 inline r32 Dot(const quat &a, const quat &b)
 {
-    return Dot(a.v, b.v);
+    return (a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z);
 }
 
 inline quat Inverse(const quat &q)
@@ -196,7 +196,7 @@ inline quat Inverse(const quat &q)
 
 inline r32 Norm(const quat &q)
 {
-    return Dot(q.v, q.v);
+    return Dot(q, q);
 }
 
 inline void Normalize(quat &q)
@@ -405,7 +405,6 @@ inline vec3 Rotate(const quat &q, const vec3 &v)
     result.x = pMult * v.x + vMult * q.x + crossMult * (q.y * v.z - q.z * v.y);
     result.y = pMult * v.y + vMult * q.y + crossMult * (q.z * v.x - q.x * v.z);
     result.z = pMult * v.z + vMult * q.z + crossMult * (q.x * v.y - q.y * v.x);
-    result.w = v.w;
 
     return result;
 }
@@ -445,11 +444,11 @@ inline void Slerp(quat &q, const quat &start, r32 t, const quat &end)
     {
         if ((1.0f - cos) > EPSILON)
         {
-            r32 angle = acosf(cos);
-            r32 recipSin = 1.0f / sinf(angle);
+            r32 angle = Acos(cos);
+            r32 recipSin = 1.0f / Sin(angle);
 
-            startt = sinf((1.0f - t) * angle) * recipSin;
-            endt = sinf(angle * t) * recipSin;
+            startt = Sin((1.0f - t) * angle) * recipSin;
+            endt = Sin(angle * t) * recipSin;
         }
         else
         {
@@ -462,11 +461,12 @@ inline void Slerp(quat &q, const quat &start, r32 t, const quat &end)
     {
         if ((1.0f + cos) > EPSILON)
         {
-            r32 angle = acosf(-cos);
-            r32 recipSin = 1.0f / sinf(angle);
+            // NOTE: Interpolate from -start, the shorter arc
+            r32 angle = Acos(-cos);
+            r32 recipSin = 1.0f / Sin(angle);
 
-            startt = sinf((1.0f - t) * angle) * recipSin;
-            endt = sinf(angle * t) * recipSin;
+            startt = -Sin((1.0f - t) * angle) * recipSin;
+            endt = Sin(angle * t) * recipSin;
         }
         else
         {
@@ -483,7 +483,8 @@ inline void ApproxSlerp(quat &q, const quat &start, r32 t, const quat &end)
 {
     r32 cos = Dot(start, end);
 
-    r32 factor = 1.0f - 0.7878088f * cos;
+    // NOTE: The correction depends on the angle of the shorter arc
+    r32 factor = 1.0f - 0.7878088f * fabsf(cos);
     r32 k = 0.5069269f;
     factor *= factor;
     k *= factor;
@@ -492,7 +493,7 @@ inline void ApproxSlerp(quat &q, const quat &start, r32 t, const quat &end)
         c = -3 * k,
         d = 1 + k;
 
-    t = t * (b * t + c) + d;
+    t = t * (t * (b * t + c) + d);
 
     q = end * t;
 
@@ -0,0 +1,478 @@
+#ifndef RAYPACKET_H
+#define RAYPACKET_H
+
+#include "aamath.h"
+#include "simd.h"
+#include "wide.h"
+#include "collision.h"
+
+namespace aam {
+
+// NOTE: Packets of 4, 8 or 16 rays in SoA form, with 1 / direction
+//       precomputed, tested against one aabb or sphere at a time. The tests
+//       return a hit mask (bit i set when lane i hits) and the entry distances
+//       along each ray, in direction lengths (0 when the origin is inside,
+//       FLT_MAX for the lanes that miss). Only hits entering by maxT count.
+//       There is no 16-wide backend, ray3x16 is a pair of ray3x8.
+
+typedef struct _ray3x4
+{
+    vec3x4 origin,
+           direction,
+           invDirection;
+} ray3x4;
+
+typedef struct _ray3x8
+{
+    vec3x8 origin,
+           direction,
+           invDirection;
+} ray3x8;
+
+typedef struct _ray3x16
+{
+    ray3x8 h[2];
+} ray3x16;
+
+//
+// NOTE: Construction
+//
+
+inline ray3x4 Ray3x4(const vec3x4 &origin, const vec3x4 &direction)
+{
+    ray3x4 result;
+
+    result.origin = origin;
+    result.direction = direction;
+    result.invDirection = Vec3x4(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+    return result;
+}
+
+// NOTE: Fan of rays from a shared origin
+inline ray3x4 Ray3x4(const vec3 &origin, const vec3x4 &direction)
+{
+    return Ray3x4(Vec3x4(origin), direction);
+}
+
+// NOTE: Loads 4 consecutive rays
+inline ray3x4 LoadRay3x4(const ray3 *src)
+{
+    return Ray3x4(LoadVec3x4(&src[0].origin, sizeof(ray3)),
+                  LoadVec3x4(&src[0].direction, sizeof(ray3)));
+}
+
+inline ray3x8 Ray3x8(const vec3x8 &origin, const vec3x8 &direction)
+{
+    ray3x8 result;
+
+    result.origin = origin;
+    result.direction = direction;
+    result.invDirection = Vec3x8(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+    return result;
+}
+
+inline ray3x8 Ray3x8(const vec3 &origin, const vec3x8 &direction)
+{
+    return Ray3x8(Vec3x8(origin), direction);
+}
+
+// NOTE: Loads 8 consecutive rays
+inline ray3x8 LoadRay3x8(const ray3 *src)
+{
+    vec3x8 origin = Vec3x8(LoadVec3x4(&src[0].origin, sizeof(ray3)), LoadVec3x4(&src[4].origin, sizeof(ray3))),
+           direction = Vec3x8(LoadVec3x4(&src[0].direction, sizeof(ray3)), LoadVec3x4(&src[4].direction, sizeof(ray3)));
+
+    return Ray3x8(origin, direction);
+}
+
+// NOTE: Loads 16 consecutive rays
+inline ray3x16 LoadRay3x16(const ray3 *src)
+{
+    ray3x16 result;
+
+    result.h[0] = LoadRay3x8(src);
+    result.h[1] = LoadRay3x8(src + 8);
+
+    return result;
+}
+
+//
+// NOTE: aabb
+//
+
+// NOTE: Slab test per lane, the sign of 1 / direction picks the near and far
+//       slab distance. NaN (0 * inf, origin on a slab of a zero direction
+//       component) is dropped by the Min/Max argument order, as in the scalar
+//       fastray3 version.
+inline u32 Intersects(const aabb &bb, const ray3x4 &r, r32x4 &tEntry, r32 maxT = FLT_MAX)
+{
+    vec3x4 t0 = Hadamard(Vec3x4(bb.min) - r.origin, r.invDirection),
+           t1 = Hadamard(Vec3x4(bb.max) - r.origin, r.invDirection);
+
+    r32x4 zero = R32x4(0.0f),
+          tNear = zero,
+          tFar = R32x4(maxT);
+
+    r32x4 negX = r.invDirection.x < zero,
+          negY = r.invDirection.y < zero,
+          negZ = r.invDirection.z < zero;
+
+    tNear = Max(Select(negX, t1.x, t0.x), tNear);
+    tNear = Max(Select(negY, t1.y, t0.y), tNear);
+    tNear = Max(Select(negZ, t1.z, t0.z), tNear);
+    tFar = Min(Select(negX, t0.x, t1.x), tFar);
+    tFar = Min(Select(negY, t0.y, t1.y), tFar);
+    tFar = Min(Select(negZ, t0.z, t1.z), tFar);
+
+    r32x4 hit = tNear <= tFar;
+    tEntry = Select(hit, tNear, R32x4(FLT_MAX));
+
+    return MoveMask(hit);
+}
+
+inline u32 Intersects(const aabb &bb, const ray3x8 &r, r32x8 &tEntry, r32 maxT = FLT_MAX)
+{
+    vec3x8 t0 = Hadamard(Vec3x8(bb.min) - r.origin, r.invDirection),
+           t1 = Hadamard(Vec3x8(bb.max) - r.origin, r.invDirection);
+
+    r32x8 zero = R32x8(0.0f),
+          tNear = zero,
+          tFar = R32x8(maxT);
+
+    r32x8 negX = r.invDirection.x < zero,
+          negY = r.invDirection.y < zero,
+          negZ = r.invDirection.z < zero;
+
+    tNear = Max(Select(negX, t1.x, t0.x), tNear);
+    tNear = Max(Select(negY, t1.y, t0.y), tNear);
+    tNear = Max(Select(negZ, t1.z, t0.z), tNear);
+    tFar = Min(Select(negX, t0.x, t1.x), tFar);
+    tFar = Min(Select(negY, t0.y, t1.y), tFar);
+    tFar = Min(Select(negZ, t0.z, t1.z), tFar);
+
+    r32x8 hit = tNear <= tFar;
+    tEntry = Select(hit, tNear, R32x8(FLT_MAX));
+
+    return MoveMask(hit);
+}
+
+// NOTE: tEntry holds the two halves
+inline u32 Intersects(const aabb &bb, const ray3x16 &r, r32x8 *tEntry, r32 maxT = FLT_MAX)
+{
+    return Intersects(bb, r.h[0], tEntry[0], maxT)
+           | (Intersects(bb, r.h[1], tEntry[1], maxT) << 8);
+}
+
+//
+// NOTE: sphere
+//
+
+// NOTE: Roots of |o + t d - c|^2 = r^2, t = (b -+ sqrt(b^2 - a c)) / a with
+//       a = d.d, b = d.(c - o), c = |c - o|^2 - r^2. A hit needs real roots
+//       and the far one in front of the origin, the same cases as the scalar
+//       Intersects(sphere, ray3).
+inline u32 Intersects(const sphere &s, const ray3x4 &r, r32x4 &tEntry, r32 maxT = FLT_MAX)
+{
+    vec3x4 w = Vec3x4(s.origin) - r.origin;
+
+    r32x4 a = LengthSq(r.direction),
+          b = Dot(w, r.direction),
+          c = LengthSq(w) - s.radius * s.radius,
+          disc = b * b - a * c,
+          root = Sqrt(Max(disc, R32x4(0.0f))),
+          recipA = 1.0f / a;
+
+    r32x4 tNear = Max((b - root) * recipA, R32x4(0.0f)),
+          tFar = (b + root) * recipA;
+
+    r32x4 hit = (disc >= R32x4(0.0f)) & (tFar >= R32x4(0.0f)) & (tNear <= R32x4(maxT));
+    tEntry = Select(hit, tNear, R32x4(FLT_MAX));
+
+    return MoveMask(hit);
+}
+
+inline u32 Intersects(const sphere &s, const ray3x8 &r, r32x8 &tEntry, r32 maxT = FLT_MAX)
+{
+    vec3x8 w = Vec3x8(s.origin) - r.origin;
+
+    r32x8 a = LengthSq(r.direction),
+          b = Dot(w, r.direction),
+          c = LengthSq(w) - s.radius * s.radius,
+          disc = b * b - a * c,
+          root = Sqrt(Max(disc, R32x8(0.0f))),
+          recipA = 1.0f / a;
+
+    r32x8 tNear = Max((b - root) * recipA, R32x8(0.0f)),
+          tFar = (b + root) * recipA;
+
+    r32x8 hit = (disc >= R32x8(0.0f)) & (tFar >= R32x8(0.0f)) & (tNear <= R32x8(maxT));
+    tEntry = Select(hit, tNear, R32x8(FLT_MAX));
+
+    return MoveMask(hit);
+}
+
+inline u32 Intersects(const sphere &s, const ray3x16 &r, r32x8 *tEntry, r32 maxT = FLT_MAX)
+{
+    return Intersects(s, r.h[0], tEntry[0], maxT)
+           | (Intersects(s, r.h[1], tEntry[1], maxT) << 8);
+}
+
+//
+// NOTE: Hit records, batched
+//
+
+// NOTE: Caller-owned SoA results of a batch, element i of every array belongs
+//       to query i. Bit (i % 32) of hits[i / 32] is set on a hit, hits needs
+//       (count + 31) / 32 words. Misses get tEntry = tExit = FLT_MAX, their
+//       points and normals are undefined. Any array but hits and tEntry may
+//       be 0 to skip it.
+typedef struct _rayhitbuffer
+{
+    u32 *hits;
+    r32 *tEntry,
+        *tExit,
+        *pointX, *pointY, *pointZ,
+        *normalX, *normalY, *normalZ;
+} rayhitbuffer;
+
+typedef struct _rayhitx4
+{
+    r32x4 tEntry,
+          tExit;
+    vec3x4 point,
+           normal;
+} rayhitx4;
+
+// NOTE: Pairwise, lane i tests ray i against shape i. Same cases as the
+//       scalar Intersects(shape, ray3, rayhit).
+inline r32x4 Intersects(const aabbx4 &bb, const ray3x4 &r, rayhitx4 &hit, r32 maxT = FLT_MAX)
+{
+    vec3x4 t0 = Hadamard(bb.min - r.origin, r.invDirection),
+           t1 = Hadamard(bb.max - r.origin, r.invDirection);
+
+    r32x4 zero = R32x4(0.0f),
+          one = R32x4(1.0f),
+          tNear = zero,
+          tFar = R32x4(FLT_MAX);
+
+    r32x4 negX = r.invDirection.x < zero,
+          negY = r.invDirection.y < zero,
+          negZ = r.invDirection.z < zero;
+
+    // NOTE: The normal of the slab entered last, NaN slabs never compare greater
+    r32x4 nearX = Select(negX, t1.x, t0.x),
+          nearY = Select(negY, t1.y, t0.y),
+          nearZ = Select(negZ, t1.z, t0.z);
+
+    r32x4 enterX = nearX > tNear;
+    tNear = Select(enterX, nearX, tNear);
+    r32x4 enterY = nearY > tNear;
+    tNear = Select(enterY, nearY, tNear);
+    r32x4 enterZ = nearZ > tNear;
+    tNear = Select(enterZ, nearZ, tNear);
+
+    enterX = AndNot(enterY | enterZ, enterX);
+    enterY = AndNot(enterZ, enterY);
+
+    hit.normal = Vec3x4(Select(enterX, Select(negX, one, -one), zero),
+                        Select(enterY, Select(negY, one, -one), zero),
+                        Select(enterZ, Select(negZ, one, -one), zero));
+
+    tFar = Min(Select(negX, t0.x, t1.x), tFar);
+    tFar = Min(Select(negY, t0.y, t1.y), tFar);
+    tFar = Min(Select(negZ, t0.z, t1.z), tFar);
+
+    hit.tEntry = tNear;
+    hit.tExit = tFar;
+    hit.point = r.origin + tNear * r.direction;
+
+    return (tNear <= tFar) & (tNear <= R32x4(maxT));
+}
+
+inline r32x4 Intersects(const spherex4 &s, const ray3x4 &r, rayhitx4 &hit, r32 maxT = FLT_MAX)
+{
+    vec3x4 w = s.origin - r.origin;
+
+    r32x4 zero = R32x4(0.0f),
+          a = LengthSq(r.direction),
+          b = Dot(w, r.direction),
+          c = LengthSq(w) - s.radius * s.radius,
+          disc = b * b - a * c,
+          root = Sqrt(Max(disc, zero)),
+          recipA = 1.0f / a,
+          t0 = (b - root) * recipA,
+          t1 = (b + root) * recipA;
+
+    r32x4 outside = t0 >= zero;
+
+    hit.tEntry = Select(outside, t0, zero);
+    hit.tExit = t1;
+    hit.point = r.origin + hit.tEntry * r.direction;
+    hit.normal = Select(outside, (hit.point - s.origin) * (1.0f / s.radius), Vec3x4(VEC3_ZERO));
+
+    return (disc >= zero) & (a != zero) & (t1 >= zero) & (t0 <= R32x4(maxT));
+}
+
+inline r32x4 Intersects(const planex4 &p, const ray3x4 &r, rayhitx4 &hit, r32 maxT = FLT_MAX)
+{
+    r32x4 denom = Dot(p.normal, r.direction),
+          t = -(Dot(p.normal, r.origin) + p.offset) / denom;
+
+    hit.tEntry = t;
+    hit.tExit = t;
+    hit.point = r.origin + t * r.direction;
+    hit.normal = Select(denom > R32x4(0.0f), -p.normal, p.normal);
+
+    return (t >= R32x4(0.0f)) & (t <= R32x4(maxT));
+}
+
+inline void ClearHits(const rayhitbuffer &out, u32 count)
+{
+    AAM_Assert(out.hits && out.tEntry);
+
+    for(u32 i = 0; i < (count + 31) / 32; ++i)
+    {
+        out.hits[i] = 0;
+    }
+}
+
+// NOTE: Writes elements first..first+3, first is a multiple of 4
+inline void Store(const rayhitbuffer &out, u32 first, const rayhitx4 &hit, const r32x4 &mask)
+{
+    r32x4 miss = R32x4(FLT_MAX);
+
+    Store(out.tEntry + first, Select(mask, hit.tEntry, miss));
+
+    if(out.tExit)
+        Store(out.tExit + first, Select(mask, hit.tExit, miss));
+
+    if(out.pointX)
+    {
+        Store(out.pointX + first, hit.point.x);
+        Store(out.pointY + first, hit.point.y);
+        Store(out.pointZ + first, hit.point.z);
+    }
+
+    if(out.normalX)
+    {
+        Store(out.normalX + first, hit.normal.x);
+        Store(out.normalY + first, hit.normal.y);
+        Store(out.normalZ + first, hit.normal.z);
+    }
+
+    out.hits[first >> 5] |= MoveMask(mask) << (first & 31);
+}
+
+inline void Store(const rayhitbuffer &out, u32 i, const rayhit &hit, b32 isHit)
+{
+    out.tEntry[i] = isHit ? hit.tEntry : FLT_MAX;
+
+    if(out.tExit)
+        out.tExit[i] = isHit ? hit.tExit : FLT_MAX;
+
+    if(isHit)
+    {
+        if(out.pointX)
+        {
+            out.pointX[i] = hit.point.x;
+            out.pointY[i] = hit.point.y;
+            out.pointZ[i] = hit.point.z;
+        }
+
+        if(out.normalX)
+        {
+            out.normalX[i] = hit.normal.x;
+            out.normalY[i] = hit.normal.y;
+            out.normalZ[i] = hit.normal.z;
+        }
+
+        out.hits[i >> 5] |= 1 << (i & 31);
+    }
+}
+
+// NOTE: rays[i] against boxes[i], 4 pairs at a time
+inline void IntersectBatch(const aabb *boxes, const ray3 *rays, u32 count,
+                           const rayhitbuffer &out, r32 maxT = FLT_MAX)
+{
+    ClearHits(out, count);
+
+    u32 i = 0;
+    for(; i + 4 <= count; i += 4)
+    {
+        rayhitx4 hit;
+        r32x4 mask = Intersects(LoadAABBx4(boxes + i), LoadRay3x4(rays + i), hit, maxT);
+
+        Store(out, i, hit, mask);
+    }
+    for(; i < count; ++i)
+    {
+        rayhit hit;
+        b32 isHit = Intersects(boxes[i], rays[i], hit, maxT);
+
+        Store(out, i, hit, isHit);
+    }
+}
+
+inline void IntersectBatch(const sphere *spheres, const ray3 *rays, u32 count,
+                           const rayhitbuffer &out, r32 maxT = FLT_MAX)
+{
+    ClearHits(out, count);
+
+    u32 i = 0;
+    for(; i + 4 <= count; i += 4)
+    {
+        rayhitx4 hit;
+        r32x4 mask = Intersects(LoadSpherex4(spheres + i), LoadRay3x4(rays + i), hit, maxT);
+
+        Store(out, i, hit, mask);
+    }
+    for(; i < count; ++i)
+    {
+        rayhit hit;
+        b32 isHit = Intersects(spheres[i], rays[i], hit, maxT);
+
+        Store(out, i, hit, isHit);
+    }
+}
+
+inline void IntersectBatch(const plane *planes, const ray3 *rays, u32 count,
+                           const rayhitbuffer &out, r32 maxT = FLT_MAX)
+{
+    ClearHits(out, count);
+
+    u32 i = 0;
+    for(; i + 4 <= count; i += 4)
+    {
+        rayhitx4 hit;
+        r32x4 mask = Intersects(LoadPlanex4(planes + i), LoadRay3x4(rays + i), hit, maxT);
+
+        Store(out, i, hit, mask);
+    }
+    for(; i < count; ++i)
+    {
+        rayhit hit;
+        b32 isHit = Intersects(planes[i], rays[i], hit, maxT);
+
+        Store(out, i, hit, isHit);
+    }
+}
+
+inline void IntersectBatch(const triangle *triangles, const ray3 *rays, u32 count,
+                           const rayhitbuffer &out, r32 maxT = FLT_MAX)
+{
+    ClearHits(out, count);
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        rayhit hit;
+        b32 isHit = Intersects(triangles[i], rays[i], hit, maxT);
+
+        Store(out, i, hit, isHit);
+    }
+}
+
+} // NOTE: Namespace
+
+#endif
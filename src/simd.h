@@ -0,0 +1,1442 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include "aamath.h"
+
+namespace aam
+{
+
+// NOTE: Lane types for the SoA ("wide") math in wide.h.
+//       r32x4 maps to SSE, r32x8 to AVX (or a pair of r32x4 without AAMATH_AVX2),
+//       both fall back to plain arrays when no backend is selected.
+//
+//       Comparisons return lane masks (all bits set or clear), which feed
+//       Select, MoveMask and the bitwise operators.
+
+typedef union _r32x4
+{
+#if defined(AAMATH_SSE4)
+    __m128 m;
+#endif
+    r32 E[4];
+    u32 U[4];
+} r32x4;
+
+typedef union _r32x8
+{
+#if defined(AAMATH_AVX2)
+    __m256 m;
+#else
+    r32x4 h[2];
+#endif
+    r32 E[8];
+    u32 U[8];
+} r32x8;
+
+//
+// NOTE: r32x4
+//
+
+inline r32x4 R32x4(r32 x)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_set1_ps(x);
+#else
+    result.E[0] = x;
+    result.E[1] = x;
+    result.E[2] = x;
+    result.E[3] = x;
+#endif
+
+    return result;
+}
+
+inline r32x4 R32x4(r32 a, r32 b, r32 c, r32 d)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_setr_ps(a, b, c, d);
+#else
+    result.E[0] = a;
+    result.E[1] = b;
+    result.E[2] = c;
+    result.E[3] = d;
+#endif
+
+    return result;
+}
+
+// NOTE: Unaligned load/store of 4 consecutive floats
+inline r32x4 LoadR32x4(const r32 *src)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_loadu_ps(src);
+#else
+    result.E[0] = src[0];
+    result.E[1] = src[1];
+    result.E[2] = src[2];
+    result.E[3] = src[3];
+#endif
+
+    return result;
+}
+
+inline void Store(r32 *dst, const r32x4 &v)
+{
+#if defined(AAMATH_SSE4)
+    _mm_storeu_ps(dst, v.m);
+#else
+    dst[0] = v.E[0];
+    dst[1] = v.E[1];
+    dst[2] = v.E[2];
+    dst[3] = v.E[3];
+#endif
+}
+
+// NOTE: Stores the first count lanes (all 4 when count >= 4)
+inline void Store(r32 *dst, const r32x4 &v, u32 count)
+{
+    if(count >= 4)
+    {
+        Store(dst, v);
+        return;
+    }
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        dst[i] = v.E[i];
+    }
+}
+
+// NOTE: Loads the first count (1 to 4) floats, the remaining lanes repeat the
+//       last one so they stay valid inputs (e.g. for the tail of a batch)
+inline r32x4 LoadR32x4(const r32 *src, u32 count)
+{
+    AAM_Assert(count > 0);
+
+    if(count >= 4)
+        return LoadR32x4(src);
+
+    r32x4 result;
+
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.E[i] = src[(i < count) ? i : count - 1];
+    }
+
+    return result;
+}
+
+//
+// NOTE: r32x4 operators
+//
+
+inline r32x4 operator-(const r32x4 &a)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_xor_ps(a.m, _mm_set1_ps(-0.0f));
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.E[i] = -a.E[i];
+    }
+#endif
+
+    return result;
+}
+
+inline r32x4 operator+(const r32x4 &a, const r32x4 &b)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_add_ps(a.m, b.m);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.E[i] = a.E[i] + b.E[i];
+    }
+#endif
+
+    return result;
+}
+
+inline r32x4 operator-(const r32x4 &a, const r32x4 &b)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_sub_ps(a.m, b.m);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.E[i] = a.E[i] - b.E[i];
+    }
+#endif
+
+    return result;
+}
+
+inline r32x4 operator*(const r32x4 &a, const r32x4 &b)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_mul_ps(a.m, b.m);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.E[i] = a.E[i] * b.E[i];
+    }
+#endif
+
+    return result;
+}
+
+inline r32x4 operator/(const r32x4 &a, const r32x4 &b)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_div_ps(a.m, b.m);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.E[i] = a.E[i] / b.E[i];
+    }
+#endif
+
+    return result;
+}
+
+inline r32x4 operator+(const r32x4 &a, r32 b)
+{
+    return a + R32x4(b);
+}
+
+inline r32x4 operator+(r32 a, const r32x4 &b)
+{
+    return R32x4(a) + b;
+}
+
+inline r32x4 operator-(const r32x4 &a, r32 b)
+{
+    return a - R32x4(b);
+}
+
+inline r32x4 operator-(r32 a, const r32x4 &b)
+{
+    return R32x4(a) - b;
+}
+
+inline r32x4 operator*(const r32x4 &a, r32 b)
+{
+    return a * R32x4(b);
+}
+
+inline r32x4 operator*(r32 a, const r32x4 &b)
+{
+    return R32x4(a) * b;
+}
+
+inline r32x4 operator/(const r32x4 &a, r32 b)
+{
+    return a / R32x4(b);
+}
+
+inline r32x4 operator/(r32 a, const r32x4 &b)
+{
+    return R32x4(a) / b;
+}
+
+inline r32x4 &operator+=(r32x4 &a, const r32x4 &b)
+{
+    a = a + b;
+
+    return a;
+}
+
+inline r32x4 &operator-=(r32x4 &a, const r32x4 &b)
+{
+    a = a - b;
+
+    return a;
+}
+
+inline r32x4 &operator*=(r32x4 &a, const r32x4 &b)
+{
+    a = a * b;
+
+    return a;
+}
+
+inline r32x4 &operator/=(r32x4 &a, const r32x4 &b)
+{
+    a = a / b;
+
+    return a;
+}
+
+inline r32x4 operator<(const r32x4 &a, const r32x4 &b)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_cmplt_ps(a.m, b.m);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.U[i] = (a.E[i] < b.E[i]) ? 0xFFFFFFFF : 0;
+    }
+#endif
+
+    return result;
+}
+
+inline r32x4 operator<=(const r32x4 &a, const r32x4 &b)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_cmple_ps(a.m, b.m);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.U[i] = (a.E[i] <= b.E[i]) ? 0xFFFFFFFF : 0;
+    }
+#endif
+
+    return result;
+}
+
+inline r32x4 operator>(const r32x4 &a, const r32x4 &b)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_cmpgt_ps(a.m, b.m);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.U[i] = (a.E[i] > b.E[i]) ? 0xFFFFFFFF : 0;
+    }
+#endif
+
+    return result;
+}
+
+inline r32x4 operator>=(const r32x4 &a, const r32x4 &b)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_cmpge_ps(a.m, b.m);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.U[i] = (a.E[i] >= b.E[i]) ? 0xFFFFFFFF : 0;
+    }
+#endif
+
+    return result;
+}
+
+inline r32x4 operator==(const r32x4 &a, const r32x4 &b)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_cmpeq_ps(a.m, b.m);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.U[i] = (a.E[i] == b.E[i]) ? 0xFFFFFFFF : 0;
+    }
+#endif
+
+    return result;
+}
+
+inline r32x4 operator!=(const r32x4 &a, const r32x4 &b)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_cmpneq_ps(a.m, b.m);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.U[i] = (a.E[i] != b.E[i]) ? 0xFFFFFFFF : 0;
+    }
+#endif
+
+    return result;
+}
+
+inline r32x4 operator&(const r32x4 &a, const r32x4 &b)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_and_ps(a.m, b.m);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.U[i] = a.U[i] & b.U[i];
+    }
+#endif
+
+    return result;
+}
+
+inline r32x4 operator|(const r32x4 &a, const r32x4 &b)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_or_ps(a.m, b.m);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.U[i] = a.U[i] | b.U[i];
+    }
+#endif
+
+    return result;
+}
+
+inline r32x4 operator^(const r32x4 &a, const r32x4 &b)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_xor_ps(a.m, b.m);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.U[i] = a.U[i] ^ b.U[i];
+    }
+#endif
+
+    return result;
+}
+
+//
+// NOTE: r32x4 functions
+//
+
+// NOTE: ~a & b
+inline r32x4 AndNot(const r32x4 &a, const r32x4 &b)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_andnot_ps(a.m, b.m);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.U[i] = ~a.U[i] & b.U[i];
+    }
+#endif
+
+    return result;
+}
+
+inline r32x4 Min(const r32x4 &a, const r32x4 &b)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_min_ps(a.m, b.m);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.E[i] = Min(a.E[i], b.E[i]);
+    }
+#endif
+
+    return result;
+}
+
+inline r32x4 Max(const r32x4 &a, const r32x4 &b)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_max_ps(a.m, b.m);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.E[i] = Max(a.E[i], b.E[i]);
+    }
+#endif
+
+    return result;
+}
+
+inline r32x4 Abs(const r32x4 &a)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_andnot_ps(_mm_set1_ps(-0.0f), a.m);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.U[i] = a.U[i] & 0x7FFFFFFF;
+    }
+#endif
+
+    return result;
+}
+
+inline r32x4 Floor(const r32x4 &a)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_floor_ps(a.m);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.E[i] = floorf(a.E[i]);
+    }
+#endif
+
+    return result;
+}
+
+inline r32x4 Sqrt(const r32x4 &a)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_sqrt_ps(a.m);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.E[i] = sqrtf(a.E[i]);
+    }
+#endif
+
+    return result;
+}
+
+inline r32x4 InvSqrt(const r32x4 &a)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+#if defined(AAMATH_APPROXIMATE)
+    // NOTE: Estimate plus one Newton-Raphson step
+    __m128 y = _mm_rsqrt_ps(a.m);
+    __m128 yy = _mm_mul_ps(_mm_mul_ps(a.m, y), y);
+    result.m = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), y), _mm_sub_ps(_mm_set1_ps(3.0f), yy));
+#else
+    result.m = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(a.m));
+#endif
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.E[i] = InvSqrt(a.E[i]);
+    }
+#endif
+
+    return result;
+}
+
+// NOTE: Hardware estimate plus one Newton-Raphson step (about 22 bits), for
+//       renormalising where the exact divide and square root would dominate.
+//       Exact without a SIMD backend.
+inline r32x4 ApproxInvSqrt(const r32x4 &a)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    __m128 y = _mm_rsqrt_ps(a.m);
+    __m128 yy = _mm_mul_ps(_mm_mul_ps(a.m, y), y);
+    result.m = _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), y), _mm_sub_ps(_mm_set1_ps(3.0f), yy));
+#else
+    result = InvSqrt(a);
+#endif
+
+    return result;
+}
+
+inline r32x4 Clamp(const r32x4 &x, const r32x4 &min, const r32x4 &max)
+{
+    return Min(Max(x, min), max);
+}
+
+inline r32x4 Clamp01(const r32x4 &x)
+{
+    return Clamp(x, R32x4(0.0f), R32x4(1.0f));
+}
+
+// NOTE: a * b + c
+inline r32x4 MulAdd(const r32x4 &a, const r32x4 &b, const r32x4 &c)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = MulAdd(a.m, b.m, c.m);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.E[i] = a.E[i] * b.E[i] + c.E[i];
+    }
+#endif
+
+    return result;
+}
+
+// NOTE: Per lane mask ? a : b
+inline r32x4 Select(const r32x4 &mask, const r32x4 &a, const r32x4 &b)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_blendv_ps(b.m, a.m, mask.m);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.U[i] = (mask.U[i] & a.U[i]) | (~mask.U[i] & b.U[i]);
+    }
+#endif
+
+    return result;
+}
+
+// NOTE: (a0, a2, b0, b2), e.g. to split interleaved min/max pairs
+inline r32x4 EvenLanes(const r32x4 &a, const r32x4 &b)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_shuffle_ps(a.m, b.m, _MM_SHUFFLE(2, 0, 2, 0));
+#else
+    result = R32x4(a.E[0], a.E[2], b.E[0], b.E[2]);
+#endif
+
+    return result;
+}
+
+// NOTE: (a1, a3, b1, b3)
+inline r32x4 OddLanes(const r32x4 &a, const r32x4 &b)
+{
+    r32x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.m = _mm_shuffle_ps(a.m, b.m, _MM_SHUFFLE(3, 1, 3, 1));
+#else
+    result = R32x4(a.E[1], a.E[3], b.E[1], b.E[3]);
+#endif
+
+    return result;
+}
+
+// NOTE: Sign bit of each lane packed into the low 4 bits
+inline u32 MoveMask(const r32x4 &a)
+{
+#if defined(AAMATH_SSE4)
+    return (u32)_mm_movemask_ps(a.m);
+#else
+    return ((a.U[0] >> 31)
+            | ((a.U[1] >> 31) << 1)
+            | ((a.U[2] >> 31) << 2)
+            | ((a.U[3] >> 31) << 3));
+#endif
+}
+
+inline b32 Any(const r32x4 &mask)
+{
+    return MoveMask(mask) != 0;
+}
+
+inline b32 All(const r32x4 &mask)
+{
+    return MoveMask(mask) == 0xF;
+}
+
+//
+// NOTE: r32x8
+//
+
+inline r32x8 R32x8(r32 x)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_set1_ps(x);
+#else
+    result.h[0] = R32x4(x);
+    result.h[1] = R32x4(x);
+#endif
+
+    return result;
+}
+
+inline r32x8 R32x8(const r32x4 &lo, const r32x4 &hi)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_insertf128_ps(_mm256_castps128_ps256(lo.m), hi.m, 1);
+#else
+    result.h[0] = lo;
+    result.h[1] = hi;
+#endif
+
+    return result;
+}
+
+inline r32x4 Low(const r32x8 &v)
+{
+    r32x4 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_castps256_ps128(v.m);
+#else
+    result = v.h[0];
+#endif
+
+    return result;
+}
+
+inline r32x4 High(const r32x8 &v)
+{
+    r32x4 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_extractf128_ps(v.m, 1);
+#else
+    result = v.h[1];
+#endif
+
+    return result;
+}
+
+// NOTE: Unaligned load/store of 8 consecutive floats
+inline r32x8 LoadR32x8(const r32 *src)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_loadu_ps(src);
+#else
+    result.h[0] = LoadR32x4(src);
+    result.h[1] = LoadR32x4(src + 4);
+#endif
+
+    return result;
+}
+
+inline void Store(r32 *dst, const r32x8 &v)
+{
+#if defined(AAMATH_AVX2)
+    _mm256_storeu_ps(dst, v.m);
+#else
+    Store(dst, v.h[0]);
+    Store(dst + 4, v.h[1]);
+#endif
+}
+
+// NOTE: Stores the first count lanes (all 8 when count >= 8)
+inline void Store(r32 *dst, const r32x8 &v, u32 count)
+{
+    if(count >= 8)
+    {
+        Store(dst, v);
+        return;
+    }
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        dst[i] = v.E[i];
+    }
+}
+
+//
+// NOTE: r32x8 operators
+//
+
+inline r32x8 operator-(const r32x8 &a)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_xor_ps(a.m, _mm256_set1_ps(-0.0f));
+#else
+    result.h[0] = -a.h[0];
+    result.h[1] = -a.h[1];
+#endif
+
+    return result;
+}
+
+inline r32x8 operator+(const r32x8 &a, const r32x8 &b)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_add_ps(a.m, b.m);
+#else
+    result.h[0] = a.h[0] + b.h[0];
+    result.h[1] = a.h[1] + b.h[1];
+#endif
+
+    return result;
+}
+
+inline r32x8 operator-(const r32x8 &a, const r32x8 &b)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_sub_ps(a.m, b.m);
+#else
+    result.h[0] = a.h[0] - b.h[0];
+    result.h[1] = a.h[1] - b.h[1];
+#endif
+
+    return result;
+}
+
+inline r32x8 operator*(const r32x8 &a, const r32x8 &b)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_mul_ps(a.m, b.m);
+#else
+    result.h[0] = a.h[0] * b.h[0];
+    result.h[1] = a.h[1] * b.h[1];
+#endif
+
+    return result;
+}
+
+inline r32x8 operator/(const r32x8 &a, const r32x8 &b)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_div_ps(a.m, b.m);
+#else
+    result.h[0] = a.h[0] / b.h[0];
+    result.h[1] = a.h[1] / b.h[1];
+#endif
+
+    return result;
+}
+
+inline r32x8 operator+(const r32x8 &a, r32 b)
+{
+    return a + R32x8(b);
+}
+
+inline r32x8 operator+(r32 a, const r32x8 &b)
+{
+    return R32x8(a) + b;
+}
+
+inline r32x8 operator-(const r32x8 &a, r32 b)
+{
+    return a - R32x8(b);
+}
+
+inline r32x8 operator-(r32 a, const r32x8 &b)
+{
+    return R32x8(a) - b;
+}
+
+inline r32x8 operator*(const r32x8 &a, r32 b)
+{
+    return a * R32x8(b);
+}
+
+inline r32x8 operator*(r32 a, const r32x8 &b)
+{
+    return R32x8(a) * b;
+}
+
+inline r32x8 operator/(const r32x8 &a, r32 b)
+{
+    return a / R32x8(b);
+}
+
+inline r32x8 operator/(r32 a, const r32x8 &b)
+{
+    return R32x8(a) / b;
+}
+
+inline r32x8 &operator+=(r32x8 &a, const r32x8 &b)
+{
+    a = a + b;
+
+    return a;
+}
+
+inline r32x8 &operator-=(r32x8 &a, const r32x8 &b)
+{
+    a = a - b;
+
+    return a;
+}
+
+inline r32x8 &operator*=(r32x8 &a, const r32x8 &b)
+{
+    a = a * b;
+
+    return a;
+}
+
+inline r32x8 &operator/=(r32x8 &a, const r32x8 &b)
+{
+    a = a / b;
+
+    return a;
+}
+
+inline r32x8 operator<(const r32x8 &a, const r32x8 &b)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_cmp_ps(a.m, b.m, _CMP_LT_OQ);
+#else
+    result.h[0] = a.h[0] < b.h[0];
+    result.h[1] = a.h[1] < b.h[1];
+#endif
+
+    return result;
+}
+
+inline r32x8 operator<=(const r32x8 &a, const r32x8 &b)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_cmp_ps(a.m, b.m, _CMP_LE_OQ);
+#else
+    result.h[0] = a.h[0] <= b.h[0];
+    result.h[1] = a.h[1] <= b.h[1];
+#endif
+
+    return result;
+}
+
+inline r32x8 operator>(const r32x8 &a, const r32x8 &b)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_cmp_ps(a.m, b.m, _CMP_GT_OQ);
+#else
+    result.h[0] = a.h[0] > b.h[0];
+    result.h[1] = a.h[1] > b.h[1];
+#endif
+
+    return result;
+}
+
+inline r32x8 operator>=(const r32x8 &a, const r32x8 &b)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_cmp_ps(a.m, b.m, _CMP_GE_OQ);
+#else
+    result.h[0] = a.h[0] >= b.h[0];
+    result.h[1] = a.h[1] >= b.h[1];
+#endif
+
+    return result;
+}
+
+inline r32x8 operator==(const r32x8 &a, const r32x8 &b)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_cmp_ps(a.m, b.m, _CMP_EQ_OQ);
+#else
+    result.h[0] = a.h[0] == b.h[0];
+    result.h[1] = a.h[1] == b.h[1];
+#endif
+
+    return result;
+}
+
+inline r32x8 operator!=(const r32x8 &a, const r32x8 &b)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_cmp_ps(a.m, b.m, _CMP_NEQ_UQ);
+#else
+    result.h[0] = a.h[0] != b.h[0];
+    result.h[1] = a.h[1] != b.h[1];
+#endif
+
+    return result;
+}
+
+inline r32x8 operator&(const r32x8 &a, const r32x8 &b)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_and_ps(a.m, b.m);
+#else
+    result.h[0] = a.h[0] & b.h[0];
+    result.h[1] = a.h[1] & b.h[1];
+#endif
+
+    return result;
+}
+
+inline r32x8 operator|(const r32x8 &a, const r32x8 &b)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_or_ps(a.m, b.m);
+#else
+    result.h[0] = a.h[0] | b.h[0];
+    result.h[1] = a.h[1] | b.h[1];
+#endif
+
+    return result;
+}
+
+inline r32x8 operator^(const r32x8 &a, const r32x8 &b)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_xor_ps(a.m, b.m);
+#else
+    result.h[0] = a.h[0] ^ b.h[0];
+    result.h[1] = a.h[1] ^ b.h[1];
+#endif
+
+    return result;
+}
+
+//
+// NOTE: r32x8 functions
+//
+
+// NOTE: ~a & b
+inline r32x8 AndNot(const r32x8 &a, const r32x8 &b)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_andnot_ps(a.m, b.m);
+#else
+    result.h[0] = AndNot(a.h[0], b.h[0]);
+    result.h[1] = AndNot(a.h[1], b.h[1]);
+#endif
+
+    return result;
+}
+
+inline r32x8 Min(const r32x8 &a, const r32x8 &b)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_min_ps(a.m, b.m);
+#else
+    result.h[0] = Min(a.h[0], b.h[0]);
+    result.h[1] = Min(a.h[1], b.h[1]);
+#endif
+
+    return result;
+}
+
+inline r32x8 Max(const r32x8 &a, const r32x8 &b)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_max_ps(a.m, b.m);
+#else
+    result.h[0] = Max(a.h[0], b.h[0]);
+    result.h[1] = Max(a.h[1], b.h[1]);
+#endif
+
+    return result;
+}
+
+inline r32x8 Abs(const r32x8 &a)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.m);
+#else
+    result.h[0] = Abs(a.h[0]);
+    result.h[1] = Abs(a.h[1]);
+#endif
+
+    return result;
+}
+
+inline r32x8 Floor(const r32x8 &a)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_floor_ps(a.m);
+#else
+    result.h[0] = Floor(a.h[0]);
+    result.h[1] = Floor(a.h[1]);
+#endif
+
+    return result;
+}
+
+inline r32x8 Sqrt(const r32x8 &a)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_sqrt_ps(a.m);
+#else
+    result.h[0] = Sqrt(a.h[0]);
+    result.h[1] = Sqrt(a.h[1]);
+#endif
+
+    return result;
+}
+
+inline r32x8 InvSqrt(const r32x8 &a)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+#if defined(AAMATH_APPROXIMATE)
+    __m256 y = _mm256_rsqrt_ps(a.m);
+    __m256 yy = _mm256_mul_ps(_mm256_mul_ps(a.m, y), y);
+    result.m = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), y), _mm256_sub_ps(_mm256_set1_ps(3.0f), yy));
+#else
+    result.m = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(a.m));
+#endif
+#else
+    result.h[0] = InvSqrt(a.h[0]);
+    result.h[1] = InvSqrt(a.h[1]);
+#endif
+
+    return result;
+}
+
+inline r32x8 ApproxInvSqrt(const r32x8 &a)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    __m256 y = _mm256_rsqrt_ps(a.m);
+    __m256 yy = _mm256_mul_ps(_mm256_mul_ps(a.m, y), y);
+    result.m = _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), y), _mm256_sub_ps(_mm256_set1_ps(3.0f), yy));
+#else
+    result.h[0] = ApproxInvSqrt(a.h[0]);
+    result.h[1] = ApproxInvSqrt(a.h[1]);
+#endif
+
+    return result;
+}
+
+inline r32x8 Clamp(const r32x8 &x, const r32x8 &min, const r32x8 &max)
+{
+    return Min(Max(x, min), max);
+}
+
+inline r32x8 Clamp01(const r32x8 &x)
+{
+    return Clamp(x, R32x8(0.0f), R32x8(1.0f));
+}
+
+// NOTE: a * b + c
+inline r32x8 MulAdd(const r32x8 &a, const r32x8 &b, const r32x8 &c)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = MulAdd(a.m, b.m, c.m);
+#else
+    result.h[0] = MulAdd(a.h[0], b.h[0], c.h[0]);
+    result.h[1] = MulAdd(a.h[1], b.h[1], c.h[1]);
+#endif
+
+    return result;
+}
+
+// NOTE: Per lane mask ? a : b
+inline r32x8 Select(const r32x8 &mask, const r32x8 &a, const r32x8 &b)
+{
+    r32x8 result;
+
+#if defined(AAMATH_AVX2)
+    result.m = _mm256_blendv_ps(b.m, a.m, mask.m);
+#else
+    result.h[0] = Select(mask.h[0], a.h[0], b.h[0]);
+    result.h[1] = Select(mask.h[1], a.h[1], b.h[1]);
+#endif
+
+    return result;
+}
+
+// NOTE: Sign bit of each lane packed into the low 8 bits
+inline u32 MoveMask(const r32x8 &a)
+{
+#if defined(AAMATH_AVX2)
+    return (u32)_mm256_movemask_ps(a.m);
+#else
+    return MoveMask(a.h[0]) | (MoveMask(a.h[1]) << 4);
+#endif
+}
+
+inline b32 Any(const r32x8 &mask)
+{
+    return MoveMask(mask) != 0;
+}
+
+inline b32 All(const r32x8 &mask)
+{
+    return MoveMask(mask) == 0xFF;
+}
+
+//
+// NOTE: Trig
+//
+
+// NOTE: sinf/cosf on the lanes outside inRange, kept out of SinCos so the
+//       common path stays small
+inline void SinCosFar(const r32x4 &angle, const r32x4 &inRange, r32x4 &s, r32x4 &c)
+{
+    r32 lanes[4], sLanes[4], cLanes[4];
+    u32 far = ~MoveMask(inRange);
+
+    Store(lanes, angle);
+    Store(sLanes, s);
+    Store(cLanes, c);
+
+    for(u32 i = 0; i < 4; ++i)
+    {
+        if(far & (1 << i))
+        {
+            sLanes[i] = sinf(lanes[i]);
+            cLanes[i] = cosf(lanes[i]);
+        }
+    }
+
+    s = LoadR32x4(sLanes);
+    c = LoadR32x4(cLanes);
+}
+
+// NOTE: Per lane SinCos, see the scalar version in aamath.h for the error bounds
+inline void SinCos(const r32x4 &angle, r32x4 &s, r32x4 &c)
+{
+    r32x4 signBit = R32x4(-0.0f);
+    r32x4 j = Floor(angle * TWOOVERPI + 0.5f);
+    r32x4 x = ((angle - j * AAM_PIO2_A) - j * AAM_PIO2_B) - j * AAM_PIO2_C;
+    r32x4 z = x * x;
+
+    r32x4 sx = MulAdd(x * z, MulAdd(z, MulAdd(z, R32x4(AAM_SIN_C2), R32x4(AAM_SIN_C1)), R32x4(AAM_SIN_C0)), x);
+    r32x4 cx = MulAdd(z * z, MulAdd(z, MulAdd(z, R32x4(AAM_COS_C2), R32x4(AAM_COS_C1)), R32x4(AAM_COS_C0)),
+                      1.0f - 0.5f * z);
+
+    // NOTE: Quadrant q = j mod 4 in [0, 3], swap sin/cos on odd quadrants
+    r32x4 q = j - 4.0f * Floor(j * 0.25f);
+    r32x4 swap = (q == R32x4(1.0f)) | (q == R32x4(3.0f));
+    r32x4 sinNegate = q >= R32x4(2.0f);
+    r32x4 cosNegate = (q == R32x4(1.0f)) | (q == R32x4(2.0f));
+
+    s = Select(swap, cx, sx) ^ (sinNegate & signBit);
+    c = Select(swap, sx, cx) ^ (cosNegate & signBit);
+
+    // NOTE: Lanes past AAM_TRIG_MAX_REDUCE (and NaNs) go to sinf/cosf
+    r32x4 inRange = Abs(angle) <= R32x4(AAM_TRIG_MAX_REDUCE);
+
+    if(!All(inRange))
+        SinCosFar(angle, inRange, s, c);
+}
+
+inline r32x4 Sin(const r32x4 &angle)
+{
+    r32x4 s, c;
+    SinCos(angle, s, c);
+    return s;
+}
+
+inline r32x4 Cos(const r32x4 &angle)
+{
+    r32x4 s, c;
+    SinCos(angle, s, c);
+    return c;
+}
+
+inline r32x4 Acos(const r32x4 &x)
+{
+    r32x4 xc = Clamp(x, R32x4(-1.0f), R32x4(1.0f));
+    r32x4 a = Abs(xc);
+    r32x4 big = a > R32x4(0.5f);
+
+    // NOTE: Both branches in one polynomial, z = (1 - a) / 2 and s = sqrt(z) above 0.5
+    r32x4 z = Select(big, 0.5f * (1.0f - a), xc * xc);
+    r32x4 s = Select(big, Sqrt(z), xc);
+    r32x4 p = MulAdd(z, MulAdd(z, MulAdd(z, MulAdd(z, R32x4(AAM_ASIN_C4), R32x4(AAM_ASIN_C3)),
+                                         R32x4(AAM_ASIN_C2)), R32x4(AAM_ASIN_C1)), R32x4(AAM_ASIN_C0));
+    r32x4 r = MulAdd(s * z, p, s);
+
+    r32x4 bigResult = Select(xc < R32x4(0.0f), PI - 2.0f * r, 2.0f * r);
+
+    return Select(big, bigResult, PIOVERTWO - r);
+}
+
+inline r32x4 Atan2(const r32x4 &y, const r32x4 &x)
+{
+    r32x4 signBit = R32x4(-0.0f);
+    r32x4 zero = R32x4(0.0f);
+    r32x4 ax = Abs(x),
+          ay = Abs(y),
+          hi = Max(ax, ay),
+          lo = Min(ax, ay);
+
+    // NOTE: atan(lo / hi) = pi/4 + atan((lo - hi) / (lo + hi)), taken above tan(pi/8)
+    r32x4 fold = lo > AAM_TANPIOVER8 * hi;
+    r32x4 r = Select(fold, (lo - hi) / (lo + hi), Select(hi > zero, lo / hi, zero));
+
+    r32x4 z = r * r;
+    r32x4 p = MulAdd(z, MulAdd(z, MulAdd(z, R32x4(AAM_ATAN_C3), R32x4(AAM_ATAN_C2)), R32x4(AAM_ATAN_C1)),
+                     R32x4(AAM_ATAN_C0));
+    r32x4 result = (fold & R32x4(PIOVERFOUR)) + MulAdd(r * z, p, r);
+
+    result = Select(ay > ax, PIOVERTWO - result, result);
+    // NOTE: copysign(1, x) < 0 gives a full lane mask, -0 included
+    result = Select(((x & signBit) | R32x4(1.0f)) < zero, PI - result, result);
+
+    return result | (y & signBit);
+}
+
+// NOTE: See the r32x4 SinCosFar
+inline void SinCosFar(const r32x8 &angle, const r32x8 &inRange, r32x8 &s, r32x8 &c)
+{
+    r32 lanes[8], sLanes[8], cLanes[8];
+    u32 far = ~MoveMask(inRange);
+
+    Store(lanes, angle);
+    Store(sLanes, s);
+    Store(cLanes, c);
+
+    for(u32 i = 0; i < 8; ++i)
+    {
+        if(far & (1 << i))
+        {
+            sLanes[i] = sinf(lanes[i]);
+            cLanes[i] = cosf(lanes[i]);
+        }
+    }
+
+    s = LoadR32x8(sLanes);
+    c = LoadR32x8(cLanes);
+}
+
+// NOTE: Per lane SinCos, see the scalar version in aamath.h for the error bounds
+inline void SinCos(const r32x8 &angle, r32x8 &s, r32x8 &c)
+{
+    r32x8 signBit = R32x8(-0.0f);
+    r32x8 j = Floor(angle * TWOOVERPI + 0.5f);
+    r32x8 x = ((angle - j * AAM_PIO2_A) - j * AAM_PIO2_B) - j * AAM_PIO2_C;
+    r32x8 z = x * x;
+
+    r32x8 sx = MulAdd(x * z, MulAdd(z, MulAdd(z, R32x8(AAM_SIN_C2), R32x8(AAM_SIN_C1)), R32x8(AAM_SIN_C0)), x);
+    r32x8 cx = MulAdd(z * z, MulAdd(z, MulAdd(z, R32x8(AAM_COS_C2), R32x8(AAM_COS_C1)), R32x8(AAM_COS_C0)),
+                      1.0f - 0.5f * z);
+
+    // NOTE: Quadrant q = j mod 4 in [0, 3], swap sin/cos on odd quadrants
+    r32x8 q = j - 4.0f * Floor(j * 0.25f);
+    r32x8 swap = (q == R32x8(1.0f)) | (q == R32x8(3.0f));
+    r32x8 sinNegate = q >= R32x8(2.0f);
+    r32x8 cosNegate = (q == R32x8(1.0f)) | (q == R32x8(2.0f));
+
+    s = Select(swap, cx, sx) ^ (sinNegate & signBit);
+    c = Select(swap, sx, cx) ^ (cosNegate & signBit);
+
+    // NOTE: Lanes past AAM_TRIG_MAX_REDUCE (and NaNs) go to sinf/cosf
+    r32x8 inRange = Abs(angle) <= R32x8(AAM_TRIG_MAX_REDUCE);
+
+    if(!All(inRange))
+        SinCosFar(angle, inRange, s, c);
+}
+
+inline r32x8 Sin(const r32x8 &angle)
+{
+    r32x8 s, c;
+    SinCos(angle, s, c);
+    return s;
+}
+
+inline r32x8 Cos(const r32x8 &angle)
+{
+    r32x8 s, c;
+    SinCos(angle, s, c);
+    return c;
+}
+
+inline r32x8 Acos(const r32x8 &x)
+{
+    r32x8 xc = Clamp(x, R32x8(-1.0f), R32x8(1.0f));
+    r32x8 a = Abs(xc);
+    r32x8 big = a > R32x8(0.5f);
+
+    // NOTE: Both branches in one polynomial, z = (1 - a) / 2 and s = sqrt(z) above 0.5
+    r32x8 z = Select(big, 0.5f * (1.0f - a), xc * xc);
+    r32x8 s = Select(big, Sqrt(z), xc);
+    r32x8 p = MulAdd(z, MulAdd(z, MulAdd(z, MulAdd(z, R32x8(AAM_ASIN_C4), R32x8(AAM_ASIN_C3)),
+                                         R32x8(AAM_ASIN_C2)), R32x8(AAM_ASIN_C1)), R32x8(AAM_ASIN_C0));
+    r32x8 r = MulAdd(s * z, p, s);
+
+    r32x8 bigResult = Select(xc < R32x8(0.0f), PI - 2.0f * r, 2.0f * r);
+
+    return Select(big, bigResult, PIOVERTWO - r);
+}
+
+inline r32x8 Atan2(const r32x8 &y, const r32x8 &x)
+{
+    r32x8 signBit = R32x8(-0.0f);
+    r32x8 zero = R32x8(0.0f);
+    r32x8 ax = Abs(x),
+          ay = Abs(y),
+          hi = Max(ax, ay),
+          lo = Min(ax, ay);
+
+    // NOTE: atan(lo / hi) = pi/4 + atan((lo - hi) / (lo + hi)), taken above tan(pi/8)
+    r32x8 fold = lo > AAM_TANPIOVER8 * hi;
+    r32x8 r = Select(fold, (lo - hi) / (lo + hi), Select(hi > zero, lo / hi, zero));
+
+    r32x8 z = r * r;
+    r32x8 p = MulAdd(z, MulAdd(z, MulAdd(z, R32x8(AAM_ATAN_C3), R32x8(AAM_ATAN_C2)), R32x8(AAM_ATAN_C1)),
+                     R32x8(AAM_ATAN_C0));
+    r32x8 result = (fold & R32x8(PIOVERFOUR)) + MulAdd(r * z, p, r);
+
+    result = Select(ay > ax, PIOVERTWO - result, result);
+    // NOTE: copysign(1, x) < 0 gives a full lane mask, -0 included
+    result = Select(((x & signBit) | R32x8(1.0f)) < zero, PI - result, result);
+
+    return result | (y & signBit);
+}
+
+} // NOTE: Namespace
+
+#endif
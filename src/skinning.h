@@ -0,0 +1,200 @@
+#ifndef SKINNING_H
+#define SKINNING_H
+
+#include "aamath.h"
+#include "vec3.h"
+#include "mat4.h"
+#include "dualquat.h"
+#include "wide.h"
+
+namespace aam
+{
+
+// NOTE: Batched vertex skinning with up to 4 bone influences per vertex.
+//       Unused influences must have weight 0 and a valid bone index (e.g. 0),
+//       all four are always read so the loops stay branch-free.
+//       The palettes hold the final skinning transforms (bone * inverse bind).
+//       Normals go through the blended rotation/matrix without the inverse
+//       transpose, so non-uniform bone scale skews them.
+//       Normals are optional: pass 0 for both normal pointers.
+
+#define SKIN_MAX_WEIGHTS 4
+
+typedef struct _skinweights
+{
+    u16 bones[SKIN_MAX_WEIGHTS];
+    r32 weights[SKIN_MAX_WEIGHTS];
+} skinweights;
+
+//
+// NOTE: Linear blend skinning, matrix palette
+//
+
+// NOTE: Weighted sum of the bone matrices (the w column is not blended)
+inline mat4 BlendMatrices(const mat4 *palette, const skinweights &sw)
+{
+    mat4 result;
+
+    const mat4 &m0 = palette[sw.bones[0]],
+               &m1 = palette[sw.bones[1]],
+               &m2 = palette[sw.bones[2]],
+               &m3 = palette[sw.bones[3]];
+    r32 w0 = sw.weights[0],
+        w1 = sw.weights[1],
+        w2 = sw.weights[2],
+        w3 = sw.weights[3];
+
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.v[i] = m0.v[i] * w0 + m1.v[i] * w1 + m2.v[i] * w2 + m3.v[i] * w3;
+    }
+
+    return result;
+}
+
+inline void SkinLinear(const mat4 *palette, const skinweights *weights,
+                       const vec3 *positions, const vec3 *normals,
+                       vec3 *outPositions, vec3 *outNormals, u32 count)
+{
+    AAM_Assert(palette && weights && positions && outPositions);
+    AAM_Assert((normals == 0) == (outNormals == 0));
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        const skinweights &sw = weights[i];
+
+#if defined(AAMATH_SSE4)
+        const mat4 &m0 = palette[sw.bones[0]],
+                   &m1 = palette[sw.bones[1]],
+                   &m2 = palette[sw.bones[2]],
+                   &m3 = palette[sw.bones[3]];
+        __m128 w0 = _mm_set1_ps(sw.weights[0]),
+               w1 = _mm_set1_ps(sw.weights[1]),
+               w2 = _mm_set1_ps(sw.weights[2]),
+               w3 = _mm_set1_ps(sw.weights[3]);
+        __m128 rows[4];
+
+        for(u32 r = 0; r < 4; ++r)
+        {
+            __m128 row = _mm_mul_ps(_mm_loadu_ps(m0.v[r].E), w0);
+            row = MulAdd(_mm_loadu_ps(m1.v[r].E), w1, row);
+            row = MulAdd(_mm_loadu_ps(m2.v[r].E), w2, row);
+            rows[r] = MulAdd(_mm_loadu_ps(m3.v[r].E), w3, row);
+        }
+
+        const vec3 &p = positions[i];
+        __m128 result = MulAdd(rows[0], _mm_set1_ps(p.x),
+                        MulAdd(rows[1], _mm_set1_ps(p.y),
+                        MulAdd(rows[2], _mm_set1_ps(p.z), rows[3])));
+
+        // NOTE: The w lane would land on the next vertex, store it separately
+        _mm_store_ss(&outPositions[i].x, result);
+        _mm_store_ss(&outPositions[i].y, _mm_shuffle_ps(result, result, _MM_SHUFFLE(1, 1, 1, 1)));
+        _mm_store_ss(&outPositions[i].z, _mm_movehl_ps(result, result));
+
+        if(normals)
+        {
+            const vec3 &n = normals[i];
+            __m128 normal = MulAdd(rows[0], _mm_set1_ps(n.x),
+                            MulAdd(rows[1], _mm_set1_ps(n.y),
+                                   _mm_mul_ps(rows[2], _mm_set1_ps(n.z))));
+
+            _mm_store_ss(&outNormals[i].x, normal);
+            _mm_store_ss(&outNormals[i].y, _mm_shuffle_ps(normal, normal, _MM_SHUFFLE(1, 1, 1, 1)));
+            _mm_store_ss(&outNormals[i].z, _mm_movehl_ps(normal, normal));
+        }
+#else
+        mat4 m = BlendMatrices(palette, sw);
+
+        outPositions[i] = TransformPoint(m, positions[i]);
+
+        if(normals)
+            outNormals[i] = TransformDirection(m, normals[i]);
+#endif
+    }
+}
+
+inline void SkinLinear(const mat4 *palette, const skinweights *weights,
+                       const vec3 *positions, vec3 *outPositions, u32 count)
+{
+    SkinLinear(palette, weights, positions, 0, outPositions, 0, count);
+}
+
+//
+// NOTE: Dual quaternion skinning
+//
+
+// NOTE: Weighted sum with every influence flipped to the hemisphere of the
+//       first one, not normalised
+inline dualquat BlendDualQuats(const dualquat *palette, const skinweights &sw)
+{
+    const dualquat &first = palette[sw.bones[0]];
+    dualquat result = first * sw.weights[0];
+
+    for(u32 i = 1; i < SKIN_MAX_WEIGHTS; ++i)
+    {
+        const dualquat &dq = palette[sw.bones[i]];
+
+        // NOTE: Flip by the sign bit of the dot product, no branch to mispredict
+        intfloat d = {Dot(first.real, dq.real)},
+                 w = {sw.weights[i]};
+        w.u ^= d.u & 0x80000000;
+
+        result += dq * w.f;
+    }
+
+    return result;
+}
+
+inline void SkinDualQuat(const dualquat *palette, const skinweights *weights,
+                         const vec3 *positions, const vec3 *normals,
+                         vec3 *outPositions, vec3 *outNormals, u32 count)
+{
+    AAM_Assert(palette && weights && positions && outPositions);
+    AAM_Assert((normals == 0) == (outNormals == 0));
+
+    u32 i = 0;
+
+    // NOTE: Blend 4 vertices into a small AoS buffer, then normalise and
+    //       transform them as one dualquatx4
+    for(; i + 4 <= count; i += 4)
+    {
+        quat real[4],
+             dual[4];
+
+        for(u32 j = 0; j < 4; ++j)
+        {
+            dualquat dq = BlendDualQuats(palette, weights[i + j]);
+            real[j] = dq.real;
+            dual[j] = dq.dual;
+        }
+
+        dualquatx4 dq = DualQuatx4(LoadQuatx4(real), LoadQuatx4(dual));
+        Normalize(dq);
+
+        Store(outPositions + i, TransformPoint(dq, LoadVec3x4(positions + i)));
+
+        if(normals)
+            Store(outNormals + i, TransformDirection(dq, LoadVec3x4(normals + i)));
+    }
+
+    for(; i < count; ++i)
+    {
+        dualquat dq = Normalized(BlendDualQuats(palette, weights[i]));
+
+        outPositions[i] = TransformPoint(dq, positions[i]);
+
+        if(normals)
+            outNormals[i] = TransformDirection(dq, normals[i]);
+    }
+}
+
+inline void SkinDualQuat(const dualquat *palette, const skinweights *weights,
+                         const vec3 *positions, vec3 *outPositions, u32 count)
+{
+    SkinDualQuat(palette, weights, positions, 0, outPositions, 0, count);
+}
+
+} // NOTE: Namespace
+
+#endif
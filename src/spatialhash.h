@@ -0,0 +1,390 @@
+#ifndef SPATIALHASH_H
+#define SPATIALHASH_H
+
+#include "aamath.h"
+#include "vec3.h"
+#include "vec4.h"
+#include "wide.h"
+#include "collision.h"
+
+namespace aam {
+
+// NOTE: Uniform grid over points, hashed on the vec3s cell coordinates so the
+//       grid is unbounded and only occupied cells take memory. A build counting
+//       sorts the points by cell: each cell of the open addressing table holds
+//       a contiguous range of the sorted positions, so a query walks the cells
+//       its bounds cover and scans each range 4 points at a time. A cell size
+//       close to the usual query radius keeps that to 8-27 cells, bounds
+//       covering more cells than are occupied scan the occupied cells instead.
+//       All memory is owned by the caller, see SpatialHashMemorySize().
+
+typedef struct _spatialcell
+{
+    vec3s coords;
+    u32 first,
+        count;      // NOTE: 0 marks an empty slot
+} spatialcell;
+
+typedef struct _spatialhash
+{
+    vec4 *positions;    // NOTE: Sorted by cell, w unused
+    u32 *ids;           // NOTE: Index into the built points of positions[i]
+    u32 *slots;         // NOTE: Build scratch, the cell slot of each point
+    spatialcell *cells;
+    u32 maxEntries,
+        count,
+        cellCapacity,   // NOTE: Power of two, at least 2 * maxEntries
+        cellCount;
+    r32 cellSize,
+        invCellSize;
+} spatialhash;
+
+inline u32 SpatialHashCellCapacity(u32 maxEntries)
+{
+    u32 result = 16;
+
+    while(result < 2 * maxEntries)
+        result *= 2;
+
+    return result;
+}
+
+// NOTE: Bytes of 16-byte aligned memory InitSpatialHash needs
+inline u64 SpatialHashMemorySize(u32 maxEntries)
+{
+    return (u64)maxEntries * (sizeof(vec4) + 2 * sizeof(u32))
+           + (u64)SpatialHashCellCapacity(maxEntries) * sizeof(spatialcell);
+}
+
+inline void InitSpatialHash(spatialhash &hash, void *memory, u32 maxEntries, r32 cellSize)
+{
+    AAM_Assert(memory && ((u64)memory & 15) == 0);
+    AAM_Assert(cellSize > 0.0f);
+
+    hash.maxEntries = maxEntries;
+    hash.count = 0;
+    hash.cellCapacity = SpatialHashCellCapacity(maxEntries);
+    hash.cellCount = 0;
+    hash.cellSize = cellSize;
+    hash.invCellSize = 1.0f / cellSize;
+    hash.positions = (vec4 *)memory;
+    hash.cells = (spatialcell *)(hash.positions + maxEntries);
+    hash.ids = (u32 *)(hash.cells + hash.cellCapacity);
+    hash.slots = hash.ids + maxEntries;
+
+    for(u32 i = 0; i < hash.cellCapacity; ++i)
+    {
+        hash.cells[i].count = 0;
+    }
+}
+
+inline vec3s SpatialHashCell(const spatialhash &hash, const vec3 &p)
+{
+    return FloorToVec3s(p * hash.invCellSize);
+}
+
+inline u32 SpatialHashSlot(const spatialhash &hash, const vec3s &coords)
+{
+    u32 key = (u32)coords.x * 0x8DA6B343u + (u32)coords.y * 0xD8163841u + (u32)coords.z * 0xCB1AB31Fu;
+
+    return (u32)(((u64)key * 0x9E3779B97F4A7C15ull) >> 32) & (hash.cellCapacity - 1);
+}
+
+// NOTE: 0 when no point lies in the cell
+inline const spatialcell *FindCell(const spatialhash &hash, const vec3s &coords)
+{
+    u32 mask = hash.cellCapacity - 1,
+        slot = SpatialHashSlot(hash, coords);
+
+    while(hash.cells[slot].count != 0)
+    {
+        const spatialcell &cell = hash.cells[slot];
+
+        if(cell.coords.x == coords.x && cell.coords.y == coords.y && cell.coords.z == coords.z)
+            return &cell;
+
+        slot = (slot + 1) & mask;
+    }
+
+    return 0;
+}
+
+// NOTE: Rebuilds the grid from scratch over points[0..count), ids are the
+//       indices into points. Points within 2^31 cells of the origin only.
+inline void BuildSpatialHash(spatialhash &hash, const vec3 *points, u32 count)
+{
+    AAM_Assert(count <= hash.maxEntries);
+    AAM_Assert(points || count == 0);
+
+    u32 mask = hash.cellCapacity - 1;
+
+    for(u32 i = 0; i < hash.cellCapacity; ++i)
+    {
+        hash.cells[i].count = 0;
+    }
+
+    hash.count = count;
+    hash.cellCount = 0;
+
+    // NOTE: Count the points per cell
+    for(u32 i = 0; i < count; ++i)
+    {
+        vec3s coords = SpatialHashCell(hash, points[i]);
+        u32 slot = SpatialHashSlot(hash, coords);
+
+        for(;;)
+        {
+            spatialcell &cell = hash.cells[slot];
+
+            if(cell.count == 0)
+            {
+                cell.coords = coords;
+                ++hash.cellCount;
+                break;
+            }
+
+            if(cell.coords.x == coords.x && cell.coords.y == coords.y && cell.coords.z == coords.z)
+                break;
+
+            slot = (slot + 1) & mask;
+        }
+
+        ++hash.cells[slot].count;
+        hash.slots[i] = slot;
+    }
+
+    // NOTE: Prefix sum into the range starts, the counts then serve as cursors
+    u32 first = 0;
+
+    for(u32 i = 0; i < hash.cellCapacity; ++i)
+    {
+        spatialcell &cell = hash.cells[i];
+
+        if(cell.count != 0)
+        {
+            cell.first = first;
+            first += cell.count;
+            cell.count = 0;
+        }
+    }
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        spatialcell &cell = hash.cells[hash.slots[i]];
+        u32 dst = cell.first + cell.count++;
+
+        hash.positions[dst] = Vec4(points[i], 0.0f);
+        hash.ids[dst] = i;
+    }
+}
+
+inline void SpatialHashEmit(u32 *results, u32 maxResults, u32 &found, u32 id)
+{
+    if(found < maxResults)
+        results[found] = id;
+    ++found;
+}
+
+// NOTE: SpatialHashCell for query bounds, clamped to the s32 range (NaN to its
+//       low end) so far or infinite bounds cannot overflow the conversion
+inline vec3s SpatialHashQueryCell(const spatialhash &hash, const vec3 &p)
+{
+    vec3 q = p * hash.invCellSize;
+
+    for(u32 i = 0; i < 3; ++i)
+    {
+        q.E[i] = Min(Max(q.E[i], -2147483648.0f), 2147483520.0f);
+    }
+
+    return FloorToVec3s(q);
+}
+
+// NOTE: True when [lo, hi] covers no more cells than are occupied, then a query
+//       looks each one up, otherwise it scans the occupied cells instead
+inline b32 SpatialHashWalkRange(const spatialhash &hash, const vec3s &lo, const vec3s &hi)
+{
+    u64 nx = (u64)((s64)hi.x - lo.x + 1),
+        ny = (u64)((s64)hi.y - lo.y + 1),
+        nz = (u64)((s64)hi.z - lo.z + 1);
+
+    // NOTE: Each is at most 2^32, bound nx * ny first so the products fit
+    if(nx > hash.cellCount || ny > hash.cellCount / nx)
+        return false;
+
+    return nx * ny * nz <= hash.cellCount;
+}
+
+inline b32 SpatialHashCellInRange(const spatialcell &cell, const vec3s &lo, const vec3s &hi)
+{
+    return (cell.count != 0
+            && lo.x <= cell.coords.x && cell.coords.x <= hi.x
+            && lo.y <= cell.coords.y && cell.coords.y <= hi.y
+            && lo.z <= cell.coords.z && cell.coords.z <= hi.z);
+}
+
+inline void SpatialHashRadiusCell(const spatialhash &hash, const spatialcell &cell, const vec3 &centre,
+                                  r32 radiusSq, u32 *results, u32 maxResults, u32 &found)
+{
+    r32x4 cx = R32x4(centre.x),
+          cy = R32x4(centre.y),
+          cz = R32x4(centre.z),
+          r2 = R32x4(radiusSq);
+
+    u32 i = cell.first,
+        end = cell.first + cell.count;
+
+    for(; i + 4 <= end; i += 4)
+    {
+        vec4x4 p = LoadVec4x4(hash.positions + i);
+        r32x4 dx = p.x - cx,
+              dy = p.y - cy,
+              dz = p.z - cz;
+        u32 inside = MoveMask(dx * dx + dy * dy + dz * dz <= r2);
+
+        for(u32 lane = 0; inside; ++lane, inside >>= 1)
+        {
+            if(inside & 1)
+                SpatialHashEmit(results, maxResults, found, hash.ids[i + lane]);
+        }
+    }
+
+    for(; i < end; ++i)
+    {
+        const vec4 &p = hash.positions[i];
+        r32 dx = p.x - centre.x,
+            dy = p.y - centre.y,
+            dz = p.z - centre.z;
+
+        if(dx * dx + dy * dy + dz * dz <= radiusSq)
+            SpatialHashEmit(results, maxResults, found, hash.ids[i]);
+    }
+}
+
+inline void SpatialHashBoxCell(const spatialhash &hash, const spatialcell &cell, const aabb &bb,
+                               u32 *results, u32 maxResults, u32 &found)
+{
+    r32x4 minX = R32x4(bb.min.x),
+          minY = R32x4(bb.min.y),
+          minZ = R32x4(bb.min.z),
+          maxX = R32x4(bb.max.x),
+          maxY = R32x4(bb.max.y),
+          maxZ = R32x4(bb.max.z);
+
+    u32 i = cell.first,
+        end = cell.first + cell.count;
+
+    for(; i + 4 <= end; i += 4)
+    {
+        vec4x4 p = LoadVec4x4(hash.positions + i);
+        u32 inside = MoveMask((minX <= p.x) & (p.x <= maxX)
+                              & (minY <= p.y) & (p.y <= maxY)
+                              & (minZ <= p.z) & (p.z <= maxZ));
+
+        for(u32 lane = 0; inside; ++lane, inside >>= 1)
+        {
+            if(inside & 1)
+                SpatialHashEmit(results, maxResults, found, hash.ids[i + lane]);
+        }
+    }
+
+    for(; i < end; ++i)
+    {
+        const vec4 &p = hash.positions[i];
+
+        if(bb.min.x <= p.x && p.x <= bb.max.x
+           && bb.min.y <= p.y && p.y <= bb.max.y
+           && bb.min.z <= p.z && p.z <= bb.max.z)
+            SpatialHashEmit(results, maxResults, found, hash.ids[i]);
+    }
+}
+
+// NOTE: Writes the ids of the points within radius of centre (inclusive) to
+//       results (up to maxResults) and returns the total number found, which
+//       can be larger
+inline u32 Overlaps(const spatialhash &hash, const vec3 &centre, r32 radius,
+                    u32 *results, u32 maxResults)
+{
+    if(hash.count == 0 || !(radius >= 0.0f))
+        return 0;
+
+    vec3 extent = Vec3(radius, radius, radius);
+    vec3s lo = SpatialHashQueryCell(hash, centre - extent),
+          hi = SpatialHashQueryCell(hash, centre + extent);
+    r32 radiusSq = radius * radius;
+    u32 found = 0;
+
+    if(SpatialHashWalkRange(hash, lo, hi))
+    {
+        // NOTE: s64 so a range ending at the s32 limit still terminates
+        for(s64 z = lo.z; z <= hi.z; ++z)
+        {
+            for(s64 y = lo.y; y <= hi.y; ++y)
+            {
+                for(s64 x = lo.x; x <= hi.x; ++x)
+                {
+                    const spatialcell *cell = FindCell(hash, Vec3s((s32)x, (s32)y, (s32)z));
+
+                    if(cell)
+                        SpatialHashRadiusCell(hash, *cell, centre, radiusSq, results, maxResults, found);
+                }
+            }
+        }
+    }
+    else
+    {
+        for(u32 slot = 0; slot < hash.cellCapacity; ++slot)
+        {
+            if(SpatialHashCellInRange(hash.cells[slot], lo, hi))
+                SpatialHashRadiusCell(hash, hash.cells[slot], centre, radiusSq, results, maxResults, found);
+        }
+    }
+
+    return found;
+}
+
+inline u32 Overlaps(const spatialhash &hash, const sphere &s, u32 *results, u32 maxResults)
+{
+    return Overlaps(hash, s.origin, s.radius, results, maxResults);
+}
+
+// NOTE: Points inside the box or on its boundary
+inline u32 Overlaps(const spatialhash &hash, const aabb &bb, u32 *results, u32 maxResults)
+{
+    if(hash.count == 0 || !(bb.min.x <= bb.max.x && bb.min.y <= bb.max.y && bb.min.z <= bb.max.z))
+        return 0;
+
+    vec3s lo = SpatialHashQueryCell(hash, bb.min),
+          hi = SpatialHashQueryCell(hash, bb.max);
+    u32 found = 0;
+
+    if(SpatialHashWalkRange(hash, lo, hi))
+    {
+        for(s64 z = lo.z; z <= hi.z; ++z)
+        {
+            for(s64 y = lo.y; y <= hi.y; ++y)
+            {
+                for(s64 x = lo.x; x <= hi.x; ++x)
+                {
+                    const spatialcell *cell = FindCell(hash, Vec3s((s32)x, (s32)y, (s32)z));
+
+                    if(cell)
+                        SpatialHashBoxCell(hash, *cell, bb, results, maxResults, found);
+                }
+            }
+        }
+    }
+    else
+    {
+        for(u32 slot = 0; slot < hash.cellCapacity; ++slot)
+        {
+            if(SpatialHashCellInRange(hash.cells[slot], lo, hi))
+                SpatialHashBoxCell(hash, hash.cells[slot], bb, results, maxResults, found);
+        }
+    }
+
+    return found;
+}
+
+} // NOTE: Namespace
+
+#endif
@@ -0,0 +1,339 @@
+#ifndef SWEEPPRUNE_H
+#define SWEEPPRUNE_H
+
+#include "aamath.h"
+#include "vec3.h"
+#include "collision.h"
+
+namespace aam {
+
+// NOTE: Sort-and-sweep broadphase over an array of aabb, for scenes where most
+//       objects move little between frames. The boxes are kept sorted by their
+//       min on one axis across updates, so an update is an insertion sort of an
+//       almost sorted list plus a sweep. The sweep axis follows the axis with
+//       the largest variance of the box centres. The overlapping pairs persist
+//       in a hash set, and each update reports only the pairs that started or
+//       stopped overlapping. All memory is owned by the caller, see
+//       SweepPruneMemorySize().
+
+// NOTE: Another axis has to spread the centres this much more than the current
+//       one before the list is re-sorted along it
+#ifndef SWEEPPRUNE_AXIS_HYSTERESIS
+#define SWEEPPRUNE_AXIS_HYSTERESIS 1.5f
+#endif
+
+#define SWEEPPRUNE_EMPTY_KEY    0xFFFFFFFFFFFFFFFFull
+
+typedef struct _sweepentry
+{
+    r32 min,
+        max;        // NOTE: Extent on the sweep axis
+    u32 index;
+} sweepentry;
+
+typedef struct _sweeppair
+{
+    u64 key;        // NOTE: (a << 32) | b with a < b
+    u32 frame;      // NOTE: Last update that found the pair
+    u32 padding;
+} sweeppair;
+
+typedef struct _sweepprune
+{
+    sweepentry *entries;
+    sweeppair *pairs;
+    u32 maxObjects,
+        count,
+        maxPairs,
+        pairCapacity,   // NOTE: Power of two, at least 2 * maxPairs
+        pairCount,
+        frame,
+        axis;
+} sweepprune;
+
+// NOTE: Called once per pair that started (added) or stopped overlapping, a < b
+//       are indices into the boxes array
+typedef void sweepprune_callback(void *user, u32 a, u32 b, b32 added);
+
+inline u32 SweepPrunePairCapacity(u32 maxPairs)
+{
+    u32 result = 16;
+
+    while(result < 2 * maxPairs)
+        result *= 2;
+
+    return result;
+}
+
+// NOTE: Bytes of 16-byte aligned memory InitSweepPrune needs
+inline u64 SweepPruneMemorySize(u32 maxObjects, u32 maxPairs)
+{
+    return (u64)SweepPrunePairCapacity(maxPairs) * sizeof(sweeppair) + (u64)maxObjects * sizeof(sweepentry);
+}
+
+inline void InitSweepPrune(sweepprune &sap, void *memory, u32 maxObjects, u32 maxPairs)
+{
+    AAM_Assert(memory && ((u64)memory & 15) == 0);
+
+    sap.maxObjects = maxObjects;
+    sap.count = 0;
+    sap.maxPairs = maxPairs;
+    sap.pairCapacity = SweepPrunePairCapacity(maxPairs);
+    sap.pairCount = 0;
+    sap.frame = 0;
+    sap.axis = 0;
+    sap.pairs = (sweeppair *)memory;
+    sap.entries = (sweepentry *)(sap.pairs + sap.pairCapacity);
+
+    for(u32 i = 0; i < sap.pairCapacity; ++i)
+    {
+        sap.pairs[i].key = SWEEPPRUNE_EMPTY_KEY;
+    }
+}
+
+inline u32 SweepPruneHash(const sweepprune &sap, u64 key)
+{
+    return (u32)((key * 0x9E3779B97F4A7C15ull) >> 32) & (sap.pairCapacity - 1);
+}
+
+// NOTE: Stamps the pair with the current frame, returns true when it is new
+inline b32 SweepPruneAddPair(sweepprune &sap, u32 a, u32 b)
+{
+    u64 key = ((u64)a << 32) | b;
+    u32 mask = sap.pairCapacity - 1,
+        slot = SweepPruneHash(sap, key);
+
+    while(sap.pairs[slot].key != SWEEPPRUNE_EMPTY_KEY)
+    {
+        if(sap.pairs[slot].key == key)
+        {
+            sap.pairs[slot].frame = sap.frame;
+            return false;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+
+    AAM_Assert(sap.pairCount < sap.maxPairs);
+
+    if(sap.pairCount >= sap.maxPairs)
+        return false;
+
+    sap.pairs[slot].key = key;
+    sap.pairs[slot].frame = sap.frame;
+    ++sap.pairCount;
+
+    return true;
+}
+
+// NOTE: Linear probing deletion, shifts the rest of the cluster back so no
+//       tombstones are needed
+inline void SweepPruneRemoveSlot(sweepprune &sap, u32 slot)
+{
+    u32 mask = sap.pairCapacity - 1,
+        next = (slot + 1) & mask;
+
+    while(sap.pairs[next].key != SWEEPPRUNE_EMPTY_KEY)
+    {
+        u32 home = SweepPruneHash(sap, sap.pairs[next].key);
+
+        // NOTE: Move the entry back unless its home lies cyclically in (slot, next]
+        if(((next - home) & mask) >= ((next - slot) & mask))
+        {
+            sap.pairs[slot] = sap.pairs[next];
+            slot = next;
+        }
+
+        next = (next + 1) & mask;
+    }
+
+    sap.pairs[slot].key = SWEEPPRUNE_EMPTY_KEY;
+    --sap.pairCount;
+}
+
+inline void SweepPruneSiftDown(sweepentry *entries, u32 root, u32 count)
+{
+    for(;;)
+    {
+        u32 child = 2 * root + 1;
+
+        if(child >= count)
+            break;
+
+        if(child + 1 < count && entries[child + 1].min > entries[child].min)
+            ++child;
+
+        if(entries[child].min <= entries[root].min)
+            break;
+
+        sweepentry tmp = entries[root];
+        entries[root] = entries[child];
+        entries[child] = tmp;
+        root = child;
+    }
+}
+
+// NOTE: Heap sort for unsorted lists (first update, axis or count changes)
+inline void SweepPruneSort(sweepentry *entries, u32 count)
+{
+    for(u32 i = count / 2; i-- > 0;)
+    {
+        SweepPruneSiftDown(entries, i, count);
+    }
+
+    for(u32 end = count; end-- > 1;)
+    {
+        sweepentry tmp = entries[0];
+        entries[0] = entries[end];
+        entries[end] = tmp;
+
+        SweepPruneSiftDown(entries, 0, end);
+    }
+}
+
+// NOTE: Insertion sort, close to linear when the order barely changed
+inline void SweepPruneInsertionSort(sweepentry *entries, u32 count)
+{
+    for(u32 i = 1; i < count; ++i)
+    {
+        sweepentry entry = entries[i];
+        u32 j = i;
+
+        while(j > 0 && entries[j - 1].min > entry.min)
+        {
+            entries[j] = entries[j - 1];
+            --j;
+        }
+
+        entries[j] = entry;
+    }
+}
+
+// NOTE: Sorts, sweeps and reports the pair changes since the last update.
+//       boxes[i] is object i, count may change between updates (objects past
+//       the new count lose their pairs). callback may be 0.
+inline void UpdateSweepPrune(sweepprune &sap, const aabb *boxes, u32 count,
+                             sweepprune_callback *callback, void *user)
+{
+    AAM_Assert(count <= sap.maxObjects);
+    AAM_Assert(boxes || count == 0);
+
+    ++sap.frame;
+
+    // NOTE: Centre variance per axis (of twice the centres, relative to the
+    //       first one to limit the cancellation), to pick the sweep axis
+    vec3 sum = VEC3_ZERO,
+         sumSq = VEC3_ZERO,
+         shift = (count > 0) ? boxes[0].min + boxes[0].max : VEC3_ZERO;
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        vec3 c = boxes[i].min + boxes[i].max - shift;
+
+        sum += c;
+        sumSq += Hadamard(c, c);
+    }
+
+    u32 axis = sap.axis;
+
+    if(count > 1)
+    {
+        vec3 variance = sumSq - Hadamard(sum, sum) * (1.0f / (r32)count);
+        u32 best = (variance.x > variance.y) ? ((variance.x > variance.z) ? 0 : 2)
+                                             : ((variance.y > variance.z) ? 1 : 2);
+
+        if(variance.E[best] > SWEEPPRUNE_AXIS_HYSTERESIS * variance.E[axis])
+            axis = best;
+    }
+
+    if(count != sap.count || axis != sap.axis)
+    {
+        for(u32 i = 0; i < count; ++i)
+        {
+            sap.entries[i].index = i;
+            sap.entries[i].min = boxes[i].min.E[axis];
+            sap.entries[i].max = boxes[i].max.E[axis];
+        }
+
+        SweepPruneSort(sap.entries, count);
+
+        sap.count = count;
+        sap.axis = axis;
+    }
+    else
+    {
+        for(u32 i = 0; i < count; ++i)
+        {
+            sweepentry &entry = sap.entries[i];
+
+            entry.min = boxes[entry.index].min.E[axis];
+            entry.max = boxes[entry.index].max.E[axis];
+        }
+
+        SweepPruneInsertionSort(sap.entries, count);
+    }
+
+    // NOTE: Sweep, every box against the ones starting before it ends
+    u32 axis1 = (axis + 1) % 3,
+        axis2 = (axis + 2) % 3;
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        const sweepentry &a = sap.entries[i];
+        const aabb &boxA = boxes[a.index];
+
+        for(u32 j = i + 1; j < count && sap.entries[j].min <= a.max; ++j)
+        {
+            u32 indexB = sap.entries[j].index;
+            const aabb &boxB = boxes[indexB];
+
+            if(boxA.min.E[axis1] > boxB.max.E[axis1] || boxB.min.E[axis1] > boxA.max.E[axis1]
+               || boxA.min.E[axis2] > boxB.max.E[axis2] || boxB.min.E[axis2] > boxA.max.E[axis2])
+                continue;
+
+            u32 lo = (a.index < indexB) ? a.index : indexB,
+                hi = (a.index < indexB) ? indexB : a.index;
+
+            if(SweepPruneAddPair(sap, lo, hi) && callback)
+                callback(user, lo, hi, true);
+        }
+    }
+
+    // NOTE: Pairs this sweep did not find. A removal shifts a later entry into
+    //       this slot, so the slot is looked at again.
+    for(u32 slot = 0; slot < sap.pairCapacity;)
+    {
+        sweeppair &pair = sap.pairs[slot];
+
+        if(pair.key != SWEEPPRUNE_EMPTY_KEY && pair.frame != sap.frame)
+        {
+            u32 a = (u32)(pair.key >> 32),
+                b = (u32)pair.key;
+
+            SweepPruneRemoveSlot(sap, slot);
+
+            if(callback)
+                callback(user, a, b, false);
+        }
+        else
+        {
+            ++slot;
+        }
+    }
+}
+
+// NOTE: Calls callback(user, a, b, true) for every current pair
+inline void ForEachPair(const sweepprune &sap, sweepprune_callback *callback, void *user)
+{
+    for(u32 slot = 0; slot < sap.pairCapacity; ++slot)
+    {
+        u64 key = sap.pairs[slot].key;
+
+        if(key != SWEEPPRUNE_EMPTY_KEY)
+            callback(user, (u32)(key >> 32), (u32)key, true);
+    }
+}
+
+} // NOTE: Namespace
+
+#endif
@@ -0,0 +1,209 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include "aamath.h"
+#include "vec3.h"
+#include "mat3.h"
+#include "mat4.h"
+#include "quat.h"
+#include "mat4x3.h"
+
+namespace aam
+{
+
+// NOTE: Translation, rotation and scale kept apart, applied as T * R * S * v.
+//       Rotation must be unit length. Composition and inversion are exact for
+//       uniform scale; with non-uniform scale the result has no shear term, so
+//       it only matches the matrix product when the scale is along the axes
+//       of the other rotation (the usual approximation for scene hierarchies).
+
+typedef struct _transform
+{
+    quat rotation;
+    vec3 translation;
+    vec3 scale;
+} transform;
+
+inline transform Transform(const vec3 &translation, const quat &rotation, const vec3 &scale)
+{
+    transform result;
+
+    result.rotation = rotation;
+    result.translation = translation;
+    result.scale = scale;
+
+    return result;
+}
+
+inline transform Transform(const vec3 &translation, const quat &rotation, r32 scale = 1.0f)
+{
+    return Transform(translation, rotation, Vec3(scale, scale, scale));
+}
+
+//
+// NOTE: Static constants
+//
+
+static const transform TRANSFORM_IDENTITY = {{1.0f, 0.0f, 0.0f, 0.0f},
+                                             {0.0f, 0.0f, 0.0f},
+                                             {1.0f, 1.0f, 1.0f}};
+
+//
+// NOTE: Operators
+//
+
+// NOTE: a * b applies b first, like the matrix product
+inline transform operator*(const transform &a, const transform &b)
+{
+    transform result;
+
+    result.rotation = a.rotation * b.rotation;
+    result.translation = Rotate(a.rotation, Hadamard(a.scale, b.translation)) + a.translation;
+    result.scale = Hadamard(a.scale, b.scale);
+
+    return result;
+}
+
+inline transform &operator*=(transform &a, const transform &b)
+{
+    a = a * b;
+
+    return a;
+}
+
+//
+// NOTE: Functions
+//
+
+// NOTE: Scale components must be non-zero
+inline transform Inverse(const transform &tf)
+{
+    transform result;
+
+    result.rotation = Conjugate(tf.rotation);
+    result.scale = Vec3(1.0f / tf.scale.x, 1.0f / tf.scale.y, 1.0f / tf.scale.z);
+    result.translation = -Hadamard(result.scale, Rotate(result.rotation, tf.translation));
+
+    return result;
+}
+
+inline vec3 TransformPoint(const transform &tf, const vec3 &p)
+{
+    return Rotate(tf.rotation, Hadamard(tf.scale, p)) + tf.translation;
+}
+
+inline vec3 TransformDirection(const transform &tf, const vec3 &d)
+{
+    return Rotate(tf.rotation, Hadamard(tf.scale, d));
+}
+
+// NOTE: Lerps translation and scale, nlerps the rotation along the shorter arc
+inline transform Lerp(const transform &a, r32 t, const transform &b)
+{
+    transform result;
+
+    r32 sign = (Dot(a.rotation, b.rotation) < 0.0f) ? -1.0f : 1.0f;
+
+    result.rotation = (1.0f - t) * a.rotation + (t * sign) * b.rotation;
+    Normalize(result.rotation);
+    result.translation = (1.0f - t) * a.translation + t * b.translation;
+    result.scale = (1.0f - t) * a.scale + t * b.scale;
+
+    return result;
+}
+
+//
+// NOTE: Conversions
+//
+
+// NOTE: Writes T * R * S directly, the rotation basis (as in Mat4Rotation)
+//       with each row scaled by its scale component
+inline mat4x3 ToMat4x3(const transform &tf)
+{
+    mat4x3 result;
+
+    const quat &q = tf.rotation;
+    const vec3 &s = tf.scale;
+
+    r32 xs = q.x + q.x,
+        ys = q.y + q.y,
+        zs = q.z + q.z,
+        wx = q.w * xs,
+        wy = q.w * ys,
+        wz = q.w * zs,
+        xx = q.x * xs,
+        xy = q.x * ys,
+        xz = q.x * zs,
+        yy = q.y * ys,
+        yz = q.y * zs,
+        zz = q.z * zs;
+
+    result.xx = (1.0f - (yy + zz)) * s.x;
+    result.xy = (xy + wz) * s.x;
+    result.xz = (xz - wy) * s.x;
+
+    result.yx = (xy - wz) * s.y;
+    result.yy = (1.0f - (xx + zz)) * s.y;
+    result.yz = (yz + wx) * s.y;
+
+    result.zx = (xz + wy) * s.z;
+    result.zy = (yz - wx) * s.z;
+    result.zz = (1.0f - (xx + yy)) * s.z;
+
+    result.t = tf.translation;
+
+    return result;
+}
+
+inline mat4 ToMat4(const transform &tf)
+{
+    return ToMat4(ToMat4x3(tf));
+}
+
+inline void ToMat4x3(const transform *in, mat4x3 *out, u32 count)
+{
+    AAM_Assert(in && out);
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        out[i] = ToMat4x3(in[i]);
+    }
+}
+
+inline void ToMat4(const transform *in, mat4 *out, u32 count)
+{
+    AAM_Assert(in && out);
+
+    for(u32 i = 0; i < count; ++i)
+    {
+        out[i] = ToMat4(in[i]);
+    }
+}
+
+// NOTE: Decomposes an affine matrix without shear, scale is the basis
+//       lengths (always positive, a mirrored basis is not recovered)
+inline transform Transform(const mat4x3 &m)
+{
+    transform result;
+
+    result.scale = Vec3(Length(m.x), Length(m.y), Length(m.z));
+    result.translation = m.t;
+
+    mat3 r;
+    r.x = m.x / result.scale.x;
+    r.y = m.y / result.scale.y;
+    r.z = m.z / result.scale.z;
+
+    result.rotation = GetQuaternion(r);
+
+    return result;
+}
+
+inline transform Transform(const mat4 &m)
+{
+    return Transform(Mat4x3(m));
+}
+
+} // NOTE: Namespace
+
+#endif
@@ -613,6 +613,11 @@ inline b32 IsZero(const vec3s &v)
     return ((v.x == 0) && (v.y == 0) && (v.z == 0));
 }
 
+inline vec3s FloorToVec3s(const vec3 &v)
+{
+    return Vec3s(FloorToS32(v.x), FloorToS32(v.y), FloorToS32(v.z));
+}
+
 //
 // NOTE: vec3 unsigned int
 //
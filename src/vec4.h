@@ -291,7 +291,7 @@ inline r32 Dot(const vec4 &a, const vec4 &b)
 
 inline vec4 Hadamard(const vec4 &a, const vec4 &b)
 {
-    return Vec4(a.x * b.x, a.y * b.y, a.z * b.z, a.w * a.w);
+    return Vec4(a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w);
 }
 
 inline r32 LengthSq(const vec4 &a)
@@ -636,7 +636,7 @@ inline s32 Dot(const vec4s &a, const vec4s &b)
 
 inline vec4s Hadamard(const vec4s &a, const vec4s &b)
 {
-    return Vec4s(a.x * b.x, a.y * b.y, a.z * b.z, a.w * a.w);
+    return Vec4s(a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w);
 }
 
 inline s32 LengthSq(const vec4s &a)
@@ -900,7 +900,7 @@ inline u32 Dot(const vec4u &a, const vec4u &b)
 
 inline vec4u Hadamard(const vec4u &a, const vec4u &b)
 {
-    return Vec4u(a.x * b.x, a.y * b.y, a.z * b.z, a.w * a.w);
+    return Vec4u(a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w);
 }
 
 inline b32 IsZero(const vec4u &v)
@@ -0,0 +1,1274 @@
+#ifndef WIDE_H
+#define WIDE_H
+
+#include "aamath.h"
+#include "simd.h"
+#include "vec3.h"
+#include "vec4.h"
+#include "quat.h"
+
+namespace aam
+{
+
+// NOTE: SoA ("wide") versions of vec3, vec4 and quat, one element per lane.
+//       The free functions mirror the scalar API so per-entity code can be
+//       ported by swapping types, with branches replaced by Select.
+//
+//       Load/Store convert to and from arrays of the AoS types.
+
+typedef struct _vec3x4
+{
+    r32x4 x, y, z;
+} vec3x4;
+
+typedef struct _vec3x8
+{
+    r32x8 x, y, z;
+} vec3x8;
+
+typedef struct _vec4x4
+{
+    r32x4 x, y, z, w;
+} vec4x4;
+
+typedef struct _quatx4
+{
+    r32x4 w, x, y, z;
+} quatx4;
+
+//
+// NOTE: vec3x4
+//
+
+inline vec3x4 Vec3x4(const r32x4 &x, const r32x4 &y, const r32x4 &z)
+{
+    vec3x4 result;
+
+    result.x = x;
+    result.y = y;
+    result.z = z;
+
+    return result;
+}
+
+// NOTE: Same vector in every lane
+inline vec3x4 Vec3x4(const vec3 &v)
+{
+    return Vec3x4(R32x4(v.x), R32x4(v.y), R32x4(v.z));
+}
+
+// NOTE: Loads 4 consecutive vec3s
+inline vec3x4 LoadVec3x4(const vec3 *src)
+{
+    vec3x4 result;
+
+#if defined(AAMATH_SSE4)
+    // NOTE: x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+    __m128 a0 = _mm_loadu_ps(&src[0].x),
+           a1 = _mm_loadu_ps(&src[1].y),
+           a2 = _mm_loadu_ps(&src[2].z);
+
+    __m128 xy = _mm_shuffle_ps(a1, a2, _MM_SHUFFLE(2, 1, 3, 2)),
+           yz = _mm_shuffle_ps(a0, a1, _MM_SHUFFLE(1, 0, 2, 1));
+
+    result.x.m = _mm_shuffle_ps(a0, xy, _MM_SHUFFLE(2, 0, 3, 0));
+    result.y.m = _mm_shuffle_ps(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));
+    result.z.m = _mm_shuffle_ps(yz, a2, _MM_SHUFFLE(3, 0, 3, 1));
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.x.E[i] = src[i].x;
+        result.y.E[i] = src[i].y;
+        result.z.E[i] = src[i].z;
+    }
+#endif
+
+    return result;
+}
+
+// NOTE: Stores 4 consecutive vec3s
+inline void Store(vec3 *dst, const vec3x4 &v)
+{
+#if defined(AAMATH_SSE4)
+    __m128 xy01 = _mm_unpacklo_ps(v.x.m, v.y.m),
+           xy23 = _mm_unpackhi_ps(v.x.m, v.y.m),
+           zx01 = _mm_shuffle_ps(v.z.m, v.x.m, _MM_SHUFFLE(1, 0, 1, 0)),
+           yz1 = _mm_shuffle_ps(v.y.m, v.z.m, _MM_SHUFFLE(1, 1, 1, 1)),
+           zx23 = _mm_shuffle_ps(v.z.m, xy23, _MM_SHUFFLE(2, 2, 2, 2)),
+           yz3 = _mm_shuffle_ps(xy23, v.z.m, _MM_SHUFFLE(3, 3, 3, 3));
+
+    _mm_storeu_ps(&dst[0].x, _mm_shuffle_ps(xy01, zx01, _MM_SHUFFLE(3, 0, 1, 0)));
+    _mm_storeu_ps(&dst[1].y, _mm_shuffle_ps(yz1, xy23, _MM_SHUFFLE(1, 0, 2, 0)));
+    _mm_storeu_ps(&dst[2].z, _mm_shuffle_ps(zx23, yz3, _MM_SHUFFLE(2, 0, 2, 0)));
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        dst[i].x = v.x.E[i];
+        dst[i].y = v.y.E[i];
+        dst[i].z = v.z.E[i];
+    }
+#endif
+}
+
+inline vec3 Lane(const vec3x4 &v, u32 i)
+{
+    return Vec3(v.x.E[i], v.y.E[i], v.z.E[i]);
+}
+
+// NOTE: Stores 4 consecutive vec3s bypassing the cache, dst must be 16-byte aligned.
+//       Pair with _mm_sfence (see StreamFence) before the data is consumed elsewhere.
+inline void StoreStream(vec3 *dst, const vec3x4 &v)
+{
+#if defined(AAMATH_SSE4)
+    __m128 xy01 = _mm_unpacklo_ps(v.x.m, v.y.m),
+           xy23 = _mm_unpackhi_ps(v.x.m, v.y.m),
+           zx01 = _mm_shuffle_ps(v.z.m, v.x.m, _MM_SHUFFLE(1, 0, 1, 0)),
+           yz1 = _mm_shuffle_ps(v.y.m, v.z.m, _MM_SHUFFLE(1, 1, 1, 1)),
+           zx23 = _mm_shuffle_ps(v.z.m, xy23, _MM_SHUFFLE(2, 2, 2, 2)),
+           yz3 = _mm_shuffle_ps(xy23, v.z.m, _MM_SHUFFLE(3, 3, 3, 3));
+
+    _mm_stream_ps(&dst[0].x, _mm_shuffle_ps(xy01, zx01, _MM_SHUFFLE(3, 0, 1, 0)));
+    _mm_stream_ps(&dst[1].y, _mm_shuffle_ps(yz1, xy23, _MM_SHUFFLE(1, 0, 2, 0)));
+    _mm_stream_ps(&dst[2].z, _mm_shuffle_ps(zx23, yz3, _MM_SHUFFLE(2, 0, 2, 0)));
+#else
+    Store(dst, v);
+#endif
+}
+
+inline void StreamFence()
+{
+#if defined(AAMATH_SSE4)
+    _mm_sfence();
+#endif
+}
+
+// NOTE: Gathers 4 vec3s spaced stride bytes apart (e.g. positions in a vertex buffer)
+inline vec3x4 LoadVec3x4(const void *src, u32 stride)
+{
+    const u8 *at = (const u8 *)src;
+    const vec3 *v0 = (const vec3 *)at,
+               *v1 = (const vec3 *)(at + stride),
+               *v2 = (const vec3 *)(at + 2 * stride),
+               *v3 = (const vec3 *)(at + 3 * stride);
+
+    return Vec3x4(R32x4(v0->x, v1->x, v2->x, v3->x),
+                  R32x4(v0->y, v1->y, v2->y, v3->y),
+                  R32x4(v0->z, v1->z, v2->z, v3->z));
+}
+
+// NOTE: Scatters 4 vec3s spaced stride bytes apart
+inline void Store(void *dst, u32 stride, const vec3x4 &v)
+{
+    u8 *at = (u8 *)dst;
+
+    for(u32 i = 0; i < 4; ++i)
+    {
+        *(vec3 *)(at + i * stride) = Lane(v, i);
+    }
+}
+
+//
+// NOTE: vec3x4 operators
+//
+
+inline vec3x4 operator-(const vec3x4 &v)
+{
+    return Vec3x4(-v.x, -v.y, -v.z);
+}
+
+inline vec3x4 operator+(const vec3x4 &a, const vec3x4 &b)
+{
+    return Vec3x4(a.x + b.x, a.y + b.y, a.z + b.z);
+}
+
+inline vec3x4 operator-(const vec3x4 &a, const vec3x4 &b)
+{
+    return Vec3x4(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+inline vec3x4 operator*(const vec3x4 &a, const r32x4 &b)
+{
+    return Vec3x4(a.x * b, a.y * b, a.z * b);
+}
+
+inline vec3x4 operator*(const r32x4 &a, const vec3x4 &b)
+{
+    return b * a;
+}
+
+inline vec3x4 operator*(const vec3x4 &a, r32 b)
+{
+    return a * R32x4(b);
+}
+
+inline vec3x4 operator*(r32 a, const vec3x4 &b)
+{
+    return b * R32x4(a);
+}
+
+inline vec3x4 operator/(const vec3x4 &a, const r32x4 &b)
+{
+    r32x4 oneOverB = R32x4(1.0f) / b;
+
+    return a * oneOverB;
+}
+
+inline vec3x4 &operator+=(vec3x4 &a, const vec3x4 &b)
+{
+    a = a + b;
+
+    return a;
+}
+
+inline vec3x4 &operator-=(vec3x4 &a, const vec3x4 &b)
+{
+    a = a - b;
+
+    return a;
+}
+
+inline vec3x4 &operator*=(vec3x4 &a, const r32x4 &b)
+{
+    a = a * b;
+
+    return a;
+}
+
+//
+// NOTE: vec3x4 functions
+//
+
+inline vec3x4 Cross(const vec3x4 &a, const vec3x4 &b)
+{
+    return Vec3x4(a.y * b.z - b.y * a.z,
+                  a.z * b.x - b.z * a.x,
+                  a.x * b.y - b.x * a.y);
+}
+
+inline r32x4 Dot(const vec3x4 &a, const vec3x4 &b)
+{
+    return MulAdd(a.z, b.z, MulAdd(a.y, b.y, a.x * b.x));
+}
+
+inline r32x4 DistanceSq(const vec3x4 &a, const vec3x4 &b)
+{
+    vec3x4 d = b - a;
+
+    return Dot(d, d);
+}
+
+inline r32x4 Distance(const vec3x4 &a, const vec3x4 &b)
+{
+    return Sqrt(DistanceSq(a, b));
+}
+
+inline vec3x4 Hadamard(const vec3x4 &a, const vec3x4 &b)
+{
+    return Vec3x4(a.x * b.x, a.y * b.y, a.z * b.z);
+}
+
+inline r32x4 LengthSq(const vec3x4 &v)
+{
+    return Dot(v, v);
+}
+
+inline r32x4 Length(const vec3x4 &v)
+{
+    return Sqrt(LengthSq(v));
+}
+
+// NOTE: Zero length lanes are not guarded, as with the scalar version
+inline vec3x4 Normalized(const vec3x4 &v)
+{
+    return v * InvSqrt(LengthSq(v));
+}
+
+inline void Normalize(vec3x4 &v)
+{
+    v *= InvSqrt(LengthSq(v));
+}
+
+inline vec3x4 Reflect(const vec3x4 &v, const vec3x4 &n)
+{
+    return v - (2.0f * Dot(v, n)) * n;
+}
+
+// NOTE: Total internal reflection lanes return zero
+inline vec3x4 Refract(const vec3x4 &v, const vec3x4 &n, r32 idx)
+{
+    r32x4 ndotv = Dot(n, v);
+    r32x4 k = 1.0f - idx * idx * (1.0f - ndotv * ndotv);
+    r32x4 nMult = idx * ndotv + Sqrt(Max(k, R32x4(0.0f)));
+    vec3x4 r = idx * v - nMult * n;
+    r32x4 valid = k >= R32x4(0.0f);
+
+    return Vec3x4(valid & r.x, valid & r.y, valid & r.z);
+}
+
+// NOTE: A . (B x C)
+inline r32x4 TripleScal(const vec3x4 &a, const vec3x4 &b, const vec3x4 &c)
+{
+    return Dot(a, Cross(b, c));
+}
+
+inline vec3x4 Min(const vec3x4 &a, const vec3x4 &b)
+{
+    return Vec3x4(Min(a.x, b.x), Min(a.y, b.y), Min(a.z, b.z));
+}
+
+inline vec3x4 Max(const vec3x4 &a, const vec3x4 &b)
+{
+    return Vec3x4(Max(a.x, b.x), Max(a.y, b.y), Max(a.z, b.z));
+}
+
+// NOTE: Per lane mask ? a : b
+inline vec3x4 Select(const r32x4 &mask, const vec3x4 &a, const vec3x4 &b)
+{
+    return Vec3x4(Select(mask, a.x, b.x), Select(mask, a.y, b.y), Select(mask, a.z, b.z));
+}
+
+//
+// NOTE: vec3x8
+//
+
+inline vec3x8 Vec3x8(const r32x8 &x, const r32x8 &y, const r32x8 &z)
+{
+    vec3x8 result;
+
+    result.x = x;
+    result.y = y;
+    result.z = z;
+
+    return result;
+}
+
+// NOTE: Same vector in every lane
+inline vec3x8 Vec3x8(const vec3 &v)
+{
+    return Vec3x8(R32x8(v.x), R32x8(v.y), R32x8(v.z));
+}
+
+inline vec3x8 Vec3x8(const vec3x4 &lo, const vec3x4 &hi)
+{
+    return Vec3x8(R32x8(lo.x, hi.x), R32x8(lo.y, hi.y), R32x8(lo.z, hi.z));
+}
+
+// NOTE: Loads 8 consecutive vec3s
+inline vec3x8 LoadVec3x8(const vec3 *src)
+{
+    return Vec3x8(LoadVec3x4(src), LoadVec3x4(src + 4));
+}
+
+// NOTE: Stores 8 consecutive vec3s
+inline void Store(vec3 *dst, const vec3x8 &v)
+{
+    Store(dst, Vec3x4(Low(v.x), Low(v.y), Low(v.z)));
+    Store(dst + 4, Vec3x4(High(v.x), High(v.y), High(v.z)));
+}
+
+inline vec3 Lane(const vec3x8 &v, u32 i)
+{
+    return Vec3(v.x.E[i], v.y.E[i], v.z.E[i]);
+}
+
+// NOTE: Stores 8 consecutive vec3s bypassing the cache, dst must be 16-byte aligned
+inline void StoreStream(vec3 *dst, const vec3x8 &v)
+{
+    StoreStream(dst, Vec3x4(Low(v.x), Low(v.y), Low(v.z)));
+    StoreStream(dst + 4, Vec3x4(High(v.x), High(v.y), High(v.z)));
+}
+
+//
+// NOTE: vec3x8 operators
+//
+
+inline vec3x8 operator-(const vec3x8 &v)
+{
+    return Vec3x8(-v.x, -v.y, -v.z);
+}
+
+inline vec3x8 operator+(const vec3x8 &a, const vec3x8 &b)
+{
+    return Vec3x8(a.x + b.x, a.y + b.y, a.z + b.z);
+}
+
+inline vec3x8 operator-(const vec3x8 &a, const vec3x8 &b)
+{
+    return Vec3x8(a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+inline vec3x8 operator*(const vec3x8 &a, const r32x8 &b)
+{
+    return Vec3x8(a.x * b, a.y * b, a.z * b);
+}
+
+inline vec3x8 operator*(const r32x8 &a, const vec3x8 &b)
+{
+    return b * a;
+}
+
+inline vec3x8 operator*(const vec3x8 &a, r32 b)
+{
+    return a * R32x8(b);
+}
+
+inline vec3x8 operator*(r32 a, const vec3x8 &b)
+{
+    return b * R32x8(a);
+}
+
+inline vec3x8 operator/(const vec3x8 &a, const r32x8 &b)
+{
+    r32x8 oneOverB = R32x8(1.0f) / b;
+
+    return a * oneOverB;
+}
+
+inline vec3x8 &operator+=(vec3x8 &a, const vec3x8 &b)
+{
+    a = a + b;
+
+    return a;
+}
+
+inline vec3x8 &operator-=(vec3x8 &a, const vec3x8 &b)
+{
+    a = a - b;
+
+    return a;
+}
+
+inline vec3x8 &operator*=(vec3x8 &a, const r32x8 &b)
+{
+    a = a * b;
+
+    return a;
+}
+
+//
+// NOTE: vec3x8 functions
+//
+
+inline vec3x8 Cross(const vec3x8 &a, const vec3x8 &b)
+{
+    return Vec3x8(a.y * b.z - b.y * a.z,
+                  a.z * b.x - b.z * a.x,
+                  a.x * b.y - b.x * a.y);
+}
+
+inline r32x8 Dot(const vec3x8 &a, const vec3x8 &b)
+{
+    return MulAdd(a.z, b.z, MulAdd(a.y, b.y, a.x * b.x));
+}
+
+inline r32x8 DistanceSq(const vec3x8 &a, const vec3x8 &b)
+{
+    vec3x8 d = b - a;
+
+    return Dot(d, d);
+}
+
+inline r32x8 Distance(const vec3x8 &a, const vec3x8 &b)
+{
+    return Sqrt(DistanceSq(a, b));
+}
+
+inline vec3x8 Hadamard(const vec3x8 &a, const vec3x8 &b)
+{
+    return Vec3x8(a.x * b.x, a.y * b.y, a.z * b.z);
+}
+
+inline r32x8 LengthSq(const vec3x8 &v)
+{
+    return Dot(v, v);
+}
+
+inline r32x8 Length(const vec3x8 &v)
+{
+    return Sqrt(LengthSq(v));
+}
+
+// NOTE: Zero length lanes are not guarded, as with the scalar version
+inline vec3x8 Normalized(const vec3x8 &v)
+{
+    return v * InvSqrt(LengthSq(v));
+}
+
+inline void Normalize(vec3x8 &v)
+{
+    v *= InvSqrt(LengthSq(v));
+}
+
+inline vec3x8 Reflect(const vec3x8 &v, const vec3x8 &n)
+{
+    return v - (2.0f * Dot(v, n)) * n;
+}
+
+// NOTE: Total internal reflection lanes return zero
+inline vec3x8 Refract(const vec3x8 &v, const vec3x8 &n, r32 idx)
+{
+    r32x8 ndotv = Dot(n, v);
+    r32x8 k = 1.0f - idx * idx * (1.0f - ndotv * ndotv);
+    r32x8 nMult = idx * ndotv + Sqrt(Max(k, R32x8(0.0f)));
+    vec3x8 r = idx * v - nMult * n;
+    r32x8 valid = k >= R32x8(0.0f);
+
+    return Vec3x8(valid & r.x, valid & r.y, valid & r.z);
+}
+
+// NOTE: A . (B x C)
+inline r32x8 TripleScal(const vec3x8 &a, const vec3x8 &b, const vec3x8 &c)
+{
+    return Dot(a, Cross(b, c));
+}
+
+inline vec3x8 Min(const vec3x8 &a, const vec3x8 &b)
+{
+    return Vec3x8(Min(a.x, b.x), Min(a.y, b.y), Min(a.z, b.z));
+}
+
+inline vec3x8 Max(const vec3x8 &a, const vec3x8 &b)
+{
+    return Vec3x8(Max(a.x, b.x), Max(a.y, b.y), Max(a.z, b.z));
+}
+
+// NOTE: Per lane mask ? a : b
+inline vec3x8 Select(const r32x8 &mask, const vec3x8 &a, const vec3x8 &b)
+{
+    return Vec3x8(Select(mask, a.x, b.x), Select(mask, a.y, b.y), Select(mask, a.z, b.z));
+}
+
+//
+// NOTE: vec4x4
+//
+
+inline vec4x4 Vec4x4(const r32x4 &x, const r32x4 &y, const r32x4 &z, const r32x4 &w)
+{
+    vec4x4 result;
+
+    result.x = x;
+    result.y = y;
+    result.z = z;
+    result.w = w;
+
+    return result;
+}
+
+// NOTE: Same vector in every lane
+inline vec4x4 Vec4x4(const vec4 &v)
+{
+    return Vec4x4(R32x4(v.x), R32x4(v.y), R32x4(v.z), R32x4(v.w));
+}
+
+inline vec4x4 Vec4x4(const vec3x4 &v, const r32x4 &w)
+{
+    return Vec4x4(v.x, v.y, v.z, w);
+}
+
+// NOTE: Loads 4 consecutive vec4s
+inline vec4x4 LoadVec4x4(const vec4 *src)
+{
+    vec4x4 result;
+
+#if defined(AAMATH_SSE4)
+    result.x.m = _mm_loadu_ps(src[0].E);
+    result.y.m = _mm_loadu_ps(src[1].E);
+    result.z.m = _mm_loadu_ps(src[2].E);
+    result.w.m = _mm_loadu_ps(src[3].E);
+
+    _MM_TRANSPOSE4_PS(result.x.m, result.y.m, result.z.m, result.w.m);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        result.x.E[i] = src[i].x;
+        result.y.E[i] = src[i].y;
+        result.z.E[i] = src[i].z;
+        result.w.E[i] = src[i].w;
+    }
+#endif
+
+    return result;
+}
+
+// NOTE: Stores 4 consecutive vec4s
+inline void Store(vec4 *dst, const vec4x4 &v)
+{
+#if defined(AAMATH_SSE4)
+    __m128 x = v.x.m,
+           y = v.y.m,
+           z = v.z.m,
+           w = v.w.m;
+
+    _MM_TRANSPOSE4_PS(x, y, z, w);
+
+    _mm_storeu_ps(dst[0].E, x);
+    _mm_storeu_ps(dst[1].E, y);
+    _mm_storeu_ps(dst[2].E, z);
+    _mm_storeu_ps(dst[3].E, w);
+#else
+    for(u32 i = 0; i < 4; ++i)
+    {
+        dst[i].x = v.x.E[i];
+        dst[i].y = v.y.E[i];
+        dst[i].z = v.z.E[i];
+        dst[i].w = v.w.E[i];
+    }
+#endif
+}
+
+inline vec4 Lane(const vec4x4 &v, u32 i)
+{
+    return Vec4(v.x.E[i], v.y.E[i], v.z.E[i], v.w.E[i]);
+}
+
+//
+// NOTE: vec4x4 operators
+//
+
+inline vec4x4 operator-(const vec4x4 &v)
+{
+    return Vec4x4(-v.x, -v.y, -v.z, -v.w);
+}
+
+inline vec4x4 operator+(const vec4x4 &a, const vec4x4 &b)
+{
+    return Vec4x4(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w);
+}
+
+inline vec4x4 operator-(const vec4x4 &a, const vec4x4 &b)
+{
+    return Vec4x4(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w);
+}
+
+inline vec4x4 operator*(const vec4x4 &a, const r32x4 &b)
+{
+    return Vec4x4(a.x * b, a.y * b, a.z * b, a.w * b);
+}
+
+inline vec4x4 operator*(const r32x4 &a, const vec4x4 &b)
+{
+    return b * a;
+}
+
+inline vec4x4 operator*(const vec4x4 &a, r32 b)
+{
+    return a * R32x4(b);
+}
+
+inline vec4x4 operator*(r32 a, const vec4x4 &b)
+{
+    return b * R32x4(a);
+}
+
+inline vec4x4 operator/(const vec4x4 &a, const r32x4 &b)
+{
+    r32x4 oneOverB = R32x4(1.0f) / b;
+
+    return a * oneOverB;
+}
+
+inline vec4x4 &operator+=(vec4x4 &a, const vec4x4 &b)
+{
+    a = a + b;
+
+    return a;
+}
+
+inline vec4x4 &operator-=(vec4x4 &a, const vec4x4 &b)
+{
+    a = a - b;
+
+    return a;
+}
+
+inline vec4x4 &operator*=(vec4x4 &a, const r32x4 &b)
+{
+    a = a * b;
+
+    return a;
+}
+
+//
+// NOTE: vec4x4 functions
+//
+
+// NOTE: xyz only, as with the scalar version
+inline r32x4 Dot(const vec4x4 &a, const vec4x4 &b)
+{
+    return MulAdd(a.z, b.z, MulAdd(a.y, b.y, a.x * b.x));
+}
+
+inline r32x4 DistanceSq(const vec4x4 &a, const vec4x4 &b)
+{
+    vec4x4 d = b - a;
+
+    return Dot(d, d);
+}
+
+inline r32x4 Distance(const vec4x4 &a, const vec4x4 &b)
+{
+    return Sqrt(DistanceSq(a, b));
+}
+
+inline vec4x4 Hadamard(const vec4x4 &a, const vec4x4 &b)
+{
+    return Vec4x4(a.x * b.x, a.y * b.y, a.z * b.z, a.w * b.w);
+}
+
+inline r32x4 LengthSq(const vec4x4 &v)
+{
+    return Dot(v, v);
+}
+
+inline r32x4 Length(const vec4x4 &v)
+{
+    return Sqrt(LengthSq(v));
+}
+
+// NOTE: w is cleared, as with the scalar version
+inline vec4x4 Normalized(const vec4x4 &v)
+{
+    r32x4 oneOverLength = InvSqrt(LengthSq(v));
+
+    return Vec4x4(v.x * oneOverLength, v.y * oneOverLength, v.z * oneOverLength, R32x4(0.0f));
+}
+
+inline void Normalize(vec4x4 &v)
+{
+    v *= InvSqrt(LengthSq(v));
+}
+
+inline vec4x4 Reflect(const vec4x4 &v, const vec4x4 &n)
+{
+    return v - (2.0f * Dot(v, n)) * n;
+}
+
+// NOTE: Total internal reflection lanes return zero
+inline vec4x4 Refract(const vec4x4 &v, const vec4x4 &n, r32 idx)
+{
+    r32x4 ndotv = Dot(n, v);
+    r32x4 k = 1.0f - idx * idx * (1.0f - ndotv * ndotv);
+    r32x4 nMult = idx * ndotv + Sqrt(Max(k, R32x4(0.0f)));
+    vec4x4 r = idx * v - nMult * n;
+    r32x4 valid = k >= R32x4(0.0f);
+
+    return Vec4x4(valid & r.x, valid & r.y, valid & r.z, valid & r.w);
+}
+
+// NOTE: Per lane mask ? a : b
+inline vec4x4 Select(const r32x4 &mask, const vec4x4 &a, const vec4x4 &b)
+{
+    return Vec4x4(Select(mask, a.x, b.x), Select(mask, a.y, b.y),
+                  Select(mask, a.z, b.z), Select(mask, a.w, b.w));
+}
+
+//
+// NOTE: quatx4
+//
+
+inline quatx4 Quatx4(const r32x4 &w, const r32x4 &x, const r32x4 &y, const r32x4 &z)
+{
+    quatx4 result;
+
+    result.w = w;
+    result.x = x;
+    result.y = y;
+    result.z = z;
+
+    return result;
+}
+
+// NOTE: Same quaternion in every lane
+inline quatx4 Quatx4(const quat &q)
+{
+    return Quatx4(R32x4(q.w), R32x4(q.x), R32x4(q.y), R32x4(q.z));
+}
+
+// NOTE: Loads 4 consecutive quats
+inline quatx4 LoadQuatx4(const quat *src)
+{
+    quatx4 result;
+
+    vec4x4 v = LoadVec4x4(&src[0].v);
+
+    // NOTE: quat is stored w, x, y, z
+    result.w = v.x;
+    result.x = v.y;
+    result.y = v.z;
+    result.z = v.w;
+
+    return result;
+}
+
+// NOTE: Stores 4 consecutive quats
+inline void Store(quat *dst, const quatx4 &q)
+{
+    Store(&dst[0].v, Vec4x4(q.w, q.x, q.y, q.z));
+}
+
+// NOTE: Loads the first count (1 to 4) quats, the remaining lanes repeat the last
+inline quatx4 LoadQuatx4(const quat *src, u32 count)
+{
+    AAM_Assert(count > 0);
+
+    if(count >= 4)
+        return LoadQuatx4(src);
+
+    quat lanes[4];
+
+    for(u32 i = 0; i < 4; ++i)
+    {
+        lanes[i] = src[(i < count) ? i : count - 1];
+    }
+
+    return LoadQuatx4(lanes);
+}
+
+// NOTE: Stores the first count (up to 4) lanes
+inline void Store(quat *dst, const quatx4 &q, u32 count)
+{
+    if(count >= 4)
+    {
+        Store(dst, q);
+    }
+    else
+    {
+        quat lanes[4];
+        Store(lanes, q);
+
+        for(u32 i = 0; i < count; ++i)
+        {
+            dst[i] = lanes[i];
+        }
+    }
+}
+
+inline quat Lane(const quatx4 &q, u32 i)
+{
+    return Quat(q.w.E[i], q.x.E[i], q.y.E[i], q.z.E[i]);
+}
+
+//
+// NOTE: quatx4 operators
+//
+
+inline quatx4 operator-(const quatx4 &q)
+{
+    return Quatx4(-q.w, -q.x, -q.y, -q.z);
+}
+
+inline quatx4 operator+(const quatx4 &a, const quatx4 &b)
+{
+    return Quatx4(a.w + b.w, a.x + b.x, a.y + b.y, a.z + b.z);
+}
+
+inline quatx4 operator-(const quatx4 &a, const quatx4 &b)
+{
+    return Quatx4(a.w - b.w, a.x - b.x, a.y - b.y, a.z - b.z);
+}
+
+inline quatx4 operator*(const quatx4 &a, const quatx4 &b)
+{
+    quatx4 result;
+
+    result.w = a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z;
+    result.x = a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y;
+    result.y = a.w * b.y + a.y * b.w + a.z * b.x - a.x * b.z;
+    result.z = a.w * b.z + a.z * b.w + a.x * b.y - a.y * b.x;
+
+    return result;
+}
+
+inline quatx4 operator*(const quatx4 &q, const r32x4 &s)
+{
+    return Quatx4(q.w * s, q.x * s, q.y * s, q.z * s);
+}
+
+inline quatx4 operator*(const r32x4 &s, const quatx4 &q)
+{
+    return q * s;
+}
+
+inline quatx4 &operator*=(quatx4 &a, const quatx4 &b)
+{
+    a = a * b;
+
+    return a;
+}
+
+//
+// NOTE: quatx4 functions
+//
+
+inline quatx4 Conjugate(const quatx4 &q)
+{
+    return Quatx4(q.w, -q.x, -q.y, -q.z);
+}
+
+inline r32x4 Dot(const quatx4 &a, const quatx4 &b)
+{
+    return MulAdd(a.z, b.z, MulAdd(a.y, b.y, MulAdd(a.x, b.x, a.w * b.w)));
+}
+
+inline r32x4 Norm(const quatx4 &q)
+{
+    return Dot(q, q);
+}
+
+inline r32x4 Magnitude(const quatx4 &q)
+{
+    return Sqrt(Norm(q));
+}
+
+// NOTE: Zero lanes stay zero, as with the scalar version
+inline void Normalize(quatx4 &q)
+{
+    r32x4 norm = Norm(q);
+    r32x4 recip = InvSqrt(norm) & (norm > R32x4(EPSILON));
+
+    q = q * recip;
+}
+
+// NOTE: Rotate vector by quaternion
+//       See Essential Math, eq 5.12
+inline vec3x4 Rotate(const quatx4 &q, const vec3x4 &v)
+{
+    vec3x4 result;
+
+    r32x4 vMult = 2.0f * (q.x * v.x + q.y * v.y + q.z * v.z),
+          crossMult = 2.0f * q.w,
+          pMult = crossMult * q.w - 1.0f;
+
+    result.x = pMult * v.x + vMult * q.x + crossMult * (q.y * v.z - q.z * v.y);
+    result.y = pMult * v.y + vMult * q.y + crossMult * (q.z * v.x - q.x * v.z);
+    result.z = pMult * v.z + vMult * q.z + crossMult * (q.x * v.y - q.y * v.x);
+
+    return result;
+}
+
+// NOTE: Per lane mask ? a : b
+inline quatx4 Select(const r32x4 &mask, const quatx4 &a, const quatx4 &b)
+{
+    return Quatx4(Select(mask, a.w, b.w), Select(mask, a.x, b.x),
+                  Select(mask, a.y, b.y), Select(mask, a.z, b.z));
+}
+
+// NOTE: Same as Normalize with ApproxInvSqrt, about 2 ulp off unit length
+inline void ApproxNormalize(quatx4 &q)
+{
+    r32x4 norm = Norm(q);
+    r32x4 recip = ApproxInvSqrt(norm) & (norm > R32x4(EPSILON));
+
+    q = q * recip;
+}
+
+//
+// NOTE: quatx4 interpolation
+//
+
+// NOTE: Negates the start lanes that are not within 90 degrees of end (same
+//       threshold as the scalar versions) by xor-ing the sign bit, no branch.
+//       Returns the cosine between the aligned pairs.
+inline r32x4 AlignHemisphere(quatx4 &start, const quatx4 &end)
+{
+    r32x4 cos = Dot(start, end);
+    r32x4 flip = (cos < R32x4(EPSILON)) & R32x4(-0.0f);
+
+    start.w = start.w ^ flip;
+    start.x = start.x ^ flip;
+    start.y = start.y ^ flip;
+    start.z = start.z ^ flip;
+
+    return cos ^ flip;
+}
+
+// NOTE: Per lane Lerp, not normalised
+inline quatx4 Lerp(const quatx4 &start, const r32x4 &t, const quatx4 &end)
+{
+    quatx4 s = start;
+    AlignHemisphere(s, end);
+
+    return s * (1.0f - t) + end * t;
+}
+
+inline quatx4 Nlerp(const quatx4 &start, const r32x4 &t, const quatx4 &end)
+{
+    quatx4 result = Lerp(start, t, end);
+    Normalize(result);
+
+    return result;
+}
+
+// NOTE: Per lane Slerp. sin(angle) comes from the cosine and the two weights
+//       from one SinCos of t * angle:
+//       sin((1 - t) * angle) / sin(angle) = cos(t * angle) - cos(angle) * sin(t * angle) / sin(angle)
+inline quatx4 Slerp(const quatx4 &start, const r32x4 &t, const quatx4 &end)
+{
+    quatx4 s = start;
+    r32x4 cos = AlignHemisphere(s, end);
+
+    // NOTE: Lanes with the angle close to zero use linear weights
+    r32x4 linear = (1.0f - cos) <= R32x4(EPSILON);
+    r32x4 one = R32x4(1.0f);
+    r32x4 sin = Sqrt(Select(linear, one, (1.0f - cos) * (1.0f + cos)));
+    r32x4 recipSin = one / sin;
+
+    r32x4 st, ct;
+    SinCos(t * Acos(cos), st, ct);
+
+    r32x4 startt = Select(linear, one - t, ct - cos * st * recipSin),
+          endt = Select(linear, t, st * recipSin);
+
+    return s * startt + end * endt;
+}
+
+// NOTE: Per lane ApproxSlerp, not normalised
+inline quatx4 ApproxSlerp(const quatx4 &start, const r32x4 &t, const quatx4 &end)
+{
+    quatx4 s = start;
+    r32x4 cos = AlignHemisphere(s, end);
+
+    r32x4 factor = 1.0f - 0.7878088f * cos;
+    r32x4 k = 0.5069269f * factor * factor;
+    r32x4 tt = t * MulAdd(t, MulAdd(2.0f * k, t, -3.0f * k), 1.0f + k);
+
+    return s * (1.0f - tt) + end * tt;
+}
+
+//
+// NOTE: Batched interpolation over arrays, 4 at a time through quatx4.
+//       t is either per element or shared by the whole batch, and so is the
+//       start rotation. With approxNormalize the results are renormalised
+//       with ApproxInvSqrt.
+//
+
+inline void NlerpBatch(const quat *start, const quat *end, const r32 *t, quat *out, u32 count,
+                       b32 approxNormalize = false)
+{
+    AAM_Assert(start && end && t && out);
+
+    for(u32 i = 0; i < count; i += 4)
+    {
+        u32 n = (count - i < 4) ? count - i : 4;
+        quatx4 q = Lerp(LoadQuatx4(start + i, n), LoadR32x4(t + i, n), LoadQuatx4(end + i, n));
+
+        if(approxNormalize)
+            ApproxNormalize(q);
+        else
+            Normalize(q);
+
+        Store(out + i, q, n);
+    }
+}
+
+inline void NlerpBatch(const quat *start, const quat *end, r32 t, quat *out, u32 count,
+                       b32 approxNormalize = false)
+{
+    AAM_Assert(start && end && out);
+
+    r32x4 tt = R32x4(t);
+
+    for(u32 i = 0; i < count; i += 4)
+    {
+        u32 n = (count - i < 4) ? count - i : 4;
+        quatx4 q = Lerp(LoadQuatx4(start + i, n), tt, LoadQuatx4(end + i, n));
+
+        if(approxNormalize)
+            ApproxNormalize(q);
+        else
+            Normalize(q);
+
+        Store(out + i, q, n);
+    }
+}
+
+inline void SlerpBatch(const quat *start, const quat *end, const r32 *t, quat *out, u32 count)
+{
+    AAM_Assert(start && end && t && out);
+
+    for(u32 i = 0; i < count; i += 4)
+    {
+        u32 n = (count - i < 4) ? count - i : 4;
+
+        Store(out + i, Slerp(LoadQuatx4(start + i, n), LoadR32x4(t + i, n), LoadQuatx4(end + i, n)), n);
+    }
+}
+
+inline void SlerpBatch(const quat *start, const quat *end, r32 t, quat *out, u32 count)
+{
+    AAM_Assert(start && end && out);
+
+    r32x4 tt = R32x4(t);
+
+    for(u32 i = 0; i < count; i += 4)
+    {
+        u32 n = (count - i < 4) ? count - i : 4;
+
+        Store(out + i, Slerp(LoadQuatx4(start + i, n), tt, LoadQuatx4(end + i, n)), n);
+    }
+}
+
+// NOTE: Unlike the scalar ApproxSlerp the results are normalised. The angle
+//       is off by up to about 1e-2 radians for quaternions 90 degrees apart,
+//       1e-3 below 60 degrees
+inline void ApproxSlerpBatch(const quat *start, const quat *end, const r32 *t, quat *out, u32 count,
+                             b32 approxNormalize = false)
+{
+    AAM_Assert(start && end && t && out);
+
+    for(u32 i = 0; i < count; i += 4)
+    {
+        u32 n = (count - i < 4) ? count - i : 4;
+        quatx4 q = ApproxSlerp(LoadQuatx4(start + i, n), LoadR32x4(t + i, n), LoadQuatx4(end + i, n));
+
+        if(approxNormalize)
+            ApproxNormalize(q);
+        else
+            Normalize(q);
+
+        Store(out + i, q, n);
+    }
+}
+
+inline void ApproxSlerpBatch(const quat *start, const quat *end, r32 t, quat *out, u32 count,
+                             b32 approxNormalize = false)
+{
+    AAM_Assert(start && end && out);
+
+    r32x4 tt = R32x4(t);
+
+    for(u32 i = 0; i < count; i += 4)
+    {
+        u32 n = (count - i < 4) ? count - i : 4;
+        quatx4 q = ApproxSlerp(LoadQuatx4(start + i, n), tt, LoadQuatx4(end + i, n));
+
+        if(approxNormalize)
+            ApproxNormalize(q);
+        else
+            Normalize(q);
+
+        Store(out + i, q, n);
+    }
+}
+
+// NOTE: One start rotation to many ends (a pose blending towards several
+//       targets), the start is broadcast once instead of loaded per batch
+
+inline void NlerpBatch(const quat &start, const quat *end, const r32 *t, quat *out, u32 count,
+                       b32 approxNormalize = false)
+{
+    AAM_Assert(end && t && out);
+
+    quatx4 s = Quatx4(start);
+
+    for(u32 i = 0; i < count; i += 4)
+    {
+        u32 n = (count - i < 4) ? count - i : 4;
+        quatx4 q = Lerp(s, LoadR32x4(t + i, n), LoadQuatx4(end + i, n));
+
+        if(approxNormalize)
+            ApproxNormalize(q);
+        else
+            Normalize(q);
+
+        Store(out + i, q, n);
+    }
+}
+
+inline void NlerpBatch(const quat &start, const quat *end, r32 t, quat *out, u32 count,
+                       b32 approxNormalize = false)
+{
+    AAM_Assert(end && out);
+
+    quatx4 s = Quatx4(start);
+    r32x4 tt = R32x4(t);
+
+    for(u32 i = 0; i < count; i += 4)
+    {
+        u32 n = (count - i < 4) ? count - i : 4;
+        quatx4 q = Lerp(s, tt, LoadQuatx4(end + i, n));
+
+        if(approxNormalize)
+            ApproxNormalize(q);
+        else
+            Normalize(q);
+
+        Store(out + i, q, n);
+    }
+}
+
+inline void SlerpBatch(const quat &start, const quat *end, const r32 *t, quat *out, u32 count)
+{
+    AAM_Assert(end && t && out);
+
+    quatx4 s = Quatx4(start);
+
+    for(u32 i = 0; i < count; i += 4)
+    {
+        u32 n = (count - i < 4) ? count - i : 4;
+
+        Store(out + i, Slerp(s, LoadR32x4(t + i, n), LoadQuatx4(end + i, n)), n);
+    }
+}
+
+inline void SlerpBatch(const quat &start, const quat *end, r32 t, quat *out, u32 count)
+{
+    AAM_Assert(end && out);
+
+    quatx4 s = Quatx4(start);
+    r32x4 tt = R32x4(t);
+
+    for(u32 i = 0; i < count; i += 4)
+    {
+        u32 n = (count - i < 4) ? count - i : 4;
+
+        Store(out + i, Slerp(s, tt, LoadQuatx4(end + i, n)), n);
+    }
+}
+
+inline void ApproxSlerpBatch(const quat &start, const quat *end, const r32 *t, quat *out, u32 count,
+                             b32 approxNormalize = false)
+{
+    AAM_Assert(end && t && out);
+
+    quatx4 s = Quatx4(start);
+
+    for(u32 i = 0; i < count; i += 4)
+    {
+        u32 n = (count - i < 4) ? count - i : 4;
+        quatx4 q = ApproxSlerp(s, LoadR32x4(t + i, n), LoadQuatx4(end + i, n));
+
+        if(approxNormalize)
+            ApproxNormalize(q);
+        else
+            Normalize(q);
+
+        Store(out + i, q, n);
+    }
+}
+
+inline void ApproxSlerpBatch(const quat &start, const quat *end, r32 t, quat *out, u32 count,
+                             b32 approxNormalize = false)
+{
+    AAM_Assert(end && out);
+
+    quatx4 s = Quatx4(start);
+    r32x4 tt = R32x4(t);
+
+    for(u32 i = 0; i < count; i += 4)
+    {
+        u32 n = (count - i < 4) ? count - i : 4;
+        quatx4 q = ApproxSlerp(s, tt, LoadQuatx4(end + i, n));
+
+        if(approxNormalize)
+            ApproxNormalize(q);
+        else
+            Normalize(q);
+
+        Store(out + i, q, n);
+    }
+}
+
+} // NOTE: Namespace
+
+#endif